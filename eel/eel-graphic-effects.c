@@ -32,6 +32,16 @@
 
 #include <string.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* The effects below work one row at a time, treating the row as a run
+ * of bytes. Where SSE2 is available 16 bytes (four pixels with alpha)
+ * are done per step and the scalar loop only handles what is left at
+ * the end of the row; 8 bit RGB(A) is the only layout we get here.
+ */
+
 /* shared utility to create a new pixbuf from the passed-in one */
 
 static GdkPixbuf *
@@ -50,27 +60,23 @@ create_new_pixbuf (GdkPixbuf *src)
 			       gdk_pixbuf_get_height (src));
 }
 
-/* utility routine to bump the level of a color component with pinning */
+typedef void (* EffectRowFunc) (const guchar *src,
+				guchar *dest,
+				int n_bytes,
+				int n_channels,
+				gconstpointer data);
 
-static guchar
-lighten_component (guchar cur_value)
-{
-	int new_value = cur_value;
-	new_value += 24 + (new_value >> 3);
-	if (new_value > 255) {
-		new_value = 255;
-	}
-	return (guchar) new_value;
-}
+/* shared utility to run a row function over every row of src */
 
-GdkPixbuf *
-eel_create_spotlight_pixbuf (GdkPixbuf* src)
+static GdkPixbuf *
+apply_row_effect (GdkPixbuf *src,
+		  EffectRowFunc row_func,
+		  gconstpointer data)
 {
 	GdkPixbuf *dest;
-	int i, j;
-	int width, height, has_alpha, src_row_stride, dst_row_stride;
-	guchar *target_pixels, *original_pixels;
-	guchar *pixsrc, *pixdest;
+	int i, n_channels, n_bytes, height, src_row_stride, dest_row_stride;
+	const guchar *original_pixels;
+	guchar *target_pixels;
 
 	g_return_val_if_fail (gdk_pixbuf_get_colorspace (src) == GDK_COLORSPACE_RGB, NULL);
 	g_return_val_if_fail ((!gdk_pixbuf_get_has_alpha (src)
@@ -80,136 +86,363 @@ eel_create_spotlight_pixbuf (GdkPixbuf* src)
 	g_return_val_if_fail (gdk_pixbuf_get_bits_per_sample (src) == 8, NULL);
 
 	dest = create_new_pixbuf (src);
-	
-	has_alpha = gdk_pixbuf_get_has_alpha (src);
-	width = gdk_pixbuf_get_width (src);
+
+	n_channels = gdk_pixbuf_get_n_channels (src);
+	n_bytes = gdk_pixbuf_get_width (src) * n_channels;
 	height = gdk_pixbuf_get_height (src);
-	dst_row_stride = gdk_pixbuf_get_rowstride (dest);
 	src_row_stride = gdk_pixbuf_get_rowstride (src);
-	target_pixels = gdk_pixbuf_get_pixels (dest);
+	dest_row_stride = gdk_pixbuf_get_rowstride (dest);
 	original_pixels = gdk_pixbuf_get_pixels (src);
+	target_pixels = gdk_pixbuf_get_pixels (dest);
 
 	for (i = 0; i < height; i++) {
-		pixdest = target_pixels + i * dst_row_stride;
-		pixsrc = original_pixels + i * src_row_stride;
-		for (j = 0; j < width; j++) {		
-			*pixdest++ = lighten_component (*pixsrc++);
-			*pixdest++ = lighten_component (*pixsrc++);
-			*pixdest++ = lighten_component (*pixsrc++);
-			if (has_alpha) {
-				*pixdest++ = *pixsrc++;
-			}
-		}
+		(* row_func) (original_pixels + i * src_row_stride,
+			      target_pixels + i * dest_row_stride,
+			      n_bytes, n_channels, data);
 	}
+
 	return dest;
 }
 
+/* utility routine to bump the level of a color component with pinning */
+
+static guchar
+lighten_component (guchar cur_value)
+{
+	int new_value = cur_value;
+	new_value += 24 + (new_value >> 3);
+	if (new_value > 255) {
+		new_value = 255;
+	}
+	return (guchar) new_value;
+}
+
+static void
+spotlight_row (const guchar *src,
+	       guchar *dest,
+	       int n_bytes,
+	       int n_channels,
+	       gconstpointer data)
+{
+	const guchar *table;
+	int i;
+
+	table = data;
+	i = 0;
+
+#ifdef __SSE2__
+	{
+		__m128i zero, bump, alpha_mask, pixels, lo, hi, result;
+
+		zero = _mm_setzero_si128 ();
+		bump = _mm_set1_epi16 (24);
+		/* the alpha byte of each pixel is passed through */
+		alpha_mask = n_channels == 4 ?
+			_mm_set_epi8 (-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0) : zero;
+
+		for (; i + 16 <= n_bytes; i += 16) {
+			pixels = _mm_loadu_si128 ((const __m128i *) (src + i));
+			lo = _mm_unpacklo_epi8 (pixels, zero);
+			hi = _mm_unpackhi_epi8 (pixels, zero);
+			lo = _mm_add_epi16 (lo, _mm_add_epi16 (bump, _mm_srli_epi16 (lo, 3)));
+			hi = _mm_add_epi16 (hi, _mm_add_epi16 (bump, _mm_srli_epi16 (hi, 3)));
+			/* packing saturates, which does the pinning */
+			result = _mm_packus_epi16 (lo, hi);
+			result = _mm_or_si128 (_mm_andnot_si128 (alpha_mask, result),
+					       _mm_and_si128 (alpha_mask, pixels));
+			_mm_storeu_si128 ((__m128i *) (dest + i), result);
+		}
+	}
+#endif
+
+	if (n_channels == 3) {
+		for (; i < n_bytes; i++) {
+			dest[i] = table[src[i]];
+		}
+	} else {
+		for (; i < n_bytes; i += 4) {
+			dest[i] = table[src[i]];
+			dest[i + 1] = table[src[i + 1]];
+			dest[i + 2] = table[src[i + 2]];
+			dest[i + 3] = src[i + 3];
+		}
+	}
+}
+
+GdkPixbuf *
+eel_create_spotlight_pixbuf (GdkPixbuf* src)
+{
+	static guchar table[256];
+	static gboolean table_initialized = FALSE;
+	int i;
+
+	if (!table_initialized) {
+		for (i = 0; i < 256; i++) {
+			table[i] = lighten_component (i);
+		}
+		table_initialized = TRUE;
+	}
+
+	return apply_row_effect (src, spotlight_row, table);
+}
+
 
 /* the following routine was stolen from the panel to darken a pixbuf, by manipulating the saturation */
 
+typedef struct {
+	int alpha;
+	int negalpha;
+} DarkenParameters;
+
+static void
+darken_row (const guchar *src,
+	    guchar *dest,
+	    int n_bytes,
+	    int n_channels,
+	    gconstpointer data)
+{
+	const DarkenParameters *parameters;
+	int i, alpha, negalpha;
+	guchar intensity;
+	guchar r, g, b;
+
+	parameters = data;
+	alpha = parameters->alpha;
+	negalpha = parameters->negalpha;
+
+	for (i = 0; i < n_bytes; i += n_channels) {
+		r = src[i];
+		g = src[i + 1];
+		b = src[i + 2];
+		intensity = (r * 77 + g * 150 + b * 28) >> 8;
+		dest[i] = (negalpha * intensity + alpha * r) >> 8;
+		dest[i + 1] = (negalpha * intensity + alpha * g) >> 8;
+		dest[i + 2] = (negalpha * intensity + alpha * b) >> 8;
+		if (n_channels == 4) {
+			dest[i + 3] = src[i + 3];
+		}
+	}
+}
+
 /* saturation is 0-255, darken is 0-255 */
 
 GdkPixbuf *
 eel_create_darkened_pixbuf (GdkPixbuf *src, int saturation, int darken)
 {
-	gint i, j;
-	gint width, height, src_row_stride, dest_row_stride;
-	gboolean has_alpha;
-	guchar *target_pixels, *original_pixels;
-	guchar *pixsrc, *pixdest;
-	guchar intensity;
-	guchar alpha;
-	guchar negalpha;
-	guchar r, g, b;
-	GdkPixbuf *dest;
+	DarkenParameters parameters;
 
-	g_return_val_if_fail (gdk_pixbuf_get_colorspace (src) == GDK_COLORSPACE_RGB, NULL);
-	g_return_val_if_fail ((!gdk_pixbuf_get_has_alpha (src)
-			       && gdk_pixbuf_get_n_channels (src) == 3)
-			      || (gdk_pixbuf_get_has_alpha (src)
-				  && gdk_pixbuf_get_n_channels (src) == 4), NULL);
-	g_return_val_if_fail (gdk_pixbuf_get_bits_per_sample (src) == 8, NULL);
+	parameters.negalpha = ((255 - saturation) * darken) >> 8;
+	parameters.alpha = (saturation * darken) >> 8;
 
-	dest = create_new_pixbuf (src);
+	return apply_row_effect (src, darken_row, &parameters);
+}
 
-	has_alpha = gdk_pixbuf_get_has_alpha (src);
-	width = gdk_pixbuf_get_width (src);
-	height = gdk_pixbuf_get_height (src);
-	dest_row_stride = gdk_pixbuf_get_rowstride (dest);
-	src_row_stride = gdk_pixbuf_get_rowstride (src);
-	target_pixels = gdk_pixbuf_get_pixels (dest);
-	original_pixels = gdk_pixbuf_get_pixels (src);
+/* this routine colorizes the passed-in pixbuf by multiplying each pixel with the passed in color */
 
-	for (i = 0; i < height; i++) {
-		pixdest = target_pixels + i * dest_row_stride;
-		pixsrc = original_pixels + i * src_row_stride;
-		for (j = 0; j < width; j++) {
-			r = *pixsrc++;
-			g = *pixsrc++;
-			b = *pixsrc++;
-			intensity = (r * 77 + g * 150 + b * 28) >> 8;
-			negalpha = ((255 - saturation) * darken) >> 8;
-			alpha = (saturation * darken) >> 8;
-			*pixdest++ = (negalpha * intensity + alpha * r) >> 8;
-			*pixdest++ = (negalpha * intensity + alpha * g) >> 8;
-			*pixdest++ = (negalpha * intensity + alpha * b) >> 8;
-			if (has_alpha) {
-				*pixdest++ = *pixsrc++;
-			}
+typedef struct {
+	int red_value;
+	int green_value;
+	int blue_value;
+	guchar red_table[256];
+	guchar green_table[256];
+	guchar blue_table[256];
+} ColorizeParameters;
+
+static void
+colorize_row (const guchar *src,
+	      guchar *dest,
+	      int n_bytes,
+	      int n_channels,
+	      gconstpointer data)
+{
+	const ColorizeParameters *parameters;
+	int i;
+
+	parameters = data;
+	i = 0;
+
+#ifdef __SSE2__
+	/* Three channel rows don't line up with the vector lanes, but
+	 * icons nearly always have alpha. Multiplying alpha by 256 and
+	 * shifting it back passes it through unchanged.
+	 */
+	if (n_channels == 4) {
+		__m128i zero, factors, pixels, lo, hi;
+
+		zero = _mm_setzero_si128 ();
+		factors = _mm_set_epi16 (256, parameters->blue_value,
+					 parameters->green_value, parameters->red_value,
+					 256, parameters->blue_value,
+					 parameters->green_value, parameters->red_value);
+
+		for (; i + 16 <= n_bytes; i += 16) {
+			pixels = _mm_loadu_si128 ((const __m128i *) (src + i));
+			lo = _mm_unpacklo_epi8 (pixels, zero);
+			hi = _mm_unpackhi_epi8 (pixels, zero);
+			lo = _mm_srli_epi16 (_mm_mullo_epi16 (lo, factors), 8);
+			hi = _mm_srli_epi16 (_mm_mullo_epi16 (hi, factors), 8);
+			_mm_storeu_si128 ((__m128i *) (dest + i), _mm_packus_epi16 (lo, hi));
+		}
+	}
+#endif
+
+	for (; i < n_bytes; i += n_channels) {
+		dest[i] = parameters->red_table[src[i]];
+		dest[i + 1] = parameters->green_table[src[i + 1]];
+		dest[i + 2] = parameters->blue_table[src[i + 2]];
+		if (n_channels == 4) {
+			dest[i + 3] = src[i + 3];
 		}
 	}
-	return dest;
 }
 
-/* this routine colorizes the passed-in pixbuf by multiplying each pixel with the passed in color */
-
 GdkPixbuf *
 eel_create_colorized_pixbuf (GdkPixbuf *src,
 			     GdkRGBA *color)
 {
-	int i, j;
-	int width, height, has_alpha, src_row_stride, dst_row_stride;
-	guchar *target_pixels;
-	guchar *original_pixels;
-	guchar *pixsrc;
-	guchar *pixdest;
+	ColorizeParameters parameters;
+	int i;
+
+	parameters.red_value = eel_round (color->red * 255);
+	parameters.green_value = eel_round (color->green * 255);
+	parameters.blue_value = eel_round (color->blue * 255);
+
+	for (i = 0; i < 256; i++) {
+		parameters.red_table[i] = (i * parameters.red_value) >> 8;
+		parameters.green_table[i] = (i * parameters.green_value) >> 8;
+		parameters.blue_table[i] = (i * parameters.blue_value) >> 8;
+	}
+
+	return apply_row_effect (src, colorize_row, &parameters);
+}
+
+/* The derived pixbufs for prelighting and selection are asked for on
+ * every state change of every icon, while the icons themselves come
+ * from a handful of shared pixbufs. So the results are kept on the
+ * source pixbuf and go away with it.
+ */
+
+#define MAX_COLORIZED_PIXBUFS 2
+
+typedef struct {
+	int red_value;
+	int green_value;
+	int blue_value;
+	GdkPixbuf *pixbuf;
+} ColorizedPixbuf;
+
+static GQuark
+get_spotlight_quark (void)
+{
+	static GQuark quark = 0;
+
+	if (quark == 0) {
+		quark = g_quark_from_static_string ("eel-spotlight-pixbuf");
+	}
+	return quark;
+}
+
+static GQuark
+get_colorized_quark (void)
+{
+	static GQuark quark = 0;
+
+	if (quark == 0) {
+		quark = g_quark_from_static_string ("eel-colorized-pixbufs");
+	}
+	return quark;
+}
+
+static void
+colorized_pixbuf_free (ColorizedPixbuf *colorized)
+{
+	g_object_unref (colorized->pixbuf);
+	g_free (colorized);
+}
+
+static void
+colorized_pixbuf_list_free (GList *list)
+{
+	g_list_free_full (list, (GDestroyNotify) colorized_pixbuf_free);
+}
+
+GdkPixbuf *
+eel_get_spotlight_pixbuf (GdkPixbuf *src)
+{
 	GdkPixbuf *dest;
-	gint red_value, green_value, blue_value;
 
-	g_return_val_if_fail (gdk_pixbuf_get_colorspace (src) == GDK_COLORSPACE_RGB, NULL);
-	g_return_val_if_fail ((!gdk_pixbuf_get_has_alpha (src)
-			       && gdk_pixbuf_get_n_channels (src) == 3)
-			      || (gdk_pixbuf_get_has_alpha (src)
-				  && gdk_pixbuf_get_n_channels (src) == 4), NULL);
-	g_return_val_if_fail (gdk_pixbuf_get_bits_per_sample (src) == 8, NULL);
+	g_return_val_if_fail (GDK_IS_PIXBUF (src), NULL);
+
+	dest = g_object_get_qdata (G_OBJECT (src), get_spotlight_quark ());
+	if (dest == NULL) {
+		dest = eel_create_spotlight_pixbuf (src);
+		if (dest == NULL) {
+			return NULL;
+		}
+		g_object_set_qdata_full (G_OBJECT (src), get_spotlight_quark (),
+					 dest, g_object_unref);
+	}
+
+	return g_object_ref (dest);
+}
+
+GdkPixbuf *
+eel_get_colorized_pixbuf (GdkPixbuf *src,
+			  GdkRGBA *color)
+{
+	GList *list, *l, *last;
+	ColorizedPixbuf *colorized;
+	int red_value, green_value, blue_value;
+
+	g_return_val_if_fail (GDK_IS_PIXBUF (src), NULL);
 
 	red_value = eel_round (color->red * 255);
 	green_value = eel_round (color->green * 255);
-	blue_value = eel_round (color->blue * 255);	
+	blue_value = eel_round (color->blue * 255);
+
+	/* the list is stolen while we change it, so that setting it
+	 * back doesn't free it */
+	list = g_object_steal_qdata (G_OBJECT (src), get_colorized_quark ());
+
+	colorized = NULL;
+	for (l = list; l != NULL; l = l->next) {
+		colorized = l->data;
+		if (colorized->red_value == red_value &&
+		    colorized->green_value == green_value &&
+		    colorized->blue_value == blue_value) {
+			list = g_list_remove_link (list, l);
+			g_list_free_1 (l);
+			break;
+		}
+		colorized = NULL;
+	}
 
-	dest = create_new_pixbuf (src);
-	
-	has_alpha = gdk_pixbuf_get_has_alpha (src);
-	width = gdk_pixbuf_get_width (src);
-	height = gdk_pixbuf_get_height (src);
-	src_row_stride = gdk_pixbuf_get_rowstride (src);
-	dst_row_stride = gdk_pixbuf_get_rowstride (dest);
-	target_pixels = gdk_pixbuf_get_pixels (dest);
-	original_pixels = gdk_pixbuf_get_pixels (src);
+	if (colorized == NULL) {
+		colorized = g_new (ColorizedPixbuf, 1);
+		colorized->red_value = red_value;
+		colorized->green_value = green_value;
+		colorized->blue_value = blue_value;
+		colorized->pixbuf = eel_create_colorized_pixbuf (src, color);
+		if (colorized->pixbuf == NULL) {
+			g_free (colorized);
+			g_object_set_qdata_full (G_OBJECT (src), get_colorized_quark (),
+						 list, (GDestroyNotify) colorized_pixbuf_list_free);
+			return NULL;
+		}
 
-	for (i = 0; i < height; i++) {
-		pixdest = target_pixels + i*dst_row_stride;
-		pixsrc = original_pixels + i*src_row_stride;
-		for (j = 0; j < width; j++) {		
-			*pixdest++ = (*pixsrc++ * red_value) >> 8;
-			*pixdest++ = (*pixsrc++ * green_value) >> 8;
-			*pixdest++ = (*pixsrc++ * blue_value) >> 8;
-			if (has_alpha) {
-				*pixdest++ = *pixsrc++;
-			}
+		if (g_list_length (list) >= MAX_COLORIZED_PIXBUFS) {
+			last = g_list_last (list);
+			colorized_pixbuf_free (last->data);
+			list = g_list_delete_link (list, last);
 		}
 	}
-	return dest;
+
+	/* most recently used first */
+	list = g_list_prepend (list, colorized);
+	g_object_set_qdata_full (G_OBJECT (src), get_colorized_quark (),
+				 list, (GDestroyNotify) colorized_pixbuf_list_free);
+
+	return g_object_ref (colorized->pixbuf);
 }
 
 /* utility to stretch a frame to the desired size */
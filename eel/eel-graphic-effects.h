@@ -40,6 +40,12 @@ GdkPixbuf *eel_create_darkened_pixbuf  (GdkPixbuf *source_pixbuf,
 GdkPixbuf* eel_create_colorized_pixbuf (GdkPixbuf *source_pixbuf,
 					GdkRGBA *color);
 
+/* like the above, but the result is kept with the source pixbuf and
+ * shared by all callers; neither may be modified afterwards */
+GdkPixbuf *eel_get_spotlight_pixbuf    (GdkPixbuf *source_pixbuf);
+GdkPixbuf *eel_get_colorized_pixbuf    (GdkPixbuf *source_pixbuf,
+					GdkRGBA   *color);
+
 /* stretch a image frame */
 GdkPixbuf *eel_stretch_frame_image     (GdkPixbuf *frame_image,
 					int        left_offset,
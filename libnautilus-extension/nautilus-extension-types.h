@@ -57,6 +57,11 @@ typedef enum {
 
 GType nautilus_operation_result_get_type (void);
 
+/* Functions every extension module exports. A module that installs
+ * a "<module name>.nautilus-extension" key file next to itself,
+ * listing the interfaces of its types in the Interfaces key of the
+ * [Nautilus Extension] group, is only loaded when one of those is
+ * needed. */
 void nautilus_module_initialize (GTypeModule  *module);
 void nautilus_module_shutdown   (void);
 void nautilus_module_list_types (const GType **types,
@@ -90,6 +90,35 @@ nautilus_info_provider_cancel_update (NautilusInfoProvider *provider,
 								    handle);
 }
 
+gboolean
+nautilus_info_provider_can_batch (NautilusInfoProvider *provider)
+{
+	g_return_val_if_fail (NAUTILUS_IS_INFO_PROVIDER (provider), FALSE);
+
+	return NAUTILUS_INFO_PROVIDER_GET_IFACE (provider)->update_file_info_batch != NULL;
+}
+
+/* files is a list of NautilusFileInfo. The provider calls
+ * update_complete once, when it is done with all of them.
+ */
+NautilusOperationResult 
+nautilus_info_provider_update_file_info_batch (NautilusInfoProvider *provider,
+					       GList *files,
+					       GClosure *update_complete,
+					       NautilusOperationHandle **handle)
+{
+	g_return_val_if_fail (NAUTILUS_IS_INFO_PROVIDER (provider),
+			      NAUTILUS_OPERATION_FAILED);
+	g_return_val_if_fail (NAUTILUS_INFO_PROVIDER_GET_IFACE (provider)->update_file_info_batch != NULL,
+			      NAUTILUS_OPERATION_FAILED);
+	g_return_val_if_fail (update_complete != NULL, 
+			      NAUTILUS_OPERATION_FAILED);
+	g_return_val_if_fail (handle != NULL, NAUTILUS_OPERATION_FAILED);
+
+	return NAUTILUS_INFO_PROVIDER_GET_IFACE (provider)->update_file_info_batch 
+		(provider, files, update_complete, handle);
+}
+
 void
 nautilus_info_provider_update_complete_invoke (GClosure *update_complete,
 					       NautilusInfoProvider *provider,
@@ -25,7 +25,11 @@
 /* This interface is implemented by Nautilus extensions that want to 
  * provide information about files.  Extensions are called when Nautilus 
  * needs information about a file.  They are passed a NautilusFileInfo 
- * object which should be filled with relevant information */
+ * object which should be filled with relevant information.
+ *
+ * Extensions that look files up in an external index can also implement
+ * update_file_info_batch, which is passed a list of NautilusFileInfo
+ * objects from the same directory so they can all be answered at once. */
 
 #ifndef NAUTILUS_INFO_PROVIDER_H
 #define NAUTILUS_INFO_PROVIDER_H
@@ -58,6 +62,12 @@ struct _NautilusInfoProviderIface {
 						     NautilusOperationHandle **handle);
 	void                    (*cancel_update)    (NautilusInfoProvider     *provider,
 						     NautilusOperationHandle  *handle);
+
+	/* Optional. update_file_info is still used when this is NULL. */
+	NautilusOperationResult (*update_file_info_batch) (NautilusInfoProvider     *provider,
+							   GList                    *files,
+							   GClosure                 *update_complete,
+							   NautilusOperationHandle **handle);
 };
 
 /* Interface Functions */
@@ -68,6 +78,11 @@ NautilusOperationResult nautilus_info_provider_update_file_info       (NautilusI
 								       NautilusOperationHandle **handle);
 void                    nautilus_info_provider_cancel_update          (NautilusInfoProvider     *provider,
 								       NautilusOperationHandle  *handle);
+gboolean                nautilus_info_provider_can_batch              (NautilusInfoProvider     *provider);
+NautilusOperationResult nautilus_info_provider_update_file_info_batch (NautilusInfoProvider     *provider,
+								       GList                    *files,
+								       GClosure                 *update_complete,
+								       NautilusOperationHandle **handle);
 
 
 
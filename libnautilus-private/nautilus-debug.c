@@ -49,6 +49,7 @@ static GDebugKey keys[] = {
   { "Previewer", NAUTILUS_DEBUG_PREVIEWER },
   { "Smclient", NAUTILUS_DEBUG_SMCLIENT },
   { "Window", NAUTILUS_DEBUG_WINDOW },
+  { "Modules", NAUTILUS_DEBUG_MODULES },
   { 0, }
 };
 
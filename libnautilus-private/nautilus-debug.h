@@ -46,6 +46,7 @@ typedef enum {
   NAUTILUS_DEBUG_PREVIEWER = 1 << 11,
   NAUTILUS_DEBUG_SMCLIENT = 1 << 12,
   NAUTILUS_DEBUG_WINDOW = 1 << 13,
+  NAUTILUS_DEBUG_MODULES = 1 << 14,
 } DebugFlags;
 
 void nautilus_debug_set_flags (DebugFlags flags);
@@ -24,15 +24,19 @@
 
 #include <config.h>
 
+#include "nautilus-directory-count-cache.h"
 #include "nautilus-directory-notify.h"
 #include "nautilus-directory-private.h"
 #include "nautilus-file-attributes.h"
 #include "nautilus-file-private.h"
 #include "nautilus-file-utilities.h"
+#include "nautilus-filesystem-info.h"
 #include "nautilus-signaller.h"
+#include "nautilus-thumbnails.h"
 #include "nautilus-global-preferences.h"
 #include "nautilus-link.h"
 #include "nautilus-marshal.h"
+#include "nautilus-trace.h"
 #include <eel/eel-glib-extensions.h>
 #include <gtk/gtk.h>
 #include <libxml/parser.h>
@@ -56,14 +60,51 @@
 
 #define DIRECTORY_LOAD_ITEMS_PER_CALLBACK 100
 
+/* When more new files than this show up in a directory at once, list
+ * the directory again instead of querying each file, which costs a
+ * round trip per file on network mounts.
+ */
+#define NEW_FILES_ENUMERATE_THRESHOLD 64
+
 /* Keep async. jobs down to this number for all directories. */
 #define MAX_ASYNC_JOBS 10
 
+/* Number of update_file_info calls a single info provider may have
+ * outstanding in one directory. All of them together count as one
+ * async. job.
+ */
+#define MAX_EXTENSION_INFO_JOBS_PER_PROVIDER 4
+
+/* Give up on an info provider that hasn't answered in this time. */
+#define EXTENSION_INFO_TIMEOUT_SECONDS 30
+
+/* Most files handed to one update_file_info_batch call. */
+#define MAX_EXTENSION_INFO_BATCH_SIZE 1000
+
+/* Most queued files looked at when gathering one batch. */
+#define MAX_EXTENSION_INFO_BATCH_SCAN (4 * MAX_EXTENSION_INFO_BATCH_SIZE)
+
+/* Number of thumbnails a directory reads and decodes in parallel.
+ * All of them together count as one async. job.
+ */
+#define MAX_THUMBNAIL_LOADS 6
+
+/* Number of text files a directory reads the top left text of in
+ * parallel. All of them together count as one async. job.
+ */
+#define MAX_TOP_LEFT_READS 4
+
 struct TopLeftTextReadState {
 	NautilusDirectory *directory;
 	NautilusFile *file;
 	gboolean large;
 	GCancellable *cancellable;
+	GFile *location;
+
+	/* Filled in by the reading thread. */
+	char *contents;
+	gsize length;
+	gboolean success;
 };
 
 struct LinkInfoReadState {
@@ -76,8 +117,16 @@ struct ThumbnailState {
 	NautilusDirectory *directory;
 	GCancellable *cancellable;
 	NautilusFile *file;
-	gboolean trying_original;
 	gboolean tried_original;
+	gboolean from_cache;
+	time_t mtime; /* of the file, for the thumbnail cache */
+	int size;
+
+	/* Only these are used by the loading thread. */
+	GFile *original_location; /* NULL unless the original is wanted */
+	char *thumbnail_path;
+	GdkPixbuf *pixbuf;
+	GList *mipmaps;
 };
 
 struct MountState {
@@ -88,10 +137,20 @@ struct MountState {
 
 struct FilesystemInfoState {
 	NautilusDirectory *directory;
-	GCancellable *cancellable;
 	NautilusFile *file;
 };
 
+struct ExtensionInfoState {
+	NautilusDirectory *directory;
+	GList *files; /* more than one for update_file_info_batch */
+	GList *provider_files; /* reffed copy given to a batch provider */
+	NautilusInfoProvider *provider;
+	NautilusOperationHandle *handle;
+	NautilusOperationResult result;
+	guint idle_id;
+	guint timeout_id;
+};
+
 struct DirectoryLoadState {
 	NautilusDirectory *directory;
 	GCancellable *cancellable;
@@ -118,6 +177,11 @@ struct NewFilesState {
 	NautilusDirectory *directory;
 	GCancellable *cancellable;
 	int count;
+
+	/* Only used when listing the directory */
+	GHashTable *names;
+	GList *locations;
+	GFileEnumerator *enumerator;
 };
 
 struct DirectoryCountState {
@@ -126,6 +190,9 @@ struct DirectoryCountState {
 	GCancellable *cancellable;
 	GFileEnumerator *enumerator;
 	int file_count;
+	time_t mtime;
+	gboolean show_hidden;
+	gboolean has_dot_hidden;
 };
 
 struct DeepCountState {
@@ -161,13 +228,6 @@ typedef struct {
 	Request request;
 } Monitor;
 
-typedef struct {
-	NautilusDirectory *directory;
-	NautilusInfoProvider *provider;
-	NautilusOperationHandle *handle;
-	NautilusOperationResult result;
-} InfoProviderResponse;
-
 typedef gboolean (* RequestCheck) (Request);
 typedef gboolean (* FileCheck) (NautilusFile *);
 
@@ -203,6 +263,9 @@ static void     move_file_to_extension_queue                  (NautilusDirectory
 							       NautilusFile           *file);
 static void     nautilus_directory_invalidate_file_attributes (NautilusDirectory      *directory,
 							       NautilusFileAttributes  file_attributes);
+static void     extension_info_running_remove                 (NautilusDirectory      *directory,
+							       NautilusFile           *file,
+							       NautilusInfoProvider   *provider);
 
 void
 nautilus_set_kde_trash_name (const char *trash_dir)
@@ -396,6 +459,10 @@ async_job_start (NautilusDirectory *directory,
 #endif	
 
 	async_job_count += 1;
+
+	NAUTILUS_TRACE_ASYNC_BEGIN ("async-job", job, directory);
+	NAUTILUS_TRACE_COUNTER ("async jobs", NULL, async_job_count);
+
 	return TRUE;
 }
 
@@ -434,6 +501,9 @@ async_job_end (NautilusDirectory *directory,
 #endif
 
 	async_job_count -= 1;
+
+	NAUTILUS_TRACE_ASYNC_END ("async-job", job, directory);
+	NAUTILUS_TRACE_COUNTER ("async jobs", NULL, async_job_count);
 }
 
 /* Helper to get one value from a hash table. */
@@ -522,18 +592,32 @@ mime_list_cancel (NautilusDirectory *directory)
 	}
 }
 
+/* The reading thread can't be stopped right away, so its state is
+ * left for top_left_read_callback to free.
+ */
 static void
-top_left_cancel (NautilusDirectory *directory)
+top_left_cancel_one (NautilusDirectory *directory,
+		     TopLeftTextReadState *state)
 {
-	if (directory->details->top_left_read_state != NULL) {
-		g_cancellable_cancel (directory->details->top_left_read_state->cancellable);
-		directory->details->top_left_read_state->directory = NULL;
-		directory->details->top_left_read_state = NULL;
-		
+	g_cancellable_cancel (state->cancellable);
+	state->directory = NULL;
+
+	directory->details->top_left_read_states =
+		g_list_remove (directory->details->top_left_read_states, state);
+	if (directory->details->top_left_read_states == NULL) {
 		async_job_end (directory, "top left");
 	}
 }
 
+static void
+top_left_cancel (NautilusDirectory *directory)
+{
+	while (directory->details->top_left_read_states != NULL) {
+		top_left_cancel_one (directory,
+				     directory->details->top_left_read_states->data);
+	}
+}
+
 static void
 link_info_cancel (NautilusDirectory *directory)
 {
@@ -546,16 +630,57 @@ link_info_cancel (NautilusDirectory *directory)
 }
 
 static void
-thumbnail_cancel (NautilusDirectory *directory)
+thumbnail_state_free (ThumbnailState *state)
+{
+	if (state->cancellable != NULL) {
+		g_object_unref (state->cancellable);
+	}
+	if (state->original_location != NULL) {
+		g_object_unref (state->original_location);
+	}
+	g_free (state->thumbnail_path);
+	if (state->pixbuf != NULL) {
+		g_object_unref (state->pixbuf);
+	}
+	g_list_free_full (state->mipmaps, g_object_unref);
+	g_free (state);
+}
+
+/* The loading thread can't be stopped right away, so its state is
+ * left for thumbnail_load_callback to free.
+ */
+static void
+thumbnail_cancel_one (NautilusDirectory *directory,
+		      ThumbnailState *state)
 {
-	if (directory->details->thumbnail_state != NULL) {
-		g_cancellable_cancel (directory->details->thumbnail_state->cancellable);
-		directory->details->thumbnail_state->directory = NULL;
-		directory->details->thumbnail_state = NULL;
+	g_cancellable_cancel (state->cancellable);
+	state->directory = NULL;
+
+	directory->details->thumbnail_states =
+		g_list_remove (directory->details->thumbnail_states, state);
+	directory->details->thumbnail_load_count--;
+	if (directory->details->thumbnail_states == NULL) {
 		async_job_end (directory, "thumbnail");
 	}
 }
 
+static void
+thumbnail_cancel (NautilusDirectory *directory)
+{
+	while (directory->details->thumbnail_states != NULL) {
+		thumbnail_cancel_one (directory,
+				      directory->details->thumbnail_states->data);
+	}
+
+	if (directory->details->thumbnails_loaded_idle_id != 0) {
+		g_source_remove (directory->details->thumbnails_loaded_idle_id);
+		directory->details->thumbnails_loaded_idle_id = 0;
+	}
+	g_list_free_full (directory->details->thumbnails_loaded,
+			  (GDestroyNotify) thumbnail_state_free);
+	directory->details->thumbnails_loaded = NULL;
+}
+
 static void
 mount_cancel (NautilusDirectory *directory)
 {
@@ -834,7 +959,7 @@ show_hidden_files_changed_callback (gpointer callback_data)
 }
 
 static gboolean
-should_skip_file (NautilusDirectory *directory, GFileInfo *info)
+get_show_hidden_files (void)
 {
 	static gboolean show_hidden_files_changed_callback_installed = FALSE;
 
@@ -851,7 +976,13 @@ should_skip_file (NautilusDirectory *directory, GFileInfo *info)
 		show_hidden_files_changed_callback (NULL);
 	}
 
-	if (!show_hidden_files &&
+	return show_hidden_files;
+}
+
+static gboolean
+should_skip_file (NautilusDirectory *directory, GFileInfo *info)
+{
+	if (!get_show_hidden_files () &&
 	    (g_file_info_get_is_hidden (info) ||
 	     g_file_info_get_is_backup (info) ||
 	     (directory != NULL && directory->details->hidden_file_hash != NULL &&
@@ -874,6 +1005,7 @@ dequeue_pending_idle_callback (gpointer callback_data)
 	GFileInfo *file_info;
 	const char *mimetype, *name;
 	DirectoryLoadState *dir_load_state;
+	gint64 trace_start;
 
 	directory = NAUTILUS_DIRECTORY (callback_data);
 
@@ -881,10 +1013,15 @@ dequeue_pending_idle_callback (gpointer callback_data)
 
 	directory->details->dequeue_pending_idle_id = 0;
 
+	NAUTILUS_TRACE_BEGIN (trace_start);
+
 	/* Handle the files in the order we saw them. */
 	pending_file_info = g_list_reverse (directory->details->pending_file_info);
 	directory->details->pending_file_info = NULL;
 
+	NAUTILUS_TRACE_COUNTER ("dequeue batch size", directory,
+				g_list_length (pending_file_info));
+
 	/* If we are no longer monitoring, then throw away these. */
 	if (!nautilus_directory_is_file_list_monitored (directory)) {
 		nautilus_directory_async_state_changed (directory);
@@ -1005,6 +1142,8 @@ dequeue_pending_idle_callback (gpointer callback_data)
 	/* Get the state machine running again. */
 	nautilus_directory_async_state_changed (directory);
 
+	NAUTILUS_TRACE_END ("directory", "dequeue pending", trace_start, NULL);
+
 	nautilus_directory_unref (directory);
 	return FALSE;
 }
@@ -1453,6 +1592,13 @@ new_files_state_unref (NewFilesState *state)
 					       state);
 		}
 		
+		if (state->names != NULL) {
+			g_hash_table_destroy (state->names);
+		}
+		g_list_free_full (state->locations, g_object_unref);
+		if (state->enumerator != NULL) {
+			g_object_unref (state->enumerator);
+		}
 		g_object_unref (state->cancellable);
 		g_free (state);
 	}
@@ -1489,23 +1635,13 @@ new_files_callback (GObject *source_object,
 	nautilus_directory_unref (directory);
 }
 
-void
-nautilus_directory_get_info_for_new_files (NautilusDirectory *directory,
-					   GList *location_list)
+static void
+query_new_files (NewFilesState *state,
+		 GList *location_list)
 {
-	NewFilesState *state;
 	GFile *location;
 	GList *l;
 
-	if (location_list == NULL) {
-		return;
-	}
-	
-	state = g_new (NewFilesState, 1);
-	state->directory = directory;
-	state->cancellable = g_cancellable_new ();
-	state->count = 0;
-	
 	for (l = location_list; l != NULL; l = l->next) {
 		location = l->data;
 		
@@ -1518,6 +1654,127 @@ nautilus_directory_get_info_for_new_files (NautilusDirectory *directory,
 					 state->cancellable,
 					 new_files_callback, state);
 	}
+}
+
+static void
+new_files_more_files_callback (GObject *source_object,
+			       GAsyncResult *res,
+			       gpointer user_data)
+{
+	NautilusDirectory *directory;
+	NewFilesState *state;
+	GFileInfo *info;
+	GList *files, *l;
+	const char *name;
+
+	state = user_data;
+
+	if (state->directory == NULL) {
+		/* Operation was cancelled. Bail out */
+		new_files_state_unref (state);
+		return;
+	}
+
+	directory = nautilus_directory_ref (state->directory);
+
+	files = g_file_enumerator_next_files_finish (state->enumerator, res, NULL);
+
+	for (l = files; l != NULL; l = l->next) {
+		info = l->data;
+		name = g_file_info_get_name (info);
+
+		/* Besides the files we were asked about, pick up any
+		 * others we missed in a directory we know all of.
+		 */
+		if (name != NULL &&
+		    (g_hash_table_lookup_extended (state->names, name, NULL, NULL) ||
+		     (directory->details->directory_loaded &&
+		      nautilus_directory_find_file_by_name (directory, name) == NULL))) {
+			directory_load_one (directory, info);
+		}
+		g_object_unref (info);
+	}
+
+	if (files != NULL) {
+		g_list_free (files);
+		g_file_enumerator_next_files_async (state->enumerator,
+						    DIRECTORY_LOAD_ITEMS_PER_CALLBACK,
+						    G_PRIORITY_DEFAULT,
+						    state->cancellable,
+						    new_files_more_files_callback,
+						    state);
+	} else {
+		new_files_state_unref (state);
+	}
+
+	nautilus_directory_unref (directory);
+}
+
+static void
+new_files_enumerate_callback (GObject *source_object,
+			      GAsyncResult *res,
+			      gpointer user_data)
+{
+	NewFilesState *state;
+
+	state = user_data;
+
+	if (state->directory == NULL) {
+		/* Operation was cancelled. Bail out */
+		new_files_state_unref (state);
+		return;
+	}
+
+	state->enumerator = g_file_enumerate_children_finish (G_FILE (source_object),
+							      res, NULL);
+	if (state->enumerator == NULL) {
+		/* Can't list it, so ask for each file after all */
+		query_new_files (state, state->locations);
+		new_files_state_unref (state);
+		return;
+	}
+
+	g_file_enumerator_next_files_async (state->enumerator,
+					    DIRECTORY_LOAD_ITEMS_PER_CALLBACK,
+					    G_PRIORITY_DEFAULT,
+					    state->cancellable,
+					    new_files_more_files_callback,
+					    state);
+}
+
+void
+nautilus_directory_get_info_for_new_files (NautilusDirectory *directory,
+					   GList *location_list)
+{
+	NewFilesState *state;
+	GList *l;
+
+	if (location_list == NULL) {
+		return;
+	}
+	
+	state = g_new0 (NewFilesState, 1);
+	state->directory = directory;
+	state->cancellable = g_cancellable_new ();
+	state->count = 0;
+
+	if (g_list_length (location_list) > NEW_FILES_ENUMERATE_THRESHOLD) {
+		state->names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+		for (l = location_list; l != NULL; l = l->next) {
+			g_hash_table_insert (state->names, g_file_get_basename (l->data), NULL);
+		}
+		state->locations = eel_g_object_list_copy (location_list);
+
+		state->count++;
+		g_file_enumerate_children_async (directory->details->location,
+						 NAUTILUS_FILE_DEFAULT_ATTRIBUTES,
+						 0,
+						 G_PRIORITY_DEFAULT,
+						 state->cancellable,
+						 new_files_enumerate_callback, state);
+	} else {
+		query_new_files (state, location_list);
+	}
 	
 	directory->details->new_files_in_progress
 		= g_list_prepend (directory->details->new_files_in_progress,
@@ -1585,25 +1842,51 @@ nautilus_async_destroying_file (NautilusFile *file)
 		directory->details->get_info_file = NULL;
 		changed = TRUE;
 	}
-	if (directory->details->top_left_read_state != NULL
-	    && directory->details->top_left_read_state->file == file) {
-		directory->details->top_left_read_state->file = NULL;
-		changed = TRUE;
+	for (node = directory->details->top_left_read_states;
+	     node != NULL; node = node->next) {
+		TopLeftTextReadState *state;
+
+		state = node->data;
+		if (state->file == file) {
+			state->file = NULL;
+			changed = TRUE;
+		}
 	}
 	if (directory->details->link_info_read_state != NULL &&
 	    directory->details->link_info_read_state->file == file) {
 		directory->details->link_info_read_state->file = NULL;
 		changed = TRUE;
 	}
-	if (directory->details->extension_info_file == file) {
-		directory->details->extension_info_file = NULL;
-		changed = TRUE;
+	for (node = directory->details->extension_info_in_progress;
+	     node != NULL; node = node->next) {
+		ExtensionInfoState *state;
+
+		state = node->data;
+		if (g_list_find (state->files, file) != NULL) {
+			state->files = g_list_remove (state->files, file);
+			extension_info_running_remove (directory, file, state->provider);
+			changed = TRUE;
+		}
 	}
 
-	if (directory->details->thumbnail_state != NULL &&
-	    directory->details->thumbnail_state->file ==  file) {
-		directory->details->thumbnail_state->file = NULL;
-		changed = TRUE;
+	for (node = directory->details->thumbnail_states;
+	     node != NULL; node = node->next) {
+		ThumbnailState *state;
+
+		state = node->data;
+		if (state->file == file) {
+			state->file = NULL;
+			changed = TRUE;
+		}
+	}
+	for (node = directory->details->thumbnails_loaded;
+	     node != NULL; node = node->next) {
+		ThumbnailState *state;
+
+		state = node->data;
+		if (state->file == file) {
+			state->file = NULL;
+		}
 	}
 	
 	if (directory->details->mount_state != NULL &&
@@ -2253,6 +2536,9 @@ void
 nautilus_file_invalidate_count_and_mime_list (NautilusFile *file)
 {
 	NautilusFileAttributes attributes;
+
+	nautilus_directory_count_cache_remove (eel_ref_str_peek (file->details->filesystem_id),
+					       file->details->inode);
 	
 	attributes = NAUTILUS_FILE_ATTRIBUTE_DIRECTORY_ITEM_COUNT |
 		NAUTILUS_FILE_ATTRIBUTE_DIRECTORY_ITEM_MIME_TYPES;
@@ -2420,6 +2706,19 @@ count_non_skipped_files (GList *list)
 	return count;
 }
 
+static gboolean
+has_dot_hidden_file (GList *list)
+{
+	GList *node;
+
+	for (node = list; node != NULL; node = node->next) {
+		if (g_strcmp0 (g_file_info_get_name (node->data), ".hidden") == 0) {
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
 static void
 count_children_done (NautilusDirectory *directory,
 		     NautilusFile *count_file,
@@ -2500,8 +2799,25 @@ count_more_files_callback (GObject *source_object,
 						     res, &error);
 
 	state->file_count += count_non_skipped_files (files);
+	if (!state->has_dot_hidden) {
+		state->has_dot_hidden = has_dot_hidden_file (files);
+	}
 	
 	if (files == NULL) {
+		/* Editing .hidden in place doesn't change the mtime of
+		 * the directory, so with hidden files not shown the
+		 * count can't be trusted later.
+		 */
+		if (state->has_dot_hidden && !state->show_hidden) {
+			nautilus_directory_count_cache_remove (eel_ref_str_peek (state->count_file->details->filesystem_id),
+							       state->count_file->details->inode);
+		} else {
+			nautilus_directory_count_cache_insert (eel_ref_str_peek (state->count_file->details->filesystem_id),
+							       state->count_file->details->inode,
+							       state->mtime,
+							       state->show_hidden,
+							       state->file_count);
+		}
 		count_children_done (directory, state->count_file,
 				     TRUE, state->file_count);
 		directory_count_state_free (state);
@@ -2575,6 +2891,7 @@ directory_count_start (NautilusDirectory *directory,
 {
 	DirectoryCountState *state;
 	GFile *location;
+	guint count;
 
 	if (directory->details->count_in_progress != NULL) {
 		*doing_io = TRUE;
@@ -2597,6 +2914,24 @@ directory_count_start (NautilusDirectory *directory,
 		return;
 	}
 
+	/* A directory that hasn't changed since it was last counted,
+	 * maybe in an earlier session, needn't be listed again.
+	 */
+	if (nautilus_directory_count_cache_lookup (eel_ref_str_peek (file->details->filesystem_id),
+						   file->details->inode,
+						   file->details->mtime,
+						   get_show_hidden_files (),
+						   &count)) {
+		file->details->directory_count_is_up_to_date = TRUE;
+		file->details->directory_count_failed = FALSE;
+		file->details->got_directory_count = TRUE;
+		file->details->directory_count = count;
+
+		nautilus_file_changed (file);
+		nautilus_directory_async_state_changed (directory);
+		return;
+	}
+
 	if (!async_job_start (directory, "directory count")) {
 		return;
 	}
@@ -2606,6 +2941,8 @@ directory_count_start (NautilusDirectory *directory,
 	state->count_file = file;
 	state->directory = nautilus_directory_ref (directory);
 	state->cancellable = g_cancellable_new ();
+	state->mtime = file->details->mtime;
+	state->show_hidden = get_show_hidden_files ();
 	
 	directory->details->count_in_progress = state;
 	
@@ -3207,10 +3544,16 @@ mime_list_start (NautilusDirectory *directory,
 static void
 top_left_stop (NautilusDirectory *directory)
 {
+	GList *node, *next;
+	TopLeftTextReadState *state;
 	NautilusFile *file;
 
-	if (directory->details->top_left_read_state != NULL) {
-		file = directory->details->top_left_read_state->file;
+	for (node = directory->details->top_left_read_states;
+	     node != NULL; node = next) {
+		next = node->next;
+		state = node->data;
+
+		file = state->file;
 		if (file != NULL) {
 			g_assert (NAUTILUS_IS_FILE (file));
 			g_assert (file->details->directory == directory);
@@ -3220,19 +3563,39 @@ top_left_stop (NautilusDirectory *directory)
 			    is_needy (file,
 				      lacks_large_top_left,
 				      REQUEST_LARGE_TOP_LEFT_TEXT)) {
-				return;
+				continue;
 			}
 		}
 
 		/* The top left is not wanted, so stop it. */
-		top_left_cancel (directory);
+		top_left_cancel_one (directory, state);
 	}
 }
 
+static gboolean
+top_left_is_reading (NautilusDirectory *directory,
+		     NautilusFile *file)
+{
+	GList *node;
+	TopLeftTextReadState *state;
+
+	for (node = directory->details->top_left_read_states;
+	     node != NULL; node = node->next) {
+		state = node->data;
+		if (state->file == file) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
 static void
 top_left_read_state_free (TopLeftTextReadState *state)
 {
 	g_object_unref (state->cancellable);
+	g_object_unref (state->location);
+	g_free (state->contents);
 	g_free (state);
 }
 
@@ -3244,8 +3607,6 @@ top_left_read_callback (GObject *source_object,
 	TopLeftTextReadState *state;
 	NautilusDirectory *directory;
 	NautilusFileDetails *file_details;
-	gsize file_size;
-	char *file_contents;
 
 	state = callback_data;
 
@@ -3256,30 +3617,31 @@ top_left_read_callback (GObject *source_object,
 	}
 	
 	directory = nautilus_directory_ref (state->directory);
-	
-	file_details = state->file->details;
-
-	file_details->top_left_text_is_up_to_date = TRUE;
-	g_free (file_details->top_left_text);
-
-	if (g_file_load_partial_contents_finish (G_FILE (source_object),
-						 res,
-						 &file_contents, &file_size,
-						 NULL, NULL)) {
-		file_details->top_left_text = nautilus_extract_top_left_text (file_contents, state->large, file_size);
-		file_details->got_top_left_text = TRUE;
-		file_details->got_large_top_left_text = state->large;
-		g_free (file_contents);
-	} else {
-		file_details->top_left_text = NULL;
-		file_details->got_top_left_text = FALSE;
-		file_details->got_large_top_left_text = FALSE;
+
+	directory->details->top_left_read_states =
+		g_list_remove (directory->details->top_left_read_states, state);
+	if (directory->details->top_left_read_states == NULL) {
+		async_job_end (directory, "top left");
 	}
 
-	nautilus_file_changed (state->file);
+	if (state->file != NULL) {
+		file_details = state->file->details;
+
+		file_details->top_left_text_is_up_to_date = TRUE;
+		g_free (file_details->top_left_text);
+
+		if (state->success) {
+			file_details->top_left_text = nautilus_extract_top_left_text (state->contents, state->large, state->length);
+			file_details->got_top_left_text = TRUE;
+			file_details->got_large_top_left_text = state->large;
+		} else {
+			file_details->top_left_text = NULL;
+			file_details->got_top_left_text = FALSE;
+			file_details->got_large_top_left_text = FALSE;
+		}
 
-	directory->details->top_left_read_state = NULL;
-	async_job_end (directory, "top left");
+		nautilus_file_changed (state->file);
+	}
 
 	top_left_read_state_free (state);
 	
@@ -3288,35 +3650,38 @@ top_left_read_callback (GObject *source_object,
 	nautilus_directory_unref (directory);
 }
 
-static int
-count_lines (const char *text, int length)
+/* Read no more of the file than nautilus_extract_top_left_text can
+ * use, in one go instead of in chunks from the main loop.
+ */
+static void
+top_left_read_thread (GSimpleAsyncResult *res,
+		      GObject *object,
+		      GCancellable *cancellable)
 {
-	int count, i;
+	TopLeftTextReadState *state;
+	GFileInputStream *stream;
+	gsize max_bytes;
 
-	count = 0;
-	for (i = 0; i < length; i++) {
-		count += *text++ == '\n';
+	state = g_simple_async_result_get_op_res_gpointer (res);
+
+	stream = g_file_read (state->location, cancellable, NULL);
+	if (stream == NULL) {
+		return;
 	}
-	return count;
-}
 
-static gboolean
-top_left_read_more_callback (const char *file_contents,
-			     goffset bytes_read,
-			     gpointer callback_data)
-{
-	TopLeftTextReadState *state;
-
-	state = callback_data;
-
-	/* Stop reading when we have enough. */
 	if (state->large) {
-		return bytes_read < NAUTILUS_FILE_LARGE_TOP_LEFT_TEXT_MAXIMUM_BYTES &&
-			count_lines (file_contents, bytes_read) <= NAUTILUS_FILE_LARGE_TOP_LEFT_TEXT_MAXIMUM_LINES;
+		max_bytes = NAUTILUS_FILE_LARGE_TOP_LEFT_TEXT_MAXIMUM_BYTES;
 	} else {
-		return bytes_read < NAUTILUS_FILE_TOP_LEFT_TEXT_MAXIMUM_BYTES &&
-			count_lines (file_contents, bytes_read) <= NAUTILUS_FILE_TOP_LEFT_TEXT_MAXIMUM_LINES;
+		max_bytes = NAUTILUS_FILE_TOP_LEFT_TEXT_MAXIMUM_BYTES;
 	}
+	state->contents = g_malloc (max_bytes);
+	state->success = g_input_stream_read_all (G_INPUT_STREAM (stream),
+						  state->contents, max_bytes,
+						  &state->length,
+						  cancellable, NULL);
+
+	g_input_stream_close (G_INPUT_STREAM (stream), NULL, NULL);
+	g_object_unref (stream);
 }
 
 static void
@@ -3324,15 +3689,10 @@ top_left_start (NautilusDirectory *directory,
 		NautilusFile *file,
 		gboolean *doing_io)
 {
-	GFile *location;
 	gboolean needs_large;
 	TopLeftTextReadState *state;
+	GSimpleAsyncResult *res;
 
-	if (directory->details->top_left_read_state != NULL) {
- 		*doing_io = TRUE;
-		return;
-	}
-	
 	needs_large = FALSE;
 
 	if (is_needy (file,
@@ -3348,7 +3708,13 @@ top_left_start (NautilusDirectory *directory,
 			REQUEST_TOP_LEFT_TEXT))) {
 		return;
 	}
-	*doing_io = TRUE;
+
+	/* The file can move on in the queue while it is read, so
+	 * that the following ones are read in parallel.
+	 */
+	if (top_left_is_reading (directory, file)) {
+		return;
+	}
 
 	if (!nautilus_file_contains_text (file)) {
 		g_free (file->details->top_left_text);
@@ -3358,10 +3724,18 @@ top_left_start (NautilusDirectory *directory,
 		file->details->top_left_text_is_up_to_date = TRUE;
 
 		nautilus_directory_async_state_changed (directory);
+		*doing_io = TRUE;
 		return;
 	}
 
-	if (!async_job_start (directory, "top left")) {
+	if (g_list_length (directory->details->top_left_read_states) >= MAX_TOP_LEFT_READS) {
+		*doing_io = TRUE;
+		return;
+	}
+
+	if (directory->details->top_left_read_states == NULL &&
+	    !async_job_start (directory, "top left")) {
+		*doing_io = TRUE;
 		return;
 	}
 
@@ -3371,16 +3745,21 @@ top_left_start (NautilusDirectory *directory,
 	state->cancellable = g_cancellable_new ();
 	state->large = needs_large;
 	state->file = file;
+	state->location = nautilus_file_get_location (file);
 
-	directory->details->top_left_read_state = state;
+	directory->details->top_left_read_states =
+		g_list_prepend (directory->details->top_left_read_states, state);
 
-	location = nautilus_file_get_location (file);
-	g_file_load_partial_contents_async (location,
-					    state->cancellable,
-					    top_left_read_more_callback,
-					    top_left_read_callback,
-					    state);
-	g_object_unref (location);
+	res = g_simple_async_result_new (NULL,
+					 top_left_read_callback,
+					 state,
+					 top_left_start);
+	g_simple_async_result_set_op_res_gpointer (res, state, NULL);
+	g_simple_async_result_run_in_thread (res,
+					     top_left_read_thread,
+					     G_PRIORITY_DEFAULT,
+					     state->cancellable);
+	g_object_unref (res);
 }
 
 static void
@@ -3768,6 +4147,7 @@ static void
 thumbnail_done (NautilusDirectory *directory,
 		NautilusFile *file,
 		GdkPixbuf *pixbuf,
+		GList *mipmaps,
 		gboolean tried_original)
 {
 	const char *thumb_mtime_str;
@@ -3775,10 +4155,7 @@ thumbnail_done (NautilusDirectory *directory,
 	
 	file->details->thumbnail_is_up_to_date = TRUE;
 	file->details->thumbnail_tried_original  = tried_original;
-	if (file->details->thumbnail) {
-		g_object_unref (file->details->thumbnail);
-		file->details->thumbnail = NULL;
-	}
+	nautilus_file_set_thumbnail (file, NULL, NULL);
 	if (pixbuf) {
 		if (tried_original) {
 			thumb_mtime = file->details->mtime;
@@ -3791,7 +4168,7 @@ thumbnail_done (NautilusDirectory *directory,
 		
 		if (thumb_mtime == 0 ||
 		    thumb_mtime == file->details->mtime) {
-			file->details->thumbnail = g_object_ref (pixbuf);
+			nautilus_file_set_thumbnail (file, pixbuf, mipmaps);
 			file->details->thumbnail_mtime = thumb_mtime;
 		} else {
 			g_free (file->details->thumbnail_path);
@@ -3805,51 +4182,131 @@ thumbnail_done (NautilusDirectory *directory,
 static void
 thumbnail_stop (NautilusDirectory *directory)
 {
+	GList *node, *next;
+	ThumbnailState *state;
 	NautilusFile *file;
 
-	if (directory->details->thumbnail_state != NULL) {
-		file = directory->details->thumbnail_state->file;
+	for (node = directory->details->thumbnail_states;
+	     node != NULL; node = next) {
+		next = node->next;
+		state = node->data;
 
+		file = state->file;
 		if (file != NULL) {
 			g_assert (NAUTILUS_IS_FILE (file));
 			g_assert (file->details->directory == directory);
 			if (is_needy (file,
 				      lacks_thumbnail,
 				      REQUEST_THUMBNAIL)) {
-				return;
+				continue;
 			}
 		}
 
-		/* The link info is not wanted, so stop it. */
-		thumbnail_cancel (directory);
+		/* The thumbnail is not wanted, so stop it. */
+		thumbnail_cancel_one (directory, state);
 	}
 }
 
-static void
-thumbnail_got_pixbuf (NautilusDirectory *directory,
-		      NautilusFile *file,
-		      GdkPixbuf *pixbuf,
-		      gboolean tried_original)
+static gboolean
+thumbnail_is_loading (NautilusDirectory *directory,
+		      NautilusFile *file)
 {
-	nautilus_directory_ref (directory);
+	GList *node;
+	ThumbnailState *state;
 
-	nautilus_file_ref (file);
-	thumbnail_done (directory, file, pixbuf, tried_original);
-	nautilus_file_changed (file);
-	nautilus_file_unref (file);
-	
-	if (pixbuf) {
-		g_object_unref (pixbuf);
+	for (node = directory->details->thumbnail_states;
+	     node != NULL; node = node->next) {
+		state = node->data;
+		if (state->file == file) {
+			return TRUE;
+		}
+	}
+	for (node = directory->details->thumbnails_loaded;
+	     node != NULL; node = node->next) {
+		state = node->data;
+		if (state->file == file) {
+			return TRUE;
+		}
 	}
 
-	nautilus_directory_unref (directory);
+	return FALSE;
 }
 
-static void
-thumbnail_state_free (ThumbnailState *state)
+/* Hand all thumbnails that finished loading since the last time to
+ * their files, and send one change notification for the lot.
+ */
+static gboolean
+thumbnails_loaded_idle_callback (gpointer callback_data)
 {
-	g_object_unref (state->cancellable);
-	g_free (state);
+	NautilusDirectory *directory;
+	GList *loaded, *node, *changed_files;
+	ThumbnailState *state;
+	NautilusFile *file;
+
+	directory = NAUTILUS_DIRECTORY (callback_data);
+	nautilus_directory_ref (directory);
+
+	directory->details->thumbnails_loaded_idle_id = 0;
+	loaded = g_list_reverse (directory->details->thumbnails_loaded);
+	directory->details->thumbnails_loaded = NULL;
+
+	NAUTILUS_TRACE_COUNTER ("thumbnail batch size", directory,
+				g_list_length (loaded));
+
+	/* The states are no longer in thumbnails_loaded, so
+	 * nautilus_async_destroying_file () can't clear their files, and
+	 * the ready callbacks run by thumbnail_done () can drop the last
+	 * ref on any of them.
+	 */
+	for (node = loaded; node != NULL; node = node->next) {
+		state = node->data;
+		if (state->file != NULL) {
+			nautilus_file_ref (state->file);
+		}
+	}
+
+	changed_files = NULL;
+	for (node = loaded; node != NULL; node = node->next) {
+		state = node->data;
+		file = state->file;
+		if (file == NULL) {
+			continue;
+		}
+
+		thumbnail_done (directory, file, state->pixbuf, state->mipmaps,
+				state->tried_original);
+		if (!state->from_cache &&
+		    state->pixbuf != NULL &&
+		    file->details->thumbnail == state->pixbuf &&
+		    file->details->mtime == state->mtime) {
+			nautilus_thumbnail_cache_insert (state->thumbnail_path,
+							 state->mtime,
+							 state->size,
+							 state->pixbuf);
+		}
+		if (nautilus_file_is_self_owned (file)) {
+			nautilus_file_changed (file);
+		} else {
+			changed_files = g_list_prepend (changed_files,
+							nautilus_file_ref (file));
+		}
+	}
+
+	changed_files = g_list_reverse (changed_files);
+	nautilus_directory_emit_change_signals (directory, changed_files);
+	nautilus_file_list_free (changed_files);
+
+	for (node = loaded; node != NULL; node = node->next) {
+		state = node->data;
+		if (state->file != NULL) {
+			nautilus_file_unref (state->file);
+		}
+	}
+	g_list_free_full (loaded, (GDestroyNotify) thumbnail_state_free);
+
+	nautilus_directory_unref (directory);
+
+	return FALSE;
 }
 
 extern int cached_thumbnail_size;
@@ -3866,8 +4323,11 @@ thumbnail_loader_size_prepared (GdkPixbufLoader *loader,
 
 	aspect_ratio = ((double) width) / height;
 
-	/* cf. nautilus_file_get_icon() */
-	max_thumbnail_size = NAUTILUS_ICON_SIZE_LARGEST * cached_thumbnail_size / NAUTILUS_ICON_SIZE_STANDARD;
+	/* cf. nautilus_file_get_icon(). The size is passed in, as this
+	 * runs in the loading thread and the preference may change
+	 * meanwhile.
+	 */
+	max_thumbnail_size = NAUTILUS_ICON_SIZE_LARGEST * GPOINTER_TO_INT (user_data) / NAUTILUS_ICON_SIZE_STANDARD;
 	if (MAX (width, height) > max_thumbnail_size) {
 		if (width > height) {
 			width = max_thumbnail_size;
@@ -3883,7 +4343,8 @@ thumbnail_loader_size_prepared (GdkPixbufLoader *loader,
 
 static GdkPixbuf *
 get_pixbuf_for_content (goffset file_len,
-			char *file_contents)
+			char *file_contents,
+			int thumbnail_size)
 {
 	gboolean res;
 	GdkPixbuf *pixbuf, *pixbuf2;
@@ -3894,7 +4355,7 @@ get_pixbuf_for_content (goffset file_len,
 	loader = gdk_pixbuf_loader_new ();
 	g_signal_connect (loader, "size-prepared",
 			  G_CALLBACK (thumbnail_loader_size_prepared),
-			  NULL);
+			  GINT_TO_POINTER (thumbnail_size));
 
 	/* For some reason we have to write in chunks, or gdk-pixbuf fails */
 	res = TRUE;
@@ -3921,18 +4382,79 @@ get_pixbuf_for_content (goffset file_len,
 }
 
 
+static GdkPixbuf *
+load_pixbuf_for_location (GFile *location,
+			  int thumbnail_size,
+			  GCancellable *cancellable)
+{
+	char *file_contents;
+	gsize file_size;
+	GdkPixbuf *pixbuf;
+
+	if (!g_file_load_contents (location, cancellable,
+				   &file_contents, &file_size,
+				   NULL, NULL)) {
+		return NULL;
+	}
+
+	pixbuf = get_pixbuf_for_content (file_size, file_contents, thumbnail_size);
+	g_free (file_contents);
+
+	return pixbuf;
+}
+
+/* Runs in a thread: reads and decodes the thumbnail, or the original
+ * image if that's wanted and the thumbnail otherwise, and makes the
+ * smaller versions used for drawing it at the different zoom levels.
+ */
+static void
+thumbnail_load_thread (GSimpleAsyncResult *res,
+		       GObject *object,
+		       GCancellable *cancellable)
+{
+	ThumbnailState *state;
+	GFile *location;
+
+	state = g_simple_async_result_get_op_res_gpointer (res);
+
+	if (state->original_location != NULL) {
+		state->pixbuf = load_pixbuf_for_location (state->original_location,
+							  state->size,
+							  cancellable);
+	}
+
+	if (state->pixbuf == NULL &&
+	    !g_cancellable_is_cancelled (cancellable)) {
+		location = g_file_new_for_path (state->thumbnail_path);
+		state->pixbuf = load_pixbuf_for_location (location, state->size, cancellable);
+		g_object_unref (location);
+	}
+
+	if (state->pixbuf != NULL &&
+	    !g_cancellable_is_cancelled (cancellable)) {
+		state->mipmaps = nautilus_thumbnail_make_mipmaps (state->pixbuf);
+	}
+}
+
 static void
-thumbnail_read_callback (GObject *source_object,
+thumbnail_add_loaded (NautilusDirectory *directory,
+		      ThumbnailState *state)
+{
+	directory->details->thumbnails_loaded =
+		g_list_prepend (directory->details->thumbnails_loaded, state);
+	if (directory->details->thumbnails_loaded_idle_id == 0) {
+		directory->details->thumbnails_loaded_idle_id =
+			g_idle_add (thumbnails_loaded_idle_callback, directory);
+	}
+}
+
+static void
+thumbnail_load_callback (GObject *source_object,
 			 GAsyncResult *res,
 			 gpointer user_data)
 {
 	ThumbnailState *state;
-	gsize file_size;
-	char *file_contents;
-	gboolean result;
 	NautilusDirectory *directory;
-	GdkPixbuf *pixbuf;
-	GFile *location;
 
 	state = user_data;
 
@@ -3942,38 +4464,19 @@ thumbnail_read_callback (GObject *source_object,
 		return;
 	}
 
-	directory = nautilus_directory_ref (state->directory);
-
-	result = g_file_load_contents_finish (G_FILE (source_object),
-					      res,
-					      &file_contents, &file_size,
-					      NULL, NULL);
+	directory = state->directory;
 
-	pixbuf = NULL;
-	if (result) {
-		pixbuf = get_pixbuf_for_content (file_size, file_contents);
-		g_free (file_contents);
+	directory->details->thumbnail_states =
+		g_list_remove (directory->details->thumbnail_states, state);
+	directory->details->thumbnail_load_count--;
+	if (directory->details->thumbnail_states == NULL) {
+		async_job_end (directory, "thumbnail");
 	}
-	
-	if (pixbuf == NULL && state->trying_original) {
-		state->trying_original = FALSE;
 
-		location = g_file_new_for_path (state->file->details->thumbnail_path);
-		g_file_load_contents_async (location,
-					    state->cancellable,
-					    thumbnail_read_callback,
-					    state);
-		g_object_unref (location);
-	} else {
-		state->directory->details->thumbnail_state = NULL;
-		async_job_end (state->directory, "thumbnail");
-		
-		thumbnail_got_pixbuf (state->directory, state->file, pixbuf, state->tried_original);
-	
-		thumbnail_state_free (state);
-	}
-	
-	nautilus_directory_unref (directory);
+	thumbnail_add_loaded (directory, state);
+
+	/* Let the next thumbnails start loading. */
+	nautilus_directory_async_state_changed (directory);
 }
 
 static void
@@ -3981,22 +4484,50 @@ thumbnail_start (NautilusDirectory *directory,
 		 NautilusFile *file,
 		 gboolean *doing_io)
 {
-	GFile *location;
 	ThumbnailState *state;
-
-	if (directory->details->thumbnail_state != NULL) {
-		*doing_io = TRUE;
-		return;
-	}
+	GSimpleAsyncResult *res;
+	GdkPixbuf *pixbuf;
 
 	if (!is_needy (file,
 		       lacks_thumbnail,
 		       REQUEST_THUMBNAIL)) {
 		return;
 	}
-	*doing_io = TRUE;
 
-	if (!async_job_start (directory, "thumbnail")) {
+	/* The file can move on in the queue while its thumbnail
+	 * loads, so that the following ones load in parallel.
+	 */
+	if (thumbnail_is_loading (directory, file)) {
+		return;
+	}
+
+	/* A thumbnail decoded earlier for another NautilusFile of the
+	 * same file is handed over without any I/O.
+	 */
+	pixbuf = nautilus_thumbnail_cache_lookup (file->details->thumbnail_path,
+						  file->details->mtime,
+						  cached_thumbnail_size);
+	if (pixbuf != NULL) {
+		state = g_new0 (ThumbnailState, 1);
+		state->directory = directory;
+		state->file = file;
+		state->tried_original = file->details->thumbnail_wants_original;
+		state->from_cache = TRUE;
+		state->thumbnail_path = g_strdup (file->details->thumbnail_path);
+		state->pixbuf = pixbuf;
+
+		thumbnail_add_loaded (directory, state);
+		return;
+	}
+
+	if (directory->details->thumbnail_load_count >= MAX_THUMBNAIL_LOADS) {
+		*doing_io = TRUE;
+		return;
+	}
+
+	if (directory->details->thumbnail_states == NULL &&
+	    !async_job_start (directory, "thumbnail")) {
+		*doing_io = TRUE;
 		return;
 	}
 	
@@ -4004,22 +4535,29 @@ thumbnail_start (NautilusDirectory *directory,
 	state->directory = directory;
 	state->file = file;
 	state->cancellable = g_cancellable_new ();
+	state->mtime = file->details->mtime;
+	state->size = cached_thumbnail_size;
+	state->thumbnail_path = g_strdup (file->details->thumbnail_path);
 
 	if (file->details->thumbnail_wants_original) {
 		state->tried_original = TRUE;
-		state->trying_original = TRUE;
-		location = nautilus_file_get_location (file);
-	} else {
-		location = g_file_new_for_path (file->details->thumbnail_path);
+		state->original_location = nautilus_file_get_location (file);
 	}
 	
-	directory->details->thumbnail_state = state;
-
-	g_file_load_contents_async (location,
-				    state->cancellable,
-				    thumbnail_read_callback,
-				    state);
-	g_object_unref (location);
+	directory->details->thumbnail_states =
+		g_list_prepend (directory->details->thumbnail_states, state);
+	directory->details->thumbnail_load_count++;
+
+	res = g_simple_async_result_new (NULL,
+					 thumbnail_load_callback,
+					 state,
+					 thumbnail_start);
+	g_simple_async_result_set_op_res_gpointer (res, state, NULL);
+	g_simple_async_result_run_in_thread (res,
+					     thumbnail_load_thread,
+					     G_PRIORITY_DEFAULT,
+					     state->cancellable);
+	g_object_unref (res);
 }
 
 static void
@@ -4214,7 +4752,6 @@ static void
 filesystem_info_cancel (NautilusDirectory *directory)
 {
 	if (directory->details->filesystem_info_state != NULL) {
-		g_cancellable_cancel (directory->details->filesystem_info_state->cancellable);
 		directory->details->filesystem_info_state->directory = NULL;
 		directory->details->filesystem_info_state = NULL;
 		async_job_end (directory, "filesystem info");
@@ -4247,7 +4784,6 @@ filesystem_info_stop (NautilusDirectory *directory)
 static void
 filesystem_info_state_free (FilesystemInfoState *state)
 {
-	g_object_unref (state->cancellable);
 	g_free (state);
 }
 
@@ -4285,11 +4821,9 @@ got_filesystem_info (FilesystemInfoState *state, GFileInfo *info)
 }
 
 static void
-query_filesystem_info_callback (GObject *source_object,
-				GAsyncResult *res,
+query_filesystem_info_callback (GFileInfo *info,
 				gpointer user_data)
 {
-	GFileInfo *info;
 	FilesystemInfoState *state;
 
 	state = user_data;
@@ -4299,13 +4833,7 @@ query_filesystem_info_callback (GObject *source_object,
 		return;
 	}
 
-	info = g_file_query_filesystem_info_finish (G_FILE (source_object), res, NULL);
-
 	got_filesystem_info (state, info);
-
-	if (info != NULL) {
-		g_object_unref (info);
-	}
 }
 
 static void
@@ -4335,63 +4863,229 @@ filesystem_info_start (NautilusDirectory *directory,
 	state = g_new0 (FilesystemInfoState, 1);
 	state->directory = directory;
 	state->file = file;
-	state->cancellable = g_cancellable_new ();
 
 	location = nautilus_file_get_location (file);
 	
 	directory->details->filesystem_info_state = state;
 
-	g_file_query_filesystem_info_async (location,
-					    G_FILE_ATTRIBUTE_FILESYSTEM_READONLY ","
-					    G_FILE_ATTRIBUTE_FILESYSTEM_USE_PREVIEW,
-					    G_PRIORITY_DEFAULT,
-					    state->cancellable, 
-					    query_filesystem_info_callback, 
-					    state);
+	nautilus_filesystem_info_query_async (location,
+					      query_filesystem_info_callback,
+					      state);
 	g_object_unref (location);
 }
 
+/* The providers running for each file, so that checking whether one
+ * is doesn't need to look through every running state.
+ */
 static void
-extension_info_cancel (NautilusDirectory *directory)
+extension_info_running_add (NautilusDirectory *directory,
+			    NautilusFile *file,
+			    NautilusInfoProvider *provider)
 {
-	if (directory->details->extension_info_in_progress != NULL) {
-		if (directory->details->extension_info_idle) {
-			g_source_remove (directory->details->extension_info_idle);
-		} else {
-			nautilus_info_provider_cancel_update 
-				(directory->details->extension_info_provider,
-				 directory->details->extension_info_in_progress);
-		}
+	GList *providers;
 
-		directory->details->extension_info_in_progress = NULL;
-		directory->details->extension_info_file = NULL;
-		directory->details->extension_info_provider = NULL;
-		directory->details->extension_info_idle = 0;
+	if (directory->details->extension_info_running == NULL) {
+		directory->details->extension_info_running =
+			g_hash_table_new_full (g_direct_hash, g_direct_equal,
+					       NULL, (GDestroyNotify) g_list_free);
+	}
 
+	providers = g_hash_table_lookup (directory->details->extension_info_running, file);
+	g_hash_table_steal (directory->details->extension_info_running, file);
+	g_hash_table_insert (directory->details->extension_info_running, file,
+			     g_list_prepend (providers, provider));
+}
+
+static void
+extension_info_running_remove (NautilusDirectory *directory,
+			       NautilusFile *file,
+			       NautilusInfoProvider *provider)
+{
+	GList *providers;
+
+	if (directory->details->extension_info_running == NULL) {
+		return;
+	}
+
+	providers = g_hash_table_lookup (directory->details->extension_info_running, file);
+	g_hash_table_steal (directory->details->extension_info_running, file);
+	providers = g_list_remove (providers, provider);
+	if (providers != NULL) {
+		g_hash_table_insert (directory->details->extension_info_running, file,
+				     providers);
+	}
+}
+
+static gboolean
+extension_info_is_running (NautilusDirectory *directory,
+			   NautilusFile *file,
+			   NautilusInfoProvider *provider)
+{
+	GList *providers;
+
+	if (directory->details->extension_info_running == NULL) {
+		return FALSE;
+	}
+
+	providers = g_hash_table_lookup (directory->details->extension_info_running, file);
+	return g_list_find (providers, provider) != NULL;
+}
+
+/* Takes the files out of the state, which no longer runs for them. */
+static GList *
+extension_info_state_take_files (NautilusDirectory *directory,
+				 ExtensionInfoState *state)
+{
+	GList *files, *node;
+
+	files = state->files;
+	state->files = NULL;
+	for (node = files; node != NULL; node = node->next) {
+		extension_info_running_remove (directory, node->data, state->provider);
+	}
+
+	return files;
+}
+
+static void
+extension_info_state_free (ExtensionInfoState *state)
+{
+	if (state->idle_id != 0) {
+		g_source_remove (state->idle_id);
+	}
+	if (state->timeout_id != 0) {
+		g_source_remove (state->timeout_id);
+	}
+	g_list_free (state->files);
+	nautilus_file_list_free (state->provider_files);
+	g_free (state);
+}
+
+/* Take one state out of the in progress list, ending the directory's
+ * extension info job if it was the last one.
+ */
+static void
+extension_info_state_remove (NautilusDirectory *directory,
+			     ExtensionInfoState *state)
+{
+	g_list_free (extension_info_state_take_files (directory, state));
+
+	directory->details->extension_info_in_progress =
+		g_list_remove (directory->details->extension_info_in_progress, state);
+
+	if (directory->details->extension_info_in_progress == NULL) {
 		async_job_end (directory, "extension info");
 	}
+
+	/* Last, as this may drop the last ref on a file. */
+	extension_info_state_free (state);
+}
+
+static void
+extension_info_cancel_one (NautilusDirectory *directory,
+			   ExtensionInfoState *state)
+{
+	/* Once the response is queued the provider is done with
+	 * the handle, so there is nothing left to cancel.
+	 */
+	if (state->idle_id == 0) {
+		nautilus_info_provider_cancel_update (state->provider,
+						      state->handle);
+	}
+
+	extension_info_state_remove (directory, state);
+}
+
+static void
+extension_info_cancel (NautilusDirectory *directory)
+{
+	while (directory->details->extension_info_in_progress != NULL) {
+		extension_info_cancel_one
+			(directory, directory->details->extension_info_in_progress->data);
+	}
 }
 	
+static gboolean
+extension_info_is_wanted (NautilusDirectory *directory,
+			  ExtensionInfoState *state)
+{
+	GList *node;
+	NautilusFile *file;
+
+	for (node = state->files; node != NULL; node = node->next) {
+		file = node->data;
+		g_assert (NAUTILUS_IS_FILE (file));
+		g_assert (file->details->directory == directory);
+		if (is_needy (file, lacks_extension_info, REQUEST_EXTENSION_INFO)) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
 static void
 extension_info_stop (NautilusDirectory *directory)
 {
-	if (directory->details->extension_info_in_progress != NULL) {
-		NautilusFile *file;
+	GList *node, *next;
+	ExtensionInfoState *state;
 
-		file = directory->details->extension_info_file;
-		if (file != NULL) {
-			g_assert (NAUTILUS_IS_FILE (file));
-			g_assert (file->details->directory == directory);
-			if (is_needy (file, lacks_extension_info, REQUEST_EXTENSION_INFO)) {
-				return;
-			}
+	for (node = directory->details->extension_info_in_progress;
+	     node != NULL; node = next) {
+		next = node->next;
+		state = node->data;
+
+		/* Batches keep going as long as any of their files
+		 * still need the info.
+		 */
+		if (extension_info_is_wanted (directory, state)) {
+			continue;
 		}
 
 		/* The info is not wanted, so stop it. */
-		extension_info_cancel (directory);
+		extension_info_cancel_one (directory, state);
 	}
 }
 
+static ExtensionInfoState *
+extension_info_find (NautilusDirectory *directory,
+		     NautilusInfoProvider *provider,
+		     NautilusOperationHandle *handle)
+{
+	GList *node;
+	ExtensionInfoState *state;
+
+	for (node = directory->details->extension_info_in_progress;
+	     node != NULL; node = node->next) {
+		state = node->data;
+		if (state->provider == provider && state->handle == handle) {
+			return state;
+		}
+	}
+
+	return NULL;
+}
+
+static int
+extension_info_count_for_provider (NautilusDirectory *directory,
+				   NautilusInfoProvider *provider)
+{
+	GList *node;
+	ExtensionInfoState *state;
+	int count;
+
+	count = 0;
+	for (node = directory->details->extension_info_in_progress;
+	     node != NULL; node = node->next) {
+		state = node->data;
+		if (state->provider == provider) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
 static void
 finish_info_provider (NautilusDirectory *directory,
 		      NautilusFile *file,
@@ -4409,32 +5103,75 @@ finish_info_provider (NautilusDirectory *directory,
 	}
 }
 
+static void
+finish_info_provider_for_files (NautilusDirectory *directory,
+				GList *files,
+				NautilusInfoProvider *provider)
+{
+	GList *node;
+
+	for (node = files; node != NULL; node = node->next) {
+		finish_info_provider (directory, node->data, provider);
+	}
+}
+
+/* Finish the state and tell its files the provider is done. */
+static void
+extension_info_done (NautilusDirectory *directory,
+		     ExtensionInfoState *state)
+{
+	GList *files, *provider_files;
+	NautilusInfoProvider *provider;
+
+	files = extension_info_state_take_files (directory, state);
+	provider = state->provider;
+
+	/* Keep the files alive until the provider is finished for them. */
+	provider_files = state->provider_files;
+	state->provider_files = NULL;
+
+	/* Don't let the source removal in the free function
+	 * touch the source we are being called from.
+	 */
+	state->idle_id = 0;
+	extension_info_state_remove (directory, state);
+
+	if (files != NULL) {
+		finish_info_provider_for_files (directory, files, provider);
+		g_list_free (files);
+	} else {
+		nautilus_directory_async_state_changed (directory);
+	}
+
+	nautilus_file_list_free (provider_files);
+}
 
 static gboolean
 info_provider_idle_callback (gpointer user_data)
 {
-	InfoProviderResponse *response;
-	NautilusDirectory *directory;
+	ExtensionInfoState *state;
 
-	response = user_data;
-	directory = response->directory;
+	state = user_data;
+	extension_info_done (state->directory, state);
 
-	if (response->handle != directory->details->extension_info_in_progress
-	    || response->provider != directory->details->extension_info_provider) {
-		g_warning ("Unexpected plugin response.  This probably indicates a bug in a Nautilus extension: handle=%p", response->handle);
-	} else {
-		NautilusFile *file;
-		async_job_end (directory, "extension info");
+	return FALSE;
+}
 
-		file = directory->details->extension_info_file;
+static gboolean
+info_provider_timeout_callback (gpointer user_data)
+{
+	ExtensionInfoState *state;
 
-		directory->details->extension_info_file = NULL;
-		directory->details->extension_info_provider = NULL;
-		directory->details->extension_info_in_progress = NULL;
-		directory->details->extension_info_idle = 0;
-		
-		finish_info_provider (directory, file, response->provider);
-	}
+	state = user_data;
+
+	g_warning ("Nautilus extension %s did not answer for %d files in %d seconds, giving up",
+		   G_OBJECT_TYPE_NAME (state->provider),
+		   g_list_length (state->files),
+		   EXTENSION_INFO_TIMEOUT_SECONDS);
+
+	state->timeout_id = 0;
+	nautilus_info_provider_cancel_update (state->provider, state->handle);
+	extension_info_done (state->directory, state);
 
 	return FALSE;
 }
@@ -4445,76 +5182,187 @@ info_provider_callback (NautilusInfoProvider *provider,
 			NautilusOperationResult result,
 			gpointer user_data)
 {
-	InfoProviderResponse *response;
-	
-	response = g_new0 (InfoProviderResponse, 1);
-	response->provider = provider;
-	response->handle = handle;
-	response->result = result;
-	response->directory = NAUTILUS_DIRECTORY (user_data);
+	NautilusDirectory *directory;
+	ExtensionInfoState *state;
+
+	directory = NAUTILUS_DIRECTORY (user_data);
 
-	response->directory->details->extension_info_idle =
-		g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
-				 info_provider_idle_callback, response,
-				 g_free);
+	state = extension_info_find (directory, provider, handle);
+	if (state == NULL || state->idle_id != 0) {
+		g_warning ("Unexpected plugin response.  This probably indicates a bug in a Nautilus extension: handle=%p", handle);
+		return;
+	}
+
+	if (state->timeout_id != 0) {
+		g_source_remove (state->timeout_id);
+		state->timeout_id = 0;
+	}
+
+	state->result = result;
+	state->idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+					  info_provider_idle_callback, state,
+					  NULL);
 }
 
+/* Gather the queued files that are waiting for the same provider, so
+ * a batch capable provider can answer them in one call. The list
+ * starts with file and does not hold references.
+ */
+static GList *
+extension_info_collect_batch (NautilusDirectory *directory,
+			      NautilusFile *file,
+			      NautilusInfoProvider *provider)
+{
+	GList *files, *node;
+	NautilusFile *queued_file;
+	int count, scanned;
+
+	files = g_list_prepend (NULL, file);
+	count = 1;
+	scanned = 0;
+
+	for (node = nautilus_file_queue_peek_list (directory->details->extension_queue);
+	     node != NULL && count < MAX_EXTENSION_INFO_BATCH_SIZE &&
+		     scanned < MAX_EXTENSION_INFO_BATCH_SCAN;
+	     node = node->next, scanned++) {
+		queued_file = node->data;
+		if (queued_file == file ||
+		    g_list_find (queued_file->details->pending_info_providers, provider) == NULL ||
+		    extension_info_is_running (directory, queued_file, provider) ||
+		    !is_needy (queued_file, lacks_extension_info, REQUEST_EXTENSION_INFO)) {
+			continue;
+		}
+		files = g_list_prepend (files, queued_file);
+		count++;
+	}
+
+	return g_list_reverse (files);
+}
+
+/* Start every pending provider for this file that isn't already
+ * running, as long as the provider is below its concurrency limit.
+ * Sets *waiting if a provider was skipped for being at its limit,
+ * and *doing_io if no async. job could be started at all.
+ */
 static void
 extension_info_start (NautilusDirectory *directory,
 		      NautilusFile *file,
+		      gboolean *waiting,
 		      gboolean *doing_io)
 {
 	NautilusInfoProvider *provider;
 	NautilusOperationResult result;
 	NautilusOperationHandle *handle;
 	GClosure *update_complete;
+	ExtensionInfoState *state;
+	GList *providers, *node, *files, *file_node, *provider_files;
 
-	if (directory->details->extension_info_in_progress != NULL) {
-		*doing_io = TRUE;
-		return;
-	}
-	
 	if (!is_needy (file, lacks_extension_info, REQUEST_EXTENSION_INFO)) {
 		return;
 	}
-	*doing_io = TRUE;
 
-	if (!async_job_start (directory, "extension info")) {
-		return;
-	}
+	/* finish_info_provider may change the pending list under us. */
+	providers = eel_g_object_list_copy (file->details->pending_info_providers);
 
-	provider = file->details->pending_info_providers->data;
+	for (node = providers; node != NULL; node = node->next) {
+		provider = node->data;
 
-	update_complete = g_cclosure_new (G_CALLBACK (info_provider_callback),
-					  directory,
-					  NULL);
-	g_closure_set_marshal (update_complete,
-			       nautilus_marshal_VOID__POINTER_ENUM);
-			       
-	result = nautilus_info_provider_update_file_info
-		(provider, 
-		 NAUTILUS_FILE_INFO (file), 
-		 update_complete, 
-		 &handle);
-
-	g_closure_unref (update_complete);
-
-	if (result == NAUTILUS_OPERATION_COMPLETE ||
-	    result == NAUTILUS_OPERATION_FAILED) {
-		finish_info_provider (directory, file, provider);
-		async_job_end (directory, "extension info");
-	} else {
-		directory->details->extension_info_in_progress = handle;
-		directory->details->extension_info_provider = provider;
-		directory->details->extension_info_file = file;
+		if (extension_info_is_running (directory, file, provider)) {
+			continue;
+		}
+
+		if (extension_info_count_for_provider (directory, provider)
+		    >= MAX_EXTENSION_INFO_JOBS_PER_PROVIDER) {
+			*waiting = TRUE;
+			continue;
+		}
+
+		if (directory->details->extension_info_in_progress == NULL &&
+		    !async_job_start (directory, "extension info")) {
+			*doing_io = TRUE;
+			break;
+		}
+
+		update_complete = g_cclosure_new (G_CALLBACK (info_provider_callback),
+						  directory,
+						  NULL);
+		g_closure_set_marshal (update_complete,
+				       nautilus_marshal_VOID__POINTER_ENUM);
+
+		if (nautilus_info_provider_can_batch (provider)) {
+			files = extension_info_collect_batch (directory, file, provider);
+		} else {
+			files = g_list_prepend (NULL, file);
+		}
+
+		/* Hold the job while the provider runs, even if it
+		 * finishes synchronously.
+		 */
+		state = g_new0 (ExtensionInfoState, 1);
+		state->directory = directory;
+		state->files = files;
+		state->provider = provider;
+		directory->details->extension_info_in_progress =
+			g_list_prepend (directory->details->extension_info_in_progress, state);
+		for (file_node = files; file_node != NULL; file_node = file_node->next) {
+			extension_info_running_add (directory, file_node->data, provider);
+		}
+
+		if (nautilus_info_provider_can_batch (provider)) {
+			/* NautilusFile implements NautilusFileInfo. The
+			 * provider gets a list of its own, as state->files
+			 * loses the files that go away while it runs.
+			 */
+			state->provider_files = eel_g_object_list_copy (files);
+			result = nautilus_info_provider_update_file_info_batch
+				(provider,
+				 state->provider_files,
+				 update_complete,
+				 &handle);
+		} else {
+			result = nautilus_info_provider_update_file_info
+				(provider, 
+				 NAUTILUS_FILE_INFO (file), 
+				 update_complete, 
+				 &handle);
+		}
+
+		g_closure_unref (update_complete);
+
+		if (result == NAUTILUS_OPERATION_COMPLETE ||
+		    result == NAUTILUS_OPERATION_FAILED) {
+			files = extension_info_state_take_files (directory, state);
+			provider_files = state->provider_files;
+			state->provider_files = NULL;
+			extension_info_state_remove (directory, state);
+			finish_info_provider_for_files (directory, files, provider);
+			g_list_free (files);
+			nautilus_file_list_free (provider_files);
+		} else {
+			state->handle = handle;
+			state->timeout_id =
+				g_timeout_add_seconds (EXTENSION_INFO_TIMEOUT_SECONDS,
+						       info_provider_timeout_callback,
+						       state);
+		}
 	}
+
+	g_list_free_full (providers, g_object_unref);
 }
 
 static void
 start_or_stop_io (NautilusDirectory *directory)
 {
 	NautilusFile *file;
-	gboolean doing_io;
+	gboolean doing_io, waiting;
+	guint n_left, n_waiting;
+
+	NAUTILUS_TRACE_COUNTER ("high priority queue", directory,
+				nautilus_file_queue_get_length (directory->details->high_priority_queue));
+	NAUTILUS_TRACE_COUNTER ("low priority queue", directory,
+				nautilus_file_queue_get_length (directory->details->low_priority_queue));
+	NAUTILUS_TRACE_COUNTER ("extension queue", directory,
+				nautilus_file_queue_get_length (directory->details->extension_queue));
 
 	/* Start or stop reading files. */
 	file_list_start_or_stop (directory);
@@ -4567,17 +5415,40 @@ start_or_stop_io (NautilusDirectory *directory)
 		move_file_to_extension_queue (directory, file);
 	}
 
-	/* Low priority queue must be empty */
-	while (!nautilus_file_queue_is_empty (directory->details->extension_queue)) {
+	/* Low priority queue must be empty. Look at each file at most
+	 * once per pass, and at no more than a scan window of files
+	 * that are waiting on a busy provider.
+	 */
+	n_left = nautilus_file_queue_get_length (directory->details->extension_queue);
+	n_waiting = 0;
+	while (n_left-- > 0 &&
+	       n_waiting < MAX_EXTENSION_INFO_BATCH_SCAN &&
+	       !nautilus_file_queue_is_empty (directory->details->extension_queue)) {
 		file = nautilus_file_queue_head (directory->details->extension_queue);
 
-		/* Start getting attributes if possible */
-		extension_info_start (directory, file, &doing_io);
+		/* Start getting attributes if possible. Files whose
+		 * providers are all running can leave the queue, so
+		 * that the next files get their turn in parallel.
+		 */
+		waiting = FALSE;
+		extension_info_start (directory, file, &waiting, &doing_io);
 		if (doing_io) {
 			return;
 		}
 
-		nautilus_directory_remove_file_from_work_queue (directory, file);
+		if (waiting) {
+			/* A provider is at its limit; keep the file
+			 * pending at the tail, so that files needing
+			 * only other providers aren't held up behind it.
+			 */
+			nautilus_file_ref (file);
+			nautilus_file_queue_remove (directory->details->extension_queue, file);
+			nautilus_file_queue_enqueue (directory->details->extension_queue, file);
+			nautilus_file_unref (file);
+			n_waiting++;
+		} else {
+			nautilus_directory_remove_file_from_work_queue (directory, file);
+		}
 	}
 }
 
@@ -4674,9 +5545,16 @@ static void
 cancel_top_left_text_for_file (NautilusDirectory *directory,
 			       NautilusFile      *file)
 {
-	if (directory->details->top_left_read_state != NULL &&
-	    directory->details->top_left_read_state->file == file) {
-		top_left_cancel (directory);
+	GList *node, *next;
+	TopLeftTextReadState *state;
+
+	for (node = directory->details->top_left_read_states;
+	     node != NULL; node = next) {
+		next = node->next;
+		state = node->data;
+		if (state->file == file) {
+			top_left_cancel_one (directory, state);
+		}
 	}
 }
 
@@ -4693,9 +5571,16 @@ static void
 cancel_thumbnail_for_file (NautilusDirectory *directory,
 			   NautilusFile      *file)
 {
-	if (directory->details->thumbnail_state != NULL &&
-	    directory->details->thumbnail_state->file == file) {
-		thumbnail_cancel (directory);
+	GList *node, *next;
+	ThumbnailState *state;
+
+	for (node = directory->details->thumbnail_states;
+	     node != NULL; node = next) {
+		next = node->next;
+		state = node->data;
+		if (state->file == file) {
+			thumbnail_cancel_one (directory, state);
+		}
 	}
 }
 
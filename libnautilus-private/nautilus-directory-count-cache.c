@@ -0,0 +1,279 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*-
+
+   nautilus-directory-count-cache.c: item counts of directories that
+   are kept between visits and sessions.
+
+   Copyright (C) 2011 The Nautilus contributors
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public
+   License along with this program; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+#include <config.h>
+#include "nautilus-directory-count-cache.h"
+
+#include <eel/eel-debug.h>
+#include <stdlib.h>
+
+/* Directories remembered at most, least recently used ones are
+ * dropped first.
+ */
+#define DIRECTORY_COUNT_CACHE_MAX_ENTRIES 20000
+
+/* The file lives in the cache directory, one directory per line:
+ *	filesystem id, inode, mtime, show hidden, count
+ * separated by tabs, most recently used first.
+ */
+#define DIRECTORY_COUNT_CACHE_FILE_NAME "directory-counts"
+
+typedef struct {
+	char *key;
+	time_t mtime;
+	gboolean show_hidden;
+	guint count;
+	GList *link;
+} CountCacheEntry;
+
+static GHashTable *count_cache;
+static GQueue count_cache_lru = G_QUEUE_INIT;
+static gboolean count_cache_changed;
+
+static void
+count_cache_entry_free (CountCacheEntry *entry)
+{
+	g_free (entry->key);
+	g_free (entry);
+}
+
+static char *
+make_key (const char *filesystem_id,
+	  guint64 inode)
+{
+	return g_strdup_printf ("%s\t%" G_GUINT64_FORMAT, filesystem_id, inode);
+}
+
+static char *
+get_cache_file_path (void)
+{
+	return g_build_filename (g_get_user_cache_dir (), "nautilus",
+				 DIRECTORY_COUNT_CACHE_FILE_NAME, NULL);
+}
+
+static void
+count_cache_remove_entry (CountCacheEntry *entry)
+{
+	g_queue_delete_link (&count_cache_lru, entry->link);
+	/* Frees the entry */
+	g_hash_table_remove (count_cache, entry->key);
+	count_cache_changed = TRUE;
+}
+
+static void
+count_cache_add_entry (CountCacheEntry *entry,
+		       gboolean most_recent)
+{
+	if (most_recent) {
+		g_queue_push_head (&count_cache_lru, entry);
+		entry->link = count_cache_lru.head;
+	} else {
+		g_queue_push_tail (&count_cache_lru, entry);
+		entry->link = count_cache_lru.tail;
+	}
+	g_hash_table_insert (count_cache, entry->key, entry);
+
+	while (g_hash_table_size (count_cache) > DIRECTORY_COUNT_CACHE_MAX_ENTRIES) {
+		count_cache_remove_entry (count_cache_lru.tail->data);
+	}
+}
+
+static void
+load_count_cache (void)
+{
+	char *path, *contents;
+	char **lines, **fields;
+	CountCacheEntry *entry;
+	int i;
+
+	path = get_cache_file_path ();
+	if (!g_file_get_contents (path, &contents, NULL, NULL)) {
+		g_free (path);
+		return;
+	}
+	g_free (path);
+
+	lines = g_strsplit (contents, "\n", -1);
+	g_free (contents);
+
+	for (i = 0; lines[i] != NULL; i++) {
+		fields = g_strsplit (lines[i], "\t", -1);
+		if (g_strv_length (fields) == 5) {
+			entry = g_new0 (CountCacheEntry, 1);
+			entry->key = make_key (fields[0],
+					       g_ascii_strtoull (fields[1], NULL, 10));
+			entry->mtime = (time_t) g_ascii_strtoll (fields[2], NULL, 10);
+			entry->show_hidden = atoi (fields[3]) != 0;
+			entry->count = (guint) g_ascii_strtoull (fields[4], NULL, 10);
+
+			if (g_hash_table_lookup (count_cache, entry->key) != NULL) {
+				count_cache_entry_free (entry);
+			} else {
+				count_cache_add_entry (entry, FALSE);
+			}
+		}
+		g_strfreev (fields);
+	}
+	g_strfreev (lines);
+}
+
+static void
+save_count_cache (void)
+{
+	GString *contents;
+	GList *node;
+	CountCacheEntry *entry;
+	char *path, *dir;
+
+	contents = g_string_new (NULL);
+	for (node = count_cache_lru.head; node != NULL; node = node->next) {
+		entry = node->data;
+		g_string_append_printf (contents, "%s\t%" G_GINT64_FORMAT "\t%d\t%u\n",
+					entry->key, (gint64) entry->mtime,
+					entry->show_hidden, entry->count);
+	}
+
+	path = get_cache_file_path ();
+	dir = g_path_get_dirname (path);
+	if (g_mkdir_with_parents (dir, 0700) == 0) {
+		g_file_set_contents (path, contents->str, contents->len, NULL);
+	}
+	g_free (dir);
+	g_free (path);
+
+	g_string_free (contents, TRUE);
+}
+
+static void
+count_cache_free (void)
+{
+	if (count_cache_changed) {
+		save_count_cache ();
+	}
+
+	g_queue_clear (&count_cache_lru);
+	g_hash_table_destroy (count_cache);
+	count_cache = NULL;
+}
+
+static GHashTable *
+get_count_cache (void)
+{
+	if (count_cache == NULL) {
+		count_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+						     NULL,
+						     (GDestroyNotify) count_cache_entry_free);
+		eel_debug_call_at_shutdown (count_cache_free);
+
+		load_count_cache ();
+		count_cache_changed = FALSE;
+	}
+
+	return count_cache;
+}
+
+gboolean
+nautilus_directory_count_cache_lookup (const char *filesystem_id,
+				       guint64     inode,
+				       time_t      mtime,
+				       gboolean    show_hidden,
+				       guint      *count)
+{
+	CountCacheEntry *entry;
+	char *key;
+
+	if (filesystem_id == NULL || inode == 0 || mtime == 0) {
+		return FALSE;
+	}
+
+	key = make_key (filesystem_id, inode);
+	entry = g_hash_table_lookup (get_count_cache (), key);
+	g_free (key);
+
+	if (entry == NULL ||
+	    entry->mtime != mtime ||
+	    entry->show_hidden != show_hidden) {
+		return FALSE;
+	}
+
+	/* Move to the front of the LRU list */
+	g_queue_unlink (&count_cache_lru, entry->link);
+	g_queue_push_head_link (&count_cache_lru, entry->link);
+
+	*count = entry->count;
+	return TRUE;
+}
+
+void
+nautilus_directory_count_cache_insert (const char *filesystem_id,
+				       guint64     inode,
+				       time_t      mtime,
+				       gboolean    show_hidden,
+				       guint       count)
+{
+	CountCacheEntry *entry;
+	char *key;
+
+	/* A directory changed again within the second it was counted in
+	 * would keep its mtime, so only trust counts of older ones.
+	 */
+	if (filesystem_id == NULL || inode == 0 ||
+	    mtime == 0 || mtime >= time (NULL) - 1) {
+		return;
+	}
+
+	key = make_key (filesystem_id, inode);
+	entry = g_hash_table_lookup (get_count_cache (), key);
+	if (entry != NULL) {
+		count_cache_remove_entry (entry);
+	}
+
+	entry = g_new0 (CountCacheEntry, 1);
+	entry->key = key;
+	entry->mtime = mtime;
+	entry->show_hidden = show_hidden;
+	entry->count = count;
+	count_cache_add_entry (entry, TRUE);
+
+	count_cache_changed = TRUE;
+}
+
+void
+nautilus_directory_count_cache_remove (const char *filesystem_id,
+				       guint64     inode)
+{
+	CountCacheEntry *entry;
+	char *key;
+
+	if (filesystem_id == NULL || inode == 0) {
+		return;
+	}
+
+	key = make_key (filesystem_id, inode);
+	entry = g_hash_table_lookup (get_count_cache (), key);
+	g_free (key);
+
+	if (entry != NULL) {
+		count_cache_remove_entry (entry);
+	}
+}
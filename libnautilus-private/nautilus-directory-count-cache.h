@@ -0,0 +1,47 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*-
+
+   nautilus-directory-count-cache.h: item counts of directories that
+   are kept between visits and sessions.
+
+   Copyright (C) 2011 The Nautilus contributors
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public
+   License along with this program; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+#ifndef NAUTILUS_DIRECTORY_COUNT_CACHE_H
+#define NAUTILUS_DIRECTORY_COUNT_CACHE_H
+
+#include <glib.h>
+#include <time.h>
+
+/* Counts are keyed by filesystem id and inode, and only returned while
+ * the directory still has the modification time it had when counted.
+ * show_hidden tells which of the two possible counts is meant.
+ */
+gboolean nautilus_directory_count_cache_lookup (const char *filesystem_id,
+						guint64     inode,
+						time_t      mtime,
+						gboolean    show_hidden,
+						guint      *count);
+void     nautilus_directory_count_cache_insert (const char *filesystem_id,
+						guint64     inode,
+						time_t      mtime,
+						gboolean    show_hidden,
+						guint       count);
+void     nautilus_directory_count_cache_remove (const char *filesystem_id,
+						guint64     inode);
+
+#endif /* NAUTILUS_DIRECTORY_COUNT_CACHE_H */
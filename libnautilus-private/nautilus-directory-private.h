@@ -44,6 +44,7 @@ typedef struct MimeListState MimeListState;
 typedef struct ThumbnailState ThumbnailState;
 typedef struct MountState MountState;
 typedef struct FilesystemInfoState FilesystemInfoState;
+typedef struct ExtensionInfoState ExtensionInfoState;
 
 typedef enum {
 	REQUEST_LINK_INFO,
@@ -119,18 +120,19 @@ struct NautilusDirectoryDetails
 	NautilusFile *get_info_file;
 	GetInfoState *get_info_in_progress;
 
-	NautilusFile *extension_info_file;
-	NautilusInfoProvider *extension_info_provider;
-	NautilusOperationHandle *extension_info_in_progress;
-	guint extension_info_idle;
+	GList *extension_info_in_progress; /* list of ExtensionInfoState * */
+	GHashTable *extension_info_running; /* NautilusFile * -> GList of providers running for it */
 
-	ThumbnailState *thumbnail_state;
+	GList *thumbnail_states; /* list of ThumbnailState * being loaded */
+	int thumbnail_load_count; /* length of thumbnail_states */
+	GList *thumbnails_loaded; /* list of ThumbnailState * to hand out */
+	guint thumbnails_loaded_idle_id;
 
 	MountState *mount_state;
 
 	FilesystemInfoState *filesystem_info_state;
 	
-	TopLeftTextReadState *top_left_read_state;
+	GList *top_left_read_states; /* list of TopLeftTextReadState * being read */
 
 	LinkInfoReadState *link_info_read_state;
 
@@ -200,6 +202,9 @@ void               nautilus_directory_emit_change_signals             (NautilusD
 								       GList                     *changed_files);
 void               emit_change_signals_for_all_files		      (NautilusDirectory	 *directory);
 void               emit_change_signals_for_all_files_in_all_directories (void);
+void               emit_change_signals_for_matching_files_in_all_directories (gboolean (*match) (NautilusFile *file,
+														 gpointer      callback_data),
+									      gpointer callback_data);
 void               nautilus_directory_emit_done_loading               (NautilusDirectory         *directory);
 void               nautilus_directory_emit_load_error                 (NautilusDirectory         *directory,
 								       GError                    *error);
@@ -167,7 +167,7 @@ nautilus_directory_finalize (GObject *object)
 
 	nautilus_directory_cancel (directory);
 	g_assert (directory->details->count_in_progress == NULL);
-	g_assert (directory->details->top_left_read_state == NULL);
+	g_assert (directory->details->top_left_read_states == NULL);
 
 	if (directory->details->monitor_list != NULL) {
 		g_warning ("destroying a NautilusDirectory while it's being monitored");
@@ -196,6 +196,10 @@ nautilus_directory_finalize (GObject *object)
 	if (directory->details->hidden_file_hash) {
 		g_hash_table_destroy (directory->details->hidden_file_hash);
 	}
+
+	if (directory->details->extension_info_running != NULL) {
+		g_hash_table_destroy (directory->details->extension_info_running);
+	}
 	
 	nautilus_file_queue_destroy (directory->details->high_priority_queue);
 	nautilus_file_queue_destroy (directory->details->low_priority_queue);
@@ -281,6 +285,48 @@ emit_change_signals_for_all_files_in_all_directories (void)
 	g_list_free (dirs);
 }
 
+/* Like emit_change_signals_for_all_files_in_all_directories, but only
+ * for the files match returns TRUE for.
+ */
+void
+emit_change_signals_for_matching_files_in_all_directories (gboolean (*match) (NautilusFile *file,
+									     gpointer callback_data),
+							   gpointer callback_data)
+{
+	GList *dirs, *l, *node, *files;
+	NautilusDirectory *directory;
+	NautilusFile *file;
+
+	dirs = NULL;
+	g_hash_table_foreach (directories,
+			      collect_all_directories,
+			      &dirs);
+
+	for (l = dirs; l != NULL; l = l->next) {
+		directory = NAUTILUS_DIRECTORY (l->data);
+
+		files = NULL;
+		for (node = directory->details->file_list; node != NULL; node = node->next) {
+			file = node->data;
+			if ((* match) (file, callback_data)) {
+				files = g_list_prepend (files, nautilus_file_ref (file));
+			}
+		}
+		file = directory->details->as_file;
+		if (file != NULL && (* match) (file, callback_data)) {
+			files = g_list_prepend (files, nautilus_file_ref (file));
+		}
+
+		if (files != NULL) {
+			nautilus_directory_emit_change_signals (directory, files);
+			nautilus_file_list_free (files);
+		}
+		nautilus_directory_unref (directory);
+	}
+
+	g_list_free (dirs);
+}
+
 static void
 async_state_changed_one (gpointer key, gpointer value, gpointer user_data)
 {
@@ -63,6 +63,7 @@
 #include "nautilus-trash-monitor.h"
 #include "nautilus-file-utilities.h"
 #include "nautilus-file-conflict-dialog.h"
+#include "nautilus-filesystem-info.h"
 
 /* TODO: TESTING!!! */
 
@@ -1403,6 +1404,14 @@ report_delete_progress (CommonJob *job,
 	}
 	transfer_info->last_report_time = now;
 	
+	if (!nautilus_progress_info_get_wants_text (job->progress)) {
+		/* The last texts weren't even shown yet */
+		if (source_info->num_files != 0) {
+			nautilus_progress_info_set_progress (job->progress, transfer_info->num_files, source_info->num_files);
+		}
+		return;
+	}
+
 	files_left = source_info->num_files - transfer_info->num_files;
 
 	/* Races and whatnot could cause this to be negative... */
@@ -1727,14 +1736,16 @@ report_trash_progress (CommonJob *job,
 
 	files_left = total_files - files_trashed;
 
-	nautilus_progress_info_take_status (job->progress,
-					    f (_("Moving files to trash")));
+	if (nautilus_progress_info_get_wants_text (job->progress)) {
+		nautilus_progress_info_take_status (job->progress,
+						    f (_("Moving files to trash")));
 
-	s = f (ngettext ("%'d file left to trash",
-			 "%'d files left to trash",
-			 files_left),
-	       files_left);
-	nautilus_progress_info_take_details (job->progress, s);
+		s = f (ngettext ("%'d file left to trash",
+				 "%'d files left to trash",
+				 files_left),
+		       files_left);
+		nautilus_progress_info_take_details (job->progress, s);
+	}
 
 	if (total_files != 0) {
 		nautilus_progress_info_set_progress (job->progress, files_trashed, total_files);
@@ -2371,6 +2382,11 @@ report_count_progress (CommonJob *job,
 {
 	char *s;
 
+	if (!nautilus_progress_info_get_wants_text (job->progress)) {
+		nautilus_progress_info_pulse_progress (job->progress);
+		return;
+	}
+
 	switch (source_info->op) {
 	default:
 	case OP_KIND_COPY:
@@ -2759,11 +2775,8 @@ verify_destination (CommonJob *job,
 		return;
 	}
 	
-	fsinfo = g_file_query_filesystem_info (dest,
-					       G_FILE_ATTRIBUTE_FILESYSTEM_FREE","
-					       G_FILE_ATTRIBUTE_FILESYSTEM_READONLY,
-					       job->cancellable,
-					       NULL);
+	/* Free space is checked against what is about to be copied */
+	fsinfo = nautilus_filesystem_info_query_new_sync (dest, job->cancellable);
 	if (fsinfo == NULL) {
 		/* All sorts of things can go wrong getting the fs info (like not supported)
 		 * only check these things if the fs returns them
@@ -2851,6 +2864,14 @@ report_copy_progress (CopyMoveJob *copy_job,
 	}
 	transfer_info->last_report_time = now;
 	
+	total_size = MAX (source_info->num_bytes, transfer_info->num_bytes);
+
+	if (!nautilus_progress_info_get_wants_text (job->progress)) {
+		/* The last texts weren't even shown yet */
+		nautilus_progress_info_set_progress (job->progress, transfer_info->num_bytes, total_size);
+		return;
+	}
+
 	files_left = source_info->num_files - transfer_info->num_files;
 
 	/* Races and whatnot could cause this to be negative... */
@@ -2923,8 +2944,6 @@ report_copy_progress (CopyMoveJob *copy_job,
 		}
 	}
 	
-	total_size = MAX (source_info->num_bytes, transfer_info->num_bytes);
-	
 	elapsed = g_timer_elapsed (job->time, NULL);
 	transfer_rate = 0;
 	if (elapsed > 0) {
@@ -3779,10 +3798,7 @@ query_fs_type (GFile *file,
 
 	ret = NULL;
 
-	fsinfo = g_file_query_filesystem_info (file,
-					       G_FILE_ATTRIBUTE_FILESYSTEM_TYPE,
-					       cancellable,
-					       NULL);
+	fsinfo = nautilus_filesystem_info_query_sync (file, cancellable);
 	if (fsinfo != NULL) {
 		ret = g_strdup (g_file_info_get_attribute_string (fsinfo, G_FILE_ATTRIBUTE_FILESYSTEM_TYPE));
 		g_object_unref (fsinfo);
@@ -4378,7 +4394,7 @@ copy_files (CopyMoveJob *job,
 	/* Query the source dir, not the file because if its a symlink we'll follow it */
 	source_dir = g_file_get_parent ((GFile *) job->files->data);
 	if (source_dir) {
-		inf = g_file_query_filesystem_info (source_dir, "filesystem::readonly", NULL, NULL);
+		inf = nautilus_filesystem_info_query_sync (source_dir, job->common.cancellable);
 		if (inf != NULL) {
 			readonly_source_fs = g_file_info_get_attribute_boolean (inf, "filesystem::readonly");
 			g_object_unref (inf);
@@ -4467,7 +4483,7 @@ copy_job (GIOSchedulerJob *io_job,
 	SourceInfo source_info;
 	TransferInfo transfer_info;
 	char *dest_fs_id;
-	GFile *dest;
+	GFile *dest, *source_dir;
 
 	job = user_data;
 	common = &job->common;
@@ -4493,6 +4509,15 @@ copy_job (GIOSchedulerJob *io_job,
 		 */
 		dest = g_file_get_parent (job->files->data);
 	}
+
+	/* copy_files looks at the source filesystem next, so ask
+	 * about it while the destination is checked.
+	 */
+	source_dir = g_file_get_parent (job->files->data);
+	if (source_dir != NULL) {
+		nautilus_filesystem_info_query_async (source_dir, NULL, NULL);
+		g_object_unref (source_dir);
+	}
 	
 	verify_destination (&job->common,
 			    dest,
@@ -4600,14 +4625,16 @@ report_move_progress (CopyMoveJob *move_job, int total, int left)
 
 	job = (CommonJob *)move_job;
 	
-	nautilus_progress_info_take_status (job->progress,
-					    f (_("Preparing to Move to \"%B\""),
-					       move_job->destination));
+	if (nautilus_progress_info_get_wants_text (job->progress)) {
+		nautilus_progress_info_take_status (job->progress,
+						    f (_("Preparing to Move to \"%B\""),
+						       move_job->destination));
 
-	nautilus_progress_info_take_details (job->progress,
-					     f (ngettext ("Preparing to move %'d file",
-							  "Preparing to move %'d files",
-							  left), left));
+		nautilus_progress_info_take_details (job->progress,
+						     f (ngettext ("Preparing to move %'d file",
+								  "Preparing to move %'d files",
+								  left), left));
+	}
 
 	nautilus_progress_info_pulse_progress (job->progress);
 }
@@ -100,6 +100,8 @@ struct NautilusFileDetails
 	
 	char *thumbnail_path;
 	GdkPixbuf *thumbnail;
+	GList *thumbnail_mipmaps; /* GdkPixbuf *, each half the size of the one before */
+	GList *thumbnail_icons; /* ThumbnailIcon *, scaled for display, most recent first */
 	time_t thumbnail_mtime;
 	
 	GList *mime_list; /* If this is a directory, the list of MIME types in it. */
@@ -113,6 +115,7 @@ struct NautilusFileDetails
 	 * the same file system.
 	 */
 	eel_ref_str filesystem_id;
+	guint64 inode; /* 0 is unknown */
 
 	char *trash_orig_path;
 
@@ -186,6 +189,12 @@ struct NautilusFileDetails
 	
 	eel_boolean_bit is_thumbnailing               : 1;
 
+	/* TRUE if the file info had no names, so owner and group are
+	 * just the ids and the names come from the users/groups cache.
+	 */
+	eel_boolean_bit owner_is_uid                  : 1;
+	eel_boolean_bit group_is_gid                  : 1;
+
 	/* TRUE if the file is open in a spatial window */
 	eel_boolean_bit has_open_window               : 1;
 
@@ -257,6 +266,15 @@ gboolean      nautilus_file_update_name                    (NautilusFile
 							    const char             *name);
 gboolean      nautilus_file_update_metadata_from_info      (NautilusFile           *file,
 							    GFileInfo              *info);
+/* Change one key of the in-memory metadata, for writers that don't
+ * read the file info back. A NULL value removes the key. Return TRUE
+ * if the metadata changed. */
+gboolean      nautilus_file_update_metadata_value          (NautilusFile           *file,
+							    const char             *key,
+							    const char             *value);
+gboolean      nautilus_file_update_metadata_list_value     (NautilusFile           *file,
+							    const char             *key,
+							    char                  **value);
 
 gboolean      nautilus_file_update_name_and_directory      (NautilusFile           *file,
 							    const char             *name,
@@ -290,6 +308,9 @@ void                   nautilus_file_info_providers_done                (Nautilu
 /* Thumbnailing: */
 void          nautilus_file_set_is_thumbnailing            (NautilusFile           *file,
 							    gboolean                is_thumbnailing);
+void          nautilus_file_set_thumbnail                  (NautilusFile           *file,
+							    GdkPixbuf              *pixbuf,
+							    GList                  *mipmaps);
 
 NautilusFileOperation *nautilus_file_operation_new      (NautilusFile                  *file,
 							 NautilusFileOperationCallback  callback,
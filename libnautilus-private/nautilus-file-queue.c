@@ -123,3 +123,15 @@ nautilus_file_queue_is_empty (NautilusFileQueue *queue)
 {
 	return (queue->head == NULL);
 }
+
+guint
+nautilus_file_queue_get_length (NautilusFileQueue *queue)
+{
+	return g_hash_table_size (queue->item_to_link_map);
+}
+
+GList *
+nautilus_file_queue_peek_list (NautilusFileQueue *queue)
+{
+	return queue->head;
+}
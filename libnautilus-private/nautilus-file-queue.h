@@ -49,4 +49,11 @@ NautilusFile *     nautilus_file_queue_head     (NautilusFileQueue *queue);
 
 gboolean           nautilus_file_queue_is_empty (NautilusFileQueue *queue);
 
+guint              nautilus_file_queue_get_length (NautilusFileQueue *queue);
+
+/* Get the files in queue order. The list belongs to the queue, and
+ * must not be kept across changes to it.
+ */
+GList *            nautilus_file_queue_peek_list (NautilusFileQueue *queue);
+
 #endif /* NAUTILUS_FILE_CHANGES_QUEUE_H */
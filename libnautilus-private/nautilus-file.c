@@ -35,6 +35,7 @@
 #include "nautilus-file-private.h"
 #include "nautilus-file-operations.h"
 #include "nautilus-file-utilities.h"
+#include "nautilus-filesystem-info.h"
 #include "nautilus-global-preferences.h"
 #include "nautilus-lib-self-check-functions.h"
 #include "nautilus-link.h"
@@ -406,6 +407,84 @@ nautilus_file_update_metadata_from_info (NautilusFile *file,
 	return changed;
 }
 
+/* Takes ownership of value, which is a string or a string list
+ * depending on id. NULL removes the key.
+ */
+static gboolean
+replace_metadata_value (NautilusFile *file,
+			guint id,
+			gpointer value)
+{
+	gpointer old_value;
+	gboolean equal;
+
+	old_value = NULL;
+	if (file->details->metadata != NULL) {
+		old_value = g_hash_table_lookup (file->details->metadata,
+						 GUINT_TO_POINTER (id));
+	}
+
+	if (old_value == NULL || value == NULL) {
+		equal = old_value == value;
+	} else if (id & METADATA_ID_IS_LIST_MASK) {
+		equal = eel_g_strv_equal ((char **) old_value, (char **) value);
+	} else {
+		equal = strcmp ((char *) old_value, (char *) value) == 0;
+	}
+
+	if (equal) {
+		foreach_metadata_free (GUINT_TO_POINTER (id), value, NULL);
+		return FALSE;
+	}
+
+	if (old_value != NULL) {
+		g_hash_table_remove (file->details->metadata, GUINT_TO_POINTER (id));
+		foreach_metadata_free (GUINT_TO_POINTER (id), old_value, NULL);
+	}
+
+	if (value != NULL) {
+		if (file->details->metadata == NULL) {
+			file->details->metadata = g_hash_table_new (NULL, NULL);
+		}
+		g_hash_table_insert (file->details->metadata,
+				     GUINT_TO_POINTER (id), value);
+	}
+
+	return TRUE;
+}
+
+gboolean
+nautilus_file_update_metadata_value (NautilusFile *file,
+				     const char *key,
+				     const char *value)
+{
+	guint id;
+
+	id = nautilus_metadata_get_id (key);
+	if (id == 0) {
+		/* Unknown keys are not kept, see get_metadata_from_info() */
+		return FALSE;
+	}
+
+	return replace_metadata_value (file, id, g_strdup (value));
+}
+
+gboolean
+nautilus_file_update_metadata_list_value (NautilusFile *file,
+					  const char *key,
+					  char **value)
+{
+	guint id;
+
+	id = nautilus_metadata_get_id (key);
+	if (id == 0) {
+		return FALSE;
+	}
+
+	return replace_metadata_value (file, id | METADATA_ID_IS_LIST_MASK,
+				       g_strdupv (value));
+}
+
 void
 nautilus_file_clear_info (NautilusFile *file)
 {
@@ -485,6 +564,7 @@ nautilus_file_clear_info (NautilusFile *file)
 
 	eel_ref_str_unref (file->details->filesystem_id);
 	file->details->filesystem_id = NULL;
+	file->details->inode = 0;
 
 	clear_metadata (file);
 }
@@ -803,9 +883,7 @@ finalize (GObject *object)
 	g_free (file->details->activation_uri);
 	g_clear_object (&file->details->custom_icon);
 
-	if (file->details->thumbnail) {
-		g_object_unref (file->details->thumbnail);
-	}
+	nautilus_file_set_thumbnail (file, NULL, NULL);
 	if (file->details->mount) {
 		g_signal_handlers_disconnect_by_func (file->details->mount, file_mount_unmounted, file);
 		g_object_unref (file->details->mount);
@@ -2297,11 +2375,14 @@ update_info_internal (NautilusFile *file,
 	
 	uid = -1;
 	gid = -1;
+	file->details->owner_is_uid = FALSE;
+	file->details->group_is_gid = FALSE;
 	if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_UNIX_UID)) {
 		uid = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_UID);
 		if (owner == NULL) {
 			free_owner = TRUE;
 			owner = g_strdup_printf ("%d", uid);
+			file->details->owner_is_uid = TRUE;
 		}
 	}
 	if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_UNIX_GID)) {
@@ -2309,6 +2390,7 @@ update_info_internal (NautilusFile *file,
 		if (group == NULL) {
 			free_group = TRUE;
 			group = g_strdup_printf ("%d", gid);
+			file->details->group_is_gid = TRUE;
 		}
 	}
 	if (file->details->uid != uid ||
@@ -2438,6 +2520,7 @@ update_info_internal (NautilusFile *file,
 		eel_ref_str_unref (file->details->filesystem_id);
 		file->details->filesystem_id = eel_ref_str_get_unique (filesystem_id);
 	}
+	file->details->inode = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE);
 
 	trash_time = 0;
 	time_string = g_file_info_get_attribute_string (info, "trash::deletion-date");
@@ -2459,6 +2542,9 @@ update_info_internal (NautilusFile *file,
 
 	changed |=
 		nautilus_file_update_metadata_from_info (file, info);
+	/* Metadata written behind isn't on disk yet */
+	changed |=
+		nautilus_vfs_file_apply_unwritten_metadata (file);
 
 	if (update_name) {
 		name = g_file_info_get_name (info);
@@ -3172,6 +3258,30 @@ nautilus_file_compare_for_sort (NautilusFile *file_1,
 	return result;
 }
 
+/* Attributes that aren't one of these are sorted by their string value. */
+static gboolean
+get_sort_type_for_attribute (GQuark attribute,
+			     NautilusFileSortType *sort_type)
+{
+	if (attribute == 0 || attribute == attribute_name_q) {
+		*sort_type = NAUTILUS_FILE_SORT_BY_DISPLAY_NAME;
+	} else if (attribute == attribute_size_q) {
+		*sort_type = NAUTILUS_FILE_SORT_BY_SIZE;
+	} else if (attribute == attribute_type_q) {
+		*sort_type = NAUTILUS_FILE_SORT_BY_TYPE;
+	} else if (attribute == attribute_modification_date_q || attribute == attribute_date_modified_q) {
+		*sort_type = NAUTILUS_FILE_SORT_BY_MTIME;
+        } else if (attribute == attribute_accessed_date_q || attribute == attribute_date_accessed_q) {
+		*sort_type = NAUTILUS_FILE_SORT_BY_ATIME;
+        } else if (attribute == attribute_trashed_on_q) {
+		*sort_type = NAUTILUS_FILE_SORT_BY_TRASHED_TIME;
+	} else {
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 int
 nautilus_file_compare_for_sort_by_attribute_q   (NautilusFile                   *file_1,
 						 NautilusFile                   *file_2,
@@ -3179,6 +3289,7 @@ nautilus_file_compare_for_sort_by_attribute_q   (NautilusFile
 						 gboolean                        directories_first,
 						 gboolean                        reversed)
 {
+	NautilusFileSortType sort_type;
 	int result;
 
 	if (file_1 == file_2) {
@@ -3188,34 +3299,9 @@ nautilus_file_compare_for_sort_by_attribute_q   (NautilusFile
 	/* Convert certain attributes into NautilusFileSortTypes and use
 	 * nautilus_file_compare_for_sort()
 	 */
-	if (attribute == 0 || attribute == attribute_name_q) {
-		return nautilus_file_compare_for_sort (file_1, file_2,
-						       NAUTILUS_FILE_SORT_BY_DISPLAY_NAME,
-						       directories_first,
-						       reversed);
-	} else if (attribute == attribute_size_q) {
+	if (get_sort_type_for_attribute (attribute, &sort_type)) {
 		return nautilus_file_compare_for_sort (file_1, file_2,
-						       NAUTILUS_FILE_SORT_BY_SIZE,
-						       directories_first,
-						       reversed);
-	} else if (attribute == attribute_type_q) {
-		return nautilus_file_compare_for_sort (file_1, file_2,
-						       NAUTILUS_FILE_SORT_BY_TYPE,
-						       directories_first,
-						       reversed);
-	} else if (attribute == attribute_modification_date_q || attribute == attribute_date_modified_q) {
-		return nautilus_file_compare_for_sort (file_1, file_2,
-						       NAUTILUS_FILE_SORT_BY_MTIME,
-						       directories_first,
-						       reversed);
-        } else if (attribute == attribute_accessed_date_q || attribute == attribute_date_accessed_q) {
-		return nautilus_file_compare_for_sort (file_1, file_2,
-						       NAUTILUS_FILE_SORT_BY_ATIME,
-						       directories_first,
-						       reversed);
-        } else if (attribute == attribute_trashed_on_q) {
-		return nautilus_file_compare_for_sort (file_1, file_2,
-						       NAUTILUS_FILE_SORT_BY_TRASHED_TIME,
+						       sort_type,
 						       directories_first,
 						       reversed);
 	}
@@ -3248,6 +3334,175 @@ nautilus_file_compare_for_sort_by_attribute_q   (NautilusFile
 	return result;
 }
 
+/* What sorting an array of files needs of each file, worked out once
+ * per file instead of once per comparison.
+ */
+typedef struct {
+	NautilusFile *file;
+	gboolean is_directory;
+	const char *mime_type;
+	char *key; /* collation key of the type, or value of the attribute */
+} FileSortKey;
+
+typedef struct {
+	FileSortKey *keys;
+	gboolean by_string;
+	NautilusFileSortType sort_type;
+	gboolean directories_first;
+	gboolean reversed;
+} FileSortKeys;
+
+/* Same order as compare_by_type. */
+static int
+compare_type_sort_keys (FileSortKey *key_1, FileSortKey *key_2)
+{
+	if (key_1->is_directory && key_2->is_directory) {
+		return 0;
+	}
+	if (key_1->is_directory) {
+		return -1;
+	}
+	if (key_2->is_directory) {
+		return +1;
+	}
+
+	if (key_1->mime_type != NULL &&
+	    key_2->mime_type != NULL &&
+	    strcmp (key_1->mime_type, key_2->mime_type) == 0) {
+		return 0;
+	}
+
+	if (key_1->key == NULL || key_2->key == NULL) {
+		if (key_1->key != NULL) {
+			return -1;
+		}
+		if (key_2->key != NULL) {
+			return 1;
+		}
+		return 0;
+	}
+
+	return strcmp (key_1->key, key_2->key);
+}
+
+static int
+compare_file_sort_keys (gconstpointer a,
+			gconstpointer b,
+			gpointer user_data)
+{
+	FileSortKeys *sort_keys;
+	FileSortKey *key_1, *key_2;
+	int index_1, index_2;
+	int result;
+
+	sort_keys = user_data;
+	index_1 = *(const int *) a;
+	index_2 = *(const int *) b;
+	key_1 = &sort_keys->keys[index_1];
+	key_2 = &sort_keys->keys[index_2];
+
+	if (sort_keys->by_string) {
+		result = nautilus_file_compare_for_sort_internal (key_1->file, key_2->file,
+								  sort_keys->directories_first,
+								  sort_keys->reversed);
+		if (result == 0) {
+			if (key_1->key != NULL && key_2->key != NULL) {
+				result = strcmp (key_1->key, key_2->key);
+			}
+			if (sort_keys->reversed) {
+				result = -result;
+			}
+		}
+	} else if (sort_keys->sort_type == NAUTILUS_FILE_SORT_BY_TYPE) {
+		result = nautilus_file_compare_for_sort_internal (key_1->file, key_2->file,
+								  sort_keys->directories_first,
+								  sort_keys->reversed);
+		if (result == 0) {
+			result = compare_type_sort_keys (key_1, key_2);
+			if (result == 0) {
+				result = compare_by_full_path (key_1->file, key_2->file);
+			}
+			if (sort_keys->reversed) {
+				result = -result;
+			}
+		}
+	} else {
+		result = nautilus_file_compare_for_sort (key_1->file, key_2->file,
+							 sort_keys->sort_type,
+							 sort_keys->directories_first,
+							 sort_keys->reversed);
+	}
+
+	/* Keep equal files in the order they came in. */
+	if (result == 0) {
+		result = index_1 - index_2;
+	}
+
+	return result;
+}
+
+/**
+ * nautilus_file_sort_by_attribute_q:
+ * @files: An array of files
+ * @n_files: Length of @files
+ * @attribute: The attribute to sort by
+ * @directories_first: Put all directories before any non-directories
+ * @reversed: Reverse the order of the items
+ * @order: Array of @n_files ints, filled with the positions in @files
+ * of the files in sorted order
+ *
+ * Sorts in the same order as nautilus_file_compare_for_sort_by_attribute_q(),
+ * but the attribute values and type descriptions that would otherwise
+ * be formatted on every comparison are computed only once per file,
+ * which matters for large folders.
+ **/
+void
+nautilus_file_sort_by_attribute_q (NautilusFile **files,
+				   int n_files,
+				   GQuark attribute,
+				   gboolean directories_first,
+				   gboolean reversed,
+				   int *order)
+{
+	FileSortKeys sort_keys;
+	FileSortKey *key;
+	char *type_string;
+	int i;
+
+	sort_keys.by_string = !get_sort_type_for_attribute (attribute, &sort_keys.sort_type);
+	sort_keys.directories_first = directories_first;
+	sort_keys.reversed = reversed;
+	sort_keys.keys = g_new0 (FileSortKey, n_files);
+
+	for (i = 0; i < n_files; i++) {
+		key = &sort_keys.keys[i];
+		key->file = files[i];
+		order[i] = i;
+
+		if (sort_keys.by_string) {
+			key->key = nautilus_file_get_string_attribute_q (files[i], attribute);
+		} else if (sort_keys.sort_type == NAUTILUS_FILE_SORT_BY_TYPE) {
+			key->is_directory = nautilus_file_is_directory (files[i]);
+			key->mime_type = eel_ref_str_peek (files[i]->details->mime_type);
+			if (!key->is_directory) {
+				type_string = nautilus_file_get_type_as_string (files[i]);
+				if (type_string != NULL) {
+					key->key = g_utf8_collate_key (type_string, -1);
+					g_free (type_string);
+				}
+			}
+		}
+	}
+
+	g_qsort_with_data (order, n_files, sizeof (int),
+			   compare_file_sort_keys, &sort_keys);
+
+	for (i = 0; i < n_files; i++) {
+		g_free (sort_keys.keys[i].key);
+	}
+	g_free (sort_keys.keys);
+}
+
 int
 nautilus_file_compare_for_sort_by_attribute     (NautilusFile                   *file_1,
 						 NautilusFile                   *file_2,
@@ -4168,6 +4423,121 @@ get_default_file_icon (NautilusFileIconFlags flags)
 	}
 }
 
+/* Scaled thumbnails are kept for this many sizes, which covers
+ * switching back and forth between views and zoom levels.
+ */
+#define MAX_THUMBNAIL_ICONS 4
+
+typedef struct {
+	int width;
+	int height;
+	NautilusIconInfo *icon;
+} ThumbnailIcon;
+
+static void
+thumbnail_icon_free (ThumbnailIcon *thumbnail_icon)
+{
+	g_object_unref (thumbnail_icon->icon);
+	g_free (thumbnail_icon);
+}
+
+void
+nautilus_file_set_thumbnail (NautilusFile *file,
+			     GdkPixbuf *pixbuf,
+			     GList *mipmaps)
+{
+	if (file->details->thumbnail != NULL) {
+		g_object_unref (file->details->thumbnail);
+	}
+	file->details->thumbnail = pixbuf != NULL ? g_object_ref (pixbuf) : NULL;
+
+	g_list_free_full (file->details->thumbnail_mipmaps, g_object_unref);
+	file->details->thumbnail_mipmaps = eel_g_object_list_copy (mipmaps);
+
+	g_list_free_full (file->details->thumbnail_icons,
+			  (GDestroyNotify) thumbnail_icon_free);
+	file->details->thumbnail_icons = NULL;
+}
+
+static NautilusIconInfo *
+get_thumbnail_icon (NautilusFile *file,
+		    int width,
+		    int height)
+{
+	GList *node;
+	ThumbnailIcon *thumbnail_icon;
+
+	for (node = file->details->thumbnail_icons; node != NULL; node = node->next) {
+		thumbnail_icon = node->data;
+		if (thumbnail_icon->width == width &&
+		    thumbnail_icon->height == height) {
+			/* Keep the most recently used first */
+			file->details->thumbnail_icons =
+				g_list_remove_link (file->details->thumbnail_icons, node);
+			file->details->thumbnail_icons =
+				g_list_concat (node, file->details->thumbnail_icons);
+			return g_object_ref (thumbnail_icon->icon);
+		}
+	}
+
+	return NULL;
+}
+
+static void
+add_thumbnail_icon (NautilusFile *file,
+		    int width,
+		    int height,
+		    NautilusIconInfo *icon)
+{
+	ThumbnailIcon *thumbnail_icon;
+	GList *last;
+
+	thumbnail_icon = g_new (ThumbnailIcon, 1);
+	thumbnail_icon->width = width;
+	thumbnail_icon->height = height;
+	thumbnail_icon->icon = g_object_ref (icon);
+	file->details->thumbnail_icons =
+		g_list_prepend (file->details->thumbnail_icons, thumbnail_icon);
+
+	if (g_list_length (file->details->thumbnail_icons) > MAX_THUMBNAIL_ICONS) {
+		last = g_list_last (file->details->thumbnail_icons);
+		thumbnail_icon_free (last->data);
+		file->details->thumbnail_icons =
+			g_list_delete_link (file->details->thumbnail_icons, last);
+	}
+}
+
+/* Returns the smallest of the thumbnail and its mipmaps that is still
+ * at least size pixels on its longest side.
+ */
+static GdkPixbuf *
+get_thumbnail_mipmap (NautilusFile *file,
+		      int size)
+{
+	GdkPixbuf *best, *mipmap;
+	GList *node;
+
+	/* Thumbnails that didn't come from the loading thread, like
+	 * the ones from the thumbnail cache, get their mipmaps now.
+	 */
+	if (file->details->thumbnail_mipmaps == NULL) {
+		file->details->thumbnail_mipmaps =
+			nautilus_thumbnail_make_mipmaps (file->details->thumbnail);
+	}
+
+	best = file->details->thumbnail;
+	for (node = file->details->thumbnail_mipmaps; node != NULL; node = node->next) {
+		mipmap = node->data;
+		if (MAX (gdk_pixbuf_get_width (mipmap),
+			 gdk_pixbuf_get_height (mipmap)) < size) {
+			break;
+		}
+		best = mipmap;
+	}
+
+	return best;
+}
+
 NautilusIconInfo *
 nautilus_file_get_icon (NautilusFile *file,
 			int size,
@@ -4206,7 +4576,7 @@ nautilus_file_get_icon (NautilusFile *file,
 			int w, h, s;
 			double scale;
 
-			raw_pixbuf = g_object_ref (file->details->thumbnail);
+			raw_pixbuf = file->details->thumbnail;
 
 			w = gdk_pixbuf_get_width (raw_pixbuf);
 			h = gdk_pixbuf_get_height (raw_pixbuf);
@@ -4224,15 +4594,21 @@ nautilus_file_get_icon (NautilusFile *file,
 				scale = (double) NAUTILUS_ICON_SIZE_SMALLEST / s;
 			}
 
-			scaled_pixbuf = gdk_pixbuf_scale_simple (raw_pixbuf,
-								 w * scale, h * scale,
-								 GDK_INTERP_BILINEAR);
+			icon = get_thumbnail_icon (file, w * scale, h * scale);
+			if (icon == NULL) {
+				scaled_pixbuf = gdk_pixbuf_scale_simple (get_thumbnail_mipmap (file, s * scale),
+									 w * scale, h * scale,
+									 GDK_INTERP_BILINEAR);
+
+				/* We don't want frames around small icons */
+				if (!gdk_pixbuf_get_has_alpha(raw_pixbuf) || s >= 128) {
+					nautilus_thumbnail_frame_image (&scaled_pixbuf);
+				}
 
-			/* We don't want frames around small icons */
-			if (!gdk_pixbuf_get_has_alpha(raw_pixbuf) || s >= 128) {
-				nautilus_thumbnail_frame_image (&scaled_pixbuf);
+				icon = nautilus_icon_info_new_for_pixbuf (scaled_pixbuf);
+				g_object_unref (scaled_pixbuf);
+				add_thumbnail_icon (file, w * scale, h * scale, icon);
 			}
-			g_object_unref (raw_pixbuf);
 
 			/* Don't scale up if more than 25%, then read the original
 			   image instead. We don't want to compare to exactly 100%,
@@ -4249,8 +4625,6 @@ nautilus_file_get_icon (NautilusFile *file,
 			DEBUG ("Returning thumbnailed image, at size %d %d",
 			       (int) (w * scale), (int) (h * scale));
 			
-			icon = nautilus_icon_info_new_for_pixbuf (scaled_pixbuf);
-			g_object_unref (scaled_pixbuf);
 			return icon;
 		} else if (file->details->thumbnail_path == NULL &&
 			   file->details->can_read &&				
@@ -5449,6 +5823,15 @@ nautilus_file_can_get_group (NautilusFile *file)
 char *
 nautilus_file_get_group_name (NautilusFile *file)
 {
+	char *name;
+
+	if (file->details->group_is_gid) {
+		name = nautilus_groups_cache_get_name (file->details->gid);
+		if (name != NULL) {
+			return name;
+		}
+	}
+
 	return g_strdup (eel_ref_str_peek (file->details->group));
 }
 
@@ -5740,7 +6123,7 @@ nautilus_file_get_permissions_as_string (NautilusFile *file)
 static char *
 nautilus_file_get_owner_as_string (NautilusFile *file, gboolean include_real_name)
 {
-	char *user_name;
+	char *user_name, *gecos, *real_name, *name;
 
 	/* Before we have info on a file, the owner is unknown. */
 	if (file->details->owner == NULL &&
@@ -5748,6 +6131,26 @@ nautilus_file_get_owner_as_string (NautilusFile *file, gboolean include_real_nam
 		return NULL;
 	}
 
+	if (file->details->owner_is_uid) {
+		/* Until the cache has looked up the name we show the uid */
+		user_name = nautilus_users_cache_get_name (file->details->uid);
+		if (user_name != NULL) {
+			if (include_real_name) {
+				gecos = nautilus_users_cache_get_gecos (file->details->uid);
+				real_name = get_real_name (user_name, gecos);
+				g_free (gecos);
+				if (real_name != NULL && real_name[0] != '\0' &&
+				    strcmp (user_name, real_name) != 0) {
+					name = g_strdup_printf ("%s - %s", user_name, real_name);
+					g_free (user_name);
+					user_name = name;
+				}
+				g_free (real_name);
+			}
+			return user_name;
+		}
+	}
+
 	if (file->details->owner_real == NULL) {
 		user_name = g_strdup (eel_ref_str_peek (file->details->owner));
 	} else if (file->details->owner == NULL) {
@@ -6589,25 +6992,20 @@ nautilus_file_is_broken_symbolic_link (NautilusFile *file)
 }
 
 static void
-get_fs_free_cb (GObject *source_object,
-		GAsyncResult *res,
+get_fs_free_cb (GFileInfo *info,
 		gpointer user_data)
 {
 	NautilusDirectory *directory;
 	NautilusFile *file;
 	guint64 free_space;
-	GFileInfo *info;
 
 	directory = NAUTILUS_DIRECTORY (user_data);
 	
 	free_space = (guint64)-1;
-	info = g_file_query_filesystem_info_finish (G_FILE (source_object),
-						    res, NULL);
 	if (info) {
 		if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE)) {
 			free_space = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
 		}
-		g_object_unref (info);
 	}
 
 	if (directory->details->free_space != free_space) {
@@ -6644,11 +7042,9 @@ nautilus_file_get_volume_free_space (NautilusFile *file)
 	    (now - directory->details->free_space_read) > 2)  {
 		directory->details->free_space_read = now;
 		location = nautilus_file_get_location (file);
-		g_file_query_filesystem_info_async (location,
-						    G_FILE_ATTRIBUTE_FILESYSTEM_FREE,
-						    0, NULL,
-						    get_fs_free_cb,
-						    directory); /* Inherits ref */
+		nautilus_filesystem_info_query_async (location,
+						      get_fs_free_cb,
+						      directory); /* Inherits ref */
 		g_object_unref (location);
 	} else {
 		nautilus_directory_unref (directory);
@@ -7918,6 +8314,50 @@ thumbnail_size_changed_callback (gpointer user_data)
 	emit_change_signals_for_all_files_in_all_directories ();
 }
 
+static gboolean
+id_array_contains (GArray *ids, guint id)
+{
+	guint i;
+
+	if (ids == NULL) {
+		return FALSE;
+	}
+
+	for (i = 0; i < ids->len; i++) {
+		if (g_array_index (ids, guint, i) == id) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static gboolean
+file_shows_changed_owner_or_group (NautilusFile *file,
+				   gpointer callback_data)
+{
+	NautilusUsersGroupsChange *change;
+
+	change = callback_data;
+
+	return (file->details->owner_is_uid &&
+		id_array_contains (change->uids, file->details->uid)) ||
+		(file->details->group_is_gid &&
+		 id_array_contains (change->gids, file->details->gid));
+}
+
+static void
+users_groups_changed_callback (GObject *signaller,
+			       NautilusUsersGroupsChange *change,
+			       gpointer user_data)
+{
+	/* Owner and group names that were looked up in the background
+	 * are in, so the views can show them instead of the ids.
+	 */
+	emit_change_signals_for_matching_files_in_all_directories
+		(file_shows_changed_owner_or_group, change);
+}
+
 static void
 show_thumbnails_changed_callback (gpointer user_data)
 {
@@ -8028,6 +8468,11 @@ nautilus_file_class_init (NautilusFileClass *class)
 				  G_CALLBACK (show_thumbnails_changed_callback),
 				  NULL);
 
+	g_signal_connect (nautilus_signaller_get_current (),
+			  "users_groups_changed",
+			  G_CALLBACK (users_groups_changed_callback),
+			  NULL);
+
 	icon_theme = gtk_icon_theme_get_default ();
 	g_signal_connect_object (icon_theme,
 				 "changed",
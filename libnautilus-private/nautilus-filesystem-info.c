@@ -0,0 +1,463 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*-
+
+   nautilus-filesystem-info.c: Shared, cached queries of filesystem
+   info that never block for long.
+
+   Copyright (C) 2011 The Nautilus contributors
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public
+   License along with this program; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+#include <config.h>
+#include "nautilus-filesystem-info.h"
+
+#include <string.h>
+#include <gio/gunixmounts.h>
+
+/* How long an answer is handed out again without asking anew. Short,
+ * because free space is what most callers are after.
+ */
+#define FILESYSTEM_INFO_MAX_AGE (2 * G_USEC_PER_SEC)
+
+/* Callers get NULL after waiting this long. The query itself goes on,
+ * and its answer is used if it ever comes.
+ */
+#define FILESYSTEM_INFO_TIMEOUT_SECONDS 5
+
+/* Queries of one mount run one at a time, so a hung mount holds on to
+ * at most one of these.
+ */
+#define FILESYSTEM_INFO_MAX_THREADS 8
+
+/* Forget the answers for locations nobody waits on above this number. */
+#define FILESYSTEM_INFO_MAX_ENTRIES 64
+
+typedef struct {
+	GFile *location;
+	char *uri;
+	char *mount; /* what the location is on, see get_mount_locked () */
+
+	GFileInfo *info;
+	gint64 info_time; /* 0 if there was no answer yet */
+
+	gboolean querying;
+	GList *waiters; /* Waiter *, answered from the main loop */
+	int sync_waiters;
+} Entry;
+
+typedef struct {
+	Entry *entry;
+	NautilusFilesystemInfoCallback callback;
+	gpointer callback_data;
+	guint timeout_id;
+	gboolean answered; /* off the entry, with an answer on its way */
+} Waiter;
+
+typedef struct {
+	GList *waiters;
+	GFileInfo *info;
+} Answer;
+
+static GHashTable *entries;
+static GHashTable *busy_mounts; /* mount -> GQueue of entries to query next */
+static GThreadPool *query_pool;
+static GList *unix_mounts;
+static guint64 unix_mounts_time;
+static GMutex *entries_mutex;
+static GCond *entries_cond;
+
+static void query_thread (gpointer data,
+			  gpointer user_data);
+
+static void
+ensure_initialized (void)
+{
+	static gsize initialized = 0;
+
+	if (g_once_init_enter (&initialized)) {
+		entries = g_hash_table_new (g_str_hash, g_str_equal);
+		busy_mounts = g_hash_table_new_full (g_str_hash, g_str_equal,
+						     g_free, NULL);
+		entries_mutex = g_mutex_new ();
+		entries_cond = g_cond_new ();
+		query_pool = g_thread_pool_new (query_thread, NULL,
+						FILESYSTEM_INFO_MAX_THREADS,
+						FALSE, NULL);
+		g_once_init_leave (&initialized, 1);
+	}
+}
+
+static void
+entry_free (Entry *entry)
+{
+	g_object_unref (entry->location);
+	g_free (entry->uri);
+	g_free (entry->mount);
+	if (entry->info != NULL) {
+		g_object_unref (entry->info);
+	}
+	g_free (entry);
+}
+
+static gboolean
+entry_is_busy (Entry *entry)
+{
+	return entry->querying ||
+		entry->waiters != NULL ||
+		entry->sync_waiters > 0;
+}
+
+static gboolean
+entry_is_fresh (Entry *entry)
+{
+	return entry->info_time != 0 &&
+		g_get_monotonic_time () - entry->info_time < FILESYSTEM_INFO_MAX_AGE;
+}
+
+static void
+prune_entries_locked (void)
+{
+	GHashTableIter iter;
+	Entry *entry;
+
+	g_hash_table_iter_init (&iter, entries);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry)) {
+		if (!entry_is_busy (entry)) {
+			g_hash_table_iter_remove (&iter);
+			entry_free (entry);
+		}
+	}
+}
+
+/* Returns the mount point of a local location, or the scheme and
+ * host of a remote one. Nothing here touches the location itself,
+ * since that could block on the very mount it is on.
+ */
+static char *
+get_mount_locked (GFile *location)
+{
+	GList *l;
+	const char *mount_path, *best;
+	char *path, *uri, *end;
+	gsize length, best_length;
+
+	if (!g_file_is_native (location)) {
+		uri = g_file_get_uri (location);
+		end = strstr (uri, "://");
+		if (end != NULL) {
+			end = strchr (end + 3, '/');
+			if (end != NULL) {
+				*end = 0;
+			}
+		}
+		return uri;
+	}
+
+	if (unix_mounts == NULL || g_unix_mounts_changed_since (unix_mounts_time)) {
+		g_list_free_full (unix_mounts, (GDestroyNotify) g_unix_mount_free);
+		unix_mounts = g_unix_mounts_get (&unix_mounts_time);
+	}
+
+	path = g_file_get_path (location);
+	best = "/";
+	best_length = 1;
+	for (l = unix_mounts; l != NULL && path != NULL; l = l->next) {
+		mount_path = g_unix_mount_get_mount_path (l->data);
+		length = strlen (mount_path);
+		if (length > best_length &&
+		    strncmp (path, mount_path, length) == 0 &&
+		    (path[length] == '/' || path[length] == 0)) {
+			best = mount_path;
+			best_length = length;
+		}
+	}
+	g_free (path);
+
+	return g_strdup (best);
+}
+
+static Entry *
+get_entry_locked (GFile *location)
+{
+	Entry *entry;
+	char *uri;
+
+	uri = g_file_get_uri (location);
+	entry = g_hash_table_lookup (entries, uri);
+	if (entry != NULL) {
+		g_free (uri);
+		return entry;
+	}
+
+	if (g_hash_table_size (entries) >= FILESYSTEM_INFO_MAX_ENTRIES) {
+		prune_entries_locked ();
+	}
+
+	entry = g_new0 (Entry, 1);
+	entry->location = g_object_ref (location);
+	entry->uri = uri;
+	entry->mount = get_mount_locked (location);
+	g_hash_table_insert (entries, entry->uri, entry);
+
+	return entry;
+}
+
+static void
+start_query_locked (Entry *entry)
+{
+	GQueue *queue;
+
+	if (entry->querying) {
+		return;
+	}
+	entry->querying = TRUE;
+
+	queue = g_hash_table_lookup (busy_mounts, entry->mount);
+	if (queue != NULL) {
+		/* query_thread () starts it after the one running */
+		g_queue_push_tail (queue, entry);
+		return;
+	}
+
+	g_hash_table_insert (busy_mounts, g_strdup (entry->mount), g_queue_new ());
+	g_thread_pool_push (query_pool, entry, NULL);
+}
+
+static void
+query_done_locked (Entry *entry)
+{
+	GQueue *queue;
+	Entry *next;
+
+	entry->querying = FALSE;
+
+	queue = g_hash_table_lookup (busy_mounts, entry->mount);
+	next = g_queue_pop_head (queue);
+	if (next != NULL) {
+		g_thread_pool_push (query_pool, next, NULL);
+	} else {
+		g_queue_free (queue);
+		g_hash_table_remove (busy_mounts, entry->mount);
+	}
+}
+
+static gboolean
+answer_idle_callback (gpointer callback_data)
+{
+	Answer *answer;
+	Waiter *waiter;
+	GList *node;
+
+	answer = callback_data;
+
+	for (node = answer->waiters; node != NULL; node = node->next) {
+		waiter = node->data;
+		if (waiter->timeout_id != 0) {
+			g_source_remove (waiter->timeout_id);
+		}
+		(* waiter->callback) (answer->info, waiter->callback_data);
+		g_free (waiter);
+	}
+
+	g_list_free (answer->waiters);
+	if (answer->info != NULL) {
+		g_object_unref (answer->info);
+	}
+	g_free (answer);
+
+	return FALSE;
+}
+
+static void
+answer_later (GList *waiters, GFileInfo *info)
+{
+	Answer *answer;
+
+	answer = g_new0 (Answer, 1);
+	answer->waiters = waiters;
+	answer->info = info != NULL ? g_object_ref (info) : NULL;
+
+	g_idle_add (answer_idle_callback, answer);
+}
+
+static gboolean
+waiter_timeout_callback (gpointer callback_data)
+{
+	Waiter *waiter;
+
+	waiter = callback_data;
+
+	g_mutex_lock (entries_mutex);
+	if (waiter->answered) {
+		g_mutex_unlock (entries_mutex);
+		waiter->timeout_id = 0;
+		return FALSE;
+	}
+	/* The entry is kept as long as it has waiters. */
+	waiter->entry->waiters = g_list_remove (waiter->entry->waiters, waiter);
+	g_mutex_unlock (entries_mutex);
+
+	(* waiter->callback) (NULL, waiter->callback_data);
+	g_free (waiter);
+
+	return FALSE;
+}
+
+static void
+query_thread (gpointer data,
+	      gpointer user_data)
+{
+	Entry *entry;
+	GFileInfo *info;
+	GList *waiters, *node;
+	Waiter *waiter;
+
+	entry = data;
+
+	/* The location never changes, so it can be used unlocked. */
+	info = g_file_query_filesystem_info (entry->location,
+					     "filesystem::*",
+					     NULL, NULL);
+
+	g_mutex_lock (entries_mutex);
+
+	if (entry->info != NULL) {
+		g_object_unref (entry->info);
+	}
+	entry->info = info;
+	entry->info_time = g_get_monotonic_time ();
+	query_done_locked (entry);
+
+	waiters = entry->waiters;
+	entry->waiters = NULL;
+	for (node = waiters; node != NULL; node = node->next) {
+		waiter = node->data;
+		waiter->answered = TRUE;
+	}
+	if (waiters != NULL) {
+		answer_later (waiters, info);
+	}
+
+	g_cond_broadcast (entries_cond);
+	g_mutex_unlock (entries_mutex);
+}
+
+void
+nautilus_filesystem_info_query_async (GFile                          *location,
+				      NautilusFilesystemInfoCallback  callback,
+				      gpointer                        callback_data)
+{
+	Entry *entry;
+	Waiter *waiter;
+
+	g_return_if_fail (G_IS_FILE (location));
+
+	ensure_initialized ();
+
+	g_mutex_lock (entries_mutex);
+
+	entry = get_entry_locked (location);
+
+	if (entry_is_fresh (entry)) {
+		if (callback != NULL) {
+			waiter = g_new0 (Waiter, 1);
+			waiter->entry = entry;
+			waiter->callback = callback;
+			waiter->callback_data = callback_data;
+			answer_later (g_list_prepend (NULL, waiter), entry->info);
+		}
+		g_mutex_unlock (entries_mutex);
+		return;
+	}
+
+	start_query_locked (entry);
+
+	if (callback != NULL) {
+		waiter = g_new0 (Waiter, 1);
+		waiter->entry = entry;
+		waiter->callback = callback;
+		waiter->callback_data = callback_data;
+		waiter->timeout_id = g_timeout_add_seconds (FILESYSTEM_INFO_TIMEOUT_SECONDS,
+							    waiter_timeout_callback,
+							    waiter);
+		entry->waiters = g_list_prepend (entry->waiters, waiter);
+	}
+
+	g_mutex_unlock (entries_mutex);
+}
+
+/* With new_answer set, only an answer that came after the call will
+ * do instead of any fresh one.
+ */
+static GFileInfo *
+query_sync (GFile        *location,
+	    gboolean      new_answer,
+	    GCancellable *cancellable)
+{
+	Entry *entry;
+	GFileInfo *info;
+	GTimeVal wake_time;
+	gint64 asked, deadline;
+
+	g_return_val_if_fail (G_IS_FILE (location), NULL);
+
+	ensure_initialized ();
+
+	g_mutex_lock (entries_mutex);
+
+	entry = get_entry_locked (location);
+	asked = g_get_monotonic_time ();
+
+	if (new_answer || !entry_is_fresh (entry)) {
+		start_query_locked (entry);
+
+		entry->sync_waiters++;
+		deadline = asked + FILESYSTEM_INFO_TIMEOUT_SECONDS * G_USEC_PER_SEC;
+		while ((new_answer ? entry->info_time < asked : entry->querying) &&
+		       !g_cancellable_is_cancelled (cancellable) &&
+		       g_get_monotonic_time () < deadline) {
+			/* Wake up now and then to notice cancellation. */
+			g_get_current_time (&wake_time);
+			g_time_val_add (&wake_time, G_USEC_PER_SEC / 10);
+			g_cond_timed_wait (entries_cond, entries_mutex, &wake_time);
+		}
+		entry->sync_waiters--;
+	}
+
+	info = NULL;
+	if (entry->info != NULL &&
+	    (new_answer ? entry->info_time >= asked : entry_is_fresh (entry))) {
+		info = g_object_ref (entry->info);
+	}
+
+	g_mutex_unlock (entries_mutex);
+
+	return info;
+}
+
+GFileInfo *
+nautilus_filesystem_info_query_sync (GFile        *location,
+				     GCancellable *cancellable)
+{
+	return query_sync (location, FALSE, cancellable);
+}
+
+GFileInfo *
+nautilus_filesystem_info_query_new_sync (GFile        *location,
+					 GCancellable *cancellable)
+{
+	return query_sync (location, TRUE, cancellable);
+}
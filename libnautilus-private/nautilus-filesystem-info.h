@@ -0,0 +1,65 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*-
+
+   nautilus-filesystem-info.h: Shared, cached queries of filesystem
+   info that never block for long.
+
+   Copyright (C) 2011 The Nautilus contributors
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public
+   License along with this program; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+/* All "filesystem::*" attributes of a location are queried at once in
+ * a small pool of threads. Queries on different mounts run in parallel
+ * and those on the same mount one after the other, so a hung network
+ * mount takes up one thread and only holds up its own callers.
+ * Answers are kept for a couple of seconds and shared by everyone
+ * asking about the same location in that time. A query that takes
+ * too long is answered with NULL, just like one that failed.
+ */
+
+#ifndef NAUTILUS_FILESYSTEM_INFO_H
+#define NAUTILUS_FILESYSTEM_INFO_H
+
+#include <gio/gio.h>
+
+/* @info is NULL if the query failed or timed out. It is only valid
+ * during the callback.
+ */
+typedef void (* NautilusFilesystemInfoCallback) (GFileInfo *info,
+						 gpointer   callback_data);
+
+/* The callback is called exactly once, from the main loop, so this
+ * must be called from the main thread. With a NULL callback the query
+ * is only started, so that a later one finds the answer ready; that
+ * works from any thread.
+ */
+void       nautilus_filesystem_info_query_async (GFile                          *location,
+						 NautilusFilesystemInfoCallback  callback,
+						 gpointer                        callback_data);
+
+/* For job threads. Returns a new reference, or NULL on failure,
+ * timeout or cancellation.
+ */
+GFileInfo *nautilus_filesystem_info_query_sync  (GFile                          *location,
+						 GCancellable                   *cancellable);
+
+/* The same, without the kept answers, for when the free space has to
+ * be current.
+ */
+GFileInfo *nautilus_filesystem_info_query_new_sync (GFile                       *location,
+						    GCancellable                *cancellable);
+
+#endif /* NAUTILUS_FILESYSTEM_INFO_H */
@@ -1354,7 +1354,13 @@ real_map_pixbuf (NautilusIconCanvasItem *icon_item)
 	    icon_item->details->is_highlighted_for_clipboard) {
 		old_pixbuf = temp_pixbuf;
 
-		temp_pixbuf = eel_create_spotlight_pixbuf (temp_pixbuf);
+		/* the audio symbol below is drawn onto the pixbuf, so
+		 * that needs a copy of its own */
+		if (icon_item->details->is_active) {
+			temp_pixbuf = eel_create_spotlight_pixbuf (temp_pixbuf);
+		} else {
+			temp_pixbuf = eel_get_spotlight_pixbuf (temp_pixbuf);
+		}
 		g_object_unref (old_pixbuf);
 
 		/* FIXME bugzilla.gnome.org 42471: This hard-wired image is inappropriate to
@@ -1407,7 +1413,7 @@ real_map_pixbuf (NautilusIconCanvasItem *icon_item)
 			&NAUTILUS_ICON_CONTAINER (canvas)->details->highlight_color_rgba :
 			&NAUTILUS_ICON_CONTAINER (canvas)->details->active_color_rgba;
 
-		temp_pixbuf = eel_create_colorized_pixbuf (temp_pixbuf, color);
+		temp_pixbuf = eel_get_colorized_pixbuf (temp_pixbuf, color);
 
 		g_object_unref (old_pixbuf);
 	}
@@ -7490,6 +7490,50 @@ nautilus_icon_container_get_selection (NautilusIconContainer *container)
 	return g_list_reverse (list);
 }
 
+/**
+ * nautilus_icon_container_get_selection_count:
+ * @container: An icon container.
+ * 
+ * Return value: The number of icons currently selected in @container.
+ **/
+int
+nautilus_icon_container_get_selection_count (NautilusIconContainer *container)
+{
+	GList *p;
+	int count;
+
+	g_return_val_if_fail (NAUTILUS_IS_ICON_CONTAINER (container), 0);
+
+	count = 0;
+	for (p = container->details->icons; p != NULL; p = p->next) {
+		if (((NautilusIcon *) p->data)->is_selected) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/**
+ * nautilus_icon_container_is_data_selected:
+ * @container: An icon container.
+ * @data: The programmer-specified data of an icon.
+ * 
+ * Return value: TRUE if the icon for @data is selected in @container.
+ **/
+gboolean
+nautilus_icon_container_is_data_selected (NautilusIconContainer *container,
+					  NautilusIconData *data)
+{
+	NautilusIcon *icon;
+
+	g_return_val_if_fail (NAUTILUS_IS_ICON_CONTAINER (container), FALSE);
+
+	icon = g_hash_table_lookup (container->details->icon_set, data);
+
+	return icon != NULL && icon->is_selected;
+}
+
 static GList *
 nautilus_icon_container_get_selected_icons (NautilusIconContainer *container)
 {
@@ -294,6 +294,9 @@ void              nautilus_icon_container_select_all                    (Nautilu
 
 /* operations on the selection */
 GList     *       nautilus_icon_container_get_selection                 (NautilusIconContainer  *view);
+int               nautilus_icon_container_get_selection_count           (NautilusIconContainer  *view);
+gboolean          nautilus_icon_container_is_data_selected              (NautilusIconContainer  *view,
+									 NautilusIconData       *data);
 void			  nautilus_icon_container_invert_selection				(NautilusIconContainer  *view);
 void              nautilus_icon_container_set_selection                 (NautilusIconContainer  *view,
 									 GList                  *selection);
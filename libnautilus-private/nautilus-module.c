@@ -24,10 +24,32 @@
 
 #include <config.h>
 #include "nautilus-module.h"
+#include "nautilus-trace.h"
 
 #include <eel/eel-gtk-macros.h>
 #include <eel/eel-debug.h>
+#include <eel/eel-glib-extensions.h>
 #include <gmodule.h>
+#include <string.h>
+
+#define DEBUG_FLAG NAUTILUS_DEBUG_MODULES
+#include "nautilus-debug.h"
+
+/* An extension can come with a manifest, named like the module but
+ * ending in .nautilus-extension instead, that lists the interfaces
+ * its types implement:
+ *
+ *	[Nautilus Extension]
+ *	Interfaces=NautilusMenuProvider;NautilusInfoProvider;
+ *
+ * Such modules are not loaded at startup but the first time
+ * extensions for one of those interfaces are asked for, or when the
+ * main loop has nothing better to do. Modules without a manifest are
+ * loaded at startup.
+ */
+#define MANIFEST_SUFFIX ".nautilus-extension"
+#define MANIFEST_GROUP "Nautilus Extension"
+#define MANIFEST_KEY_INTERFACES "Interfaces"
 
 #define NAUTILUS_TYPE_MODULE    	(nautilus_module_get_type ())
 #define NAUTILUS_MODULE(obj)		(G_TYPE_CHECK_INSTANCE_CAST ((obj), NAUTILUS_TYPE_MODULE, NautilusModule))
@@ -51,6 +73,8 @@ struct _NautilusModule {
 	void (*list_types) (const GType **types,
 			    int          *num_types);
 
+	/* From the manifest, or NULL if there is none */
+	char **interfaces;
 };
 
 struct _NautilusModuleClass {
@@ -59,6 +83,18 @@ struct _NautilusModuleClass {
 
 static GList *module_objects = NULL;
 
+/* Modules with a manifest that weren't loaded yet */
+static GList *deferred_modules = NULL;
+static guint load_deferred_modules_idle_id = 0;
+
+typedef struct {
+	GType type;
+	NautilusModuleExtensionFunc func;
+	gpointer user_data;
+} ExtensionWatch;
+
+static GList *extension_watches = NULL;
+
 static GType nautilus_module_get_type (void);
 
 G_DEFINE_TYPE (NautilusModule, nautilus_module, G_TYPE_TYPE_MODULE);
@@ -144,6 +180,7 @@ nautilus_module_finalize (GObject *object)
 	module = NAUTILUS_MODULE (object);
 
 	g_free (module->path);
+	g_strfreev (module->interfaces);
 	
 	EEL_CALL_PARENT (G_OBJECT_CLASS, finalize, (object));
 }
@@ -184,6 +221,28 @@ add_module_objects (NautilusModule *module)
 	}
 }
 
+static gboolean
+nautilus_module_load_types (NautilusModule *module)
+{
+	gint64 start_time, trace_start;
+	gboolean loaded;
+
+	start_time = g_get_monotonic_time ();
+	NAUTILUS_TRACE_BEGIN (trace_start);
+
+	loaded = g_type_module_use (G_TYPE_MODULE (module));
+	if (loaded) {
+		add_module_objects (module);
+		g_type_module_unuse (G_TYPE_MODULE (module));
+	}
+
+	NAUTILUS_TRACE_END ("module", "load module", trace_start, module->path);
+	DEBUG ("%s %s in %.1f ms", loaded ? "Loaded" : "Failed to load",
+	       module->path, (g_get_monotonic_time () - start_time) / 1000.0);
+
+	return loaded;
+}
+
 static NautilusModule *
 nautilus_module_load_file (const char *filename)
 {
@@ -192,9 +251,7 @@ nautilus_module_load_file (const char *filename)
 	module = g_object_new (NAUTILUS_TYPE_MODULE, NULL);
 	module->path = g_strdup (filename);
 	
-	if (g_type_module_use (G_TYPE_MODULE (module))) {
-		add_module_objects (module);
-		g_type_module_unuse (G_TYPE_MODULE (module));
+	if (nautilus_module_load_types (module)) {
 		return module;
 	} else {
 		g_object_unref (module);
@@ -202,10 +259,40 @@ nautilus_module_load_file (const char *filename)
 	}
 }
 
+static char **
+read_module_manifest (const char *filename)
+{
+	GKeyFile *key_file;
+	char *base, *manifest;
+	char **interfaces;
+
+	base = g_strndup (filename, strlen (filename) - strlen ("." G_MODULE_SUFFIX));
+	manifest = g_strconcat (base, MANIFEST_SUFFIX, NULL);
+	g_free (base);
+
+	key_file = g_key_file_new ();
+	interfaces = NULL;
+	if (g_key_file_load_from_file (key_file, manifest, G_KEY_FILE_NONE, NULL)) {
+		interfaces = g_key_file_get_string_list (key_file,
+							 MANIFEST_GROUP,
+							 MANIFEST_KEY_INTERFACES,
+							 NULL, NULL);
+		if (interfaces == NULL) {
+			g_warning ("%s has no %s key", manifest, MANIFEST_KEY_INTERFACES);
+		}
+	}
+	g_key_file_free (key_file);
+	g_free (manifest);
+
+	return interfaces;
+}
+
 static void
 load_module_dir (const char *dirname)
 {
 	GDir *dir;
+	NautilusModule *module;
+	char **interfaces;
 	
 	dir = g_dir_open (dirname, 0, NULL);
 	
@@ -219,7 +306,16 @@ load_module_dir (const char *dirname)
 				filename = g_build_filename (dirname, 
 							     name, 
 							     NULL);
-				nautilus_module_load_file (filename);
+				interfaces = read_module_manifest (filename);
+				if (interfaces != NULL) {
+					module = g_object_new (NAUTILUS_TYPE_MODULE, NULL);
+					module->path = g_strdup (filename);
+					module->interfaces = interfaces;
+					deferred_modules = g_list_prepend (deferred_modules, module);
+					DEBUG ("Deferred loading %s", filename);
+				} else {
+					nautilus_module_load_file (filename);
+				}
 				g_free (filename);
 			}
 		}
@@ -228,6 +324,52 @@ load_module_dir (const char *dirname)
 	}
 }
 
+static void
+load_deferred_module (NautilusModule *module)
+{
+	deferred_modules = g_list_remove (deferred_modules, module);
+
+	/* The module object stays around if loading worked, like the
+	 * ones loaded at startup.
+	 */
+	if (!nautilus_module_load_types (module)) {
+		g_object_unref (module);
+	}
+}
+
+static void
+load_deferred_modules_for_type (GType type)
+{
+	GList *l, *next;
+	NautilusModule *module;
+	const char *type_name;
+
+	type_name = g_type_name (type);
+	for (l = deferred_modules; l != NULL; l = next) {
+		next = l->next;
+		module = l->data;
+
+		if (eel_g_strv_find (module->interfaces, type_name) != -1) {
+			load_deferred_module (module);
+		}
+	}
+}
+
+static gboolean
+load_deferred_modules_idle_callback (gpointer data)
+{
+	if (deferred_modules != NULL) {
+		load_deferred_module (deferred_modules->data);
+	}
+
+	if (deferred_modules == NULL) {
+		load_deferred_modules_idle_id = 0;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 static void
 free_module_objects (void)
 {
@@ -239,17 +381,42 @@ free_module_objects (void)
 	}
 	
 	g_list_free (module_objects);
+
+	if (load_deferred_modules_idle_id != 0) {
+		g_source_remove (load_deferred_modules_idle_id);
+		load_deferred_modules_idle_id = 0;
+	}
+	g_list_free_full (deferred_modules, g_object_unref);
+	deferred_modules = NULL;
+
+	g_list_free_full (extension_watches, g_free);
+	extension_watches = NULL;
 }
 
 void
 nautilus_module_setup (void)
 {
 	static gboolean initialized = FALSE;
+	gint64 start_time;
 
 	if (!initialized) {
 		initialized = TRUE;
 		
+		start_time = g_get_monotonic_time ();
 		load_module_dir (NAUTILUS_EXTENSIONDIR);
+		DEBUG ("Module setup took %.1f ms, %d modules deferred",
+		       (g_get_monotonic_time () - start_time) / 1000.0,
+		       g_list_length (deferred_modules));
+
+		/* Load the deferred modules one at a time once startup
+		 * is done, so they are usually ready when first needed.
+		 */
+		if (deferred_modules != NULL) {
+			load_deferred_modules_idle_id =
+				g_idle_add_full (G_PRIORITY_LOW,
+						 load_deferred_modules_idle_callback,
+						 NULL, NULL);
+		}
 
 		eel_debug_call_at_shutdown (free_module_objects);
 	}
@@ -260,6 +427,8 @@ nautilus_module_get_extensions_for_type (GType type)
 {
 	GList *l;
 	GList *ret = NULL;
+
+	load_deferred_modules_for_type (type);
 	
 	for (l = module_objects; l != NULL; l = l->next) {
 		if (G_TYPE_CHECK_INSTANCE_TYPE (G_OBJECT (l->data),
@@ -288,6 +457,8 @@ void
 nautilus_module_add_type (GType type)
 {
 	GObject *object;
+	GList *l;
+	ExtensionWatch *watch;
 	
 	object = g_object_new (type, NULL);
 	g_object_weak_ref (object, 
@@ -295,4 +466,40 @@ nautilus_module_add_type (GType type)
 			   NULL);
 
 	module_objects = g_list_prepend (module_objects, object);
+
+	for (l = extension_watches; l != NULL; l = l->next) {
+		watch = l->data;
+		if (G_TYPE_CHECK_INSTANCE_TYPE (object, watch->type)) {
+			watch->func (object, watch->user_data);
+		}
+	}
+}
+
+/**
+ * nautilus_module_watch_extensions:
+ *
+ * Calls @func for each extension object of @type, both the existing
+ * ones and the ones from modules loaded later. Unlike
+ * nautilus_module_get_extensions_for_type(), this doesn't load any
+ * modules.
+ */
+void
+nautilus_module_watch_extensions (GType type,
+				  NautilusModuleExtensionFunc func,
+				  gpointer user_data)
+{
+	ExtensionWatch *watch;
+	GList *l;
+
+	watch = g_new (ExtensionWatch, 1);
+	watch->type = type;
+	watch->func = func;
+	watch->user_data = user_data;
+	extension_watches = g_list_prepend (extension_watches, watch);
+
+	for (l = module_objects; l != NULL; l = l->next) {
+		if (G_TYPE_CHECK_INSTANCE_TYPE (G_OBJECT (l->data), type)) {
+			func (l->data, user_data);
+		}
+	}
 }
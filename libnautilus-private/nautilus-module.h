@@ -28,9 +28,15 @@
 
 G_BEGIN_DECLS
 
+typedef void (* NautilusModuleExtensionFunc) (GObject  *extension,
+					      gpointer  user_data);
+
 void   nautilus_module_setup                   (void);
 GList *nautilus_module_get_extensions_for_type (GType  type);
 void   nautilus_module_extension_list_free     (GList *list);
+void   nautilus_module_watch_extensions        (GType                       type,
+						NautilusModuleExtensionFunc func,
+						gpointer                    user_data);
 
 
 /* Add a type to the module interface - allows nautilus to add its own modules
@@ -23,7 +23,6 @@
 */
 
 #include <config.h>
-#include <math.h>
 #include <glib/gi18n.h>
 #include <eel/eel-string.h>
 #include <eel/eel-glib-extensions.h>
@@ -47,12 +46,14 @@ struct _NautilusProgressInfo
 {
 	GObject parent_instance;
 	
+	/* Each info has its own lock, so jobs don't wait for each other */
+	GMutex *mutex;
+
 	GCancellable *cancellable;
 	
 	char *status;
 	char *details;
 	double progress;
-	gboolean activity_mode;
 	gboolean started;
 	gboolean finished;
 	gboolean paused;
@@ -62,8 +63,14 @@ struct _NautilusProgressInfo
 	
 	gboolean start_at_idle;
 	gboolean finish_at_idle;
-	gboolean changed_at_idle;
-	gboolean progress_at_idle;
+
+	/* Changed with the lock held, but also read without it to skip
+	 * updates that wouldn't show before the next signal anyway.
+	 */
+	volatile gint activity_mode;
+	volatile gint shown_progress; /* progress in 1/1000 */
+	volatile gint changed_at_idle;
+	volatile gint progress_at_idle;
 };
 
 struct _NautilusProgressInfoClass
@@ -71,8 +78,6 @@ struct _NautilusProgressInfoClass
 	GObjectClass parent_class;
 };
 
-G_LOCK_DEFINE_STATIC(progress_info);
-
 G_DEFINE_TYPE (NautilusProgressInfo, nautilus_progress_info, G_TYPE_OBJECT)
 
 static void
@@ -85,39 +90,19 @@ nautilus_progress_info_finalize (GObject *object)
 	g_free (info->status);
 	g_free (info->details);
 	g_object_unref (info->cancellable);
+	g_mutex_free (info->mutex);
 	
 	if (G_OBJECT_CLASS (nautilus_progress_info_parent_class)->finalize) {
 		(*G_OBJECT_CLASS (nautilus_progress_info_parent_class)->finalize) (object);
 	}
 }
 
-static void
-nautilus_progress_info_dispose (GObject *object)
-{
-	NautilusProgressInfo *info;
-	
-	info = NAUTILUS_PROGRESS_INFO (object);
-
-	G_LOCK (progress_info);
-
-	/* Destroy source in dispose, because the callback
-	   could come here before the destroy, which should
-	   ressurect the object for a while */
-	if (info->idle_source) {
-		g_source_destroy (info->idle_source);
-		g_source_unref (info->idle_source);
-		info->idle_source = NULL;
-	}
-	G_UNLOCK (progress_info);
-}
-
 static void
 nautilus_progress_info_class_init (NautilusProgressInfoClass *klass)
 {
 	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
 	
 	gobject_class->finalize = nautilus_progress_info_finalize;
-	gobject_class->dispose = nautilus_progress_info_dispose;
 	
 	signals[CHANGED] =
 		g_signal_new ("changed",
@@ -162,6 +147,7 @@ nautilus_progress_info_init (NautilusProgressInfo *info)
 {
 	NautilusProgressInfoManager *manager;
 
+	info->mutex = g_mutex_new ();
 	info->cancellable = g_cancellable_new ();
 
 	manager = nautilus_progress_info_manager_new ();
@@ -184,7 +170,7 @@ nautilus_progress_info_get_status (NautilusProgressInfo *info)
 {
 	char *res;
 	
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 	
 	if (info->status) {
 		res = g_strdup (info->status);
@@ -192,7 +178,7 @@ nautilus_progress_info_get_status (NautilusProgressInfo *info)
 		res = g_strdup (_("Preparing"));
 	}
 	
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 	
 	return res;
 }
@@ -202,7 +188,7 @@ nautilus_progress_info_get_details (NautilusProgressInfo *info)
 {
 	char *res;
 	
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 	
 	if (info->details) {
 		res = g_strdup (info->details);
@@ -210,7 +196,7 @@ nautilus_progress_info_get_details (NautilusProgressInfo *info)
 		res = g_strdup (_("Preparing"));
 	}
 	
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 
 	return res;
 }
@@ -220,7 +206,7 @@ nautilus_progress_info_get_progress (NautilusProgressInfo *info)
 {
 	double res;
 	
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 
 	if (info->activity_mode) {
 		res = -1.0;
@@ -228,7 +214,7 @@ nautilus_progress_info_get_progress (NautilusProgressInfo *info)
 		res = info->progress;
 	}
 	
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 	
 	return res;
 }
@@ -236,11 +222,11 @@ nautilus_progress_info_get_progress (NautilusProgressInfo *info)
 void
 nautilus_progress_info_cancel (NautilusProgressInfo *info)
 {
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 	
 	g_cancellable_cancel (info->cancellable);
 	
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 }
 
 GCancellable *
@@ -248,11 +234,11 @@ nautilus_progress_info_get_cancellable (NautilusProgressInfo *info)
 {
 	GCancellable *c;
 	
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 	
 	c = g_object_ref (info->cancellable);
 	
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 	
 	return c;
 }
@@ -262,11 +248,11 @@ nautilus_progress_info_get_is_started (NautilusProgressInfo *info)
 {
 	gboolean res;
 	
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 	
 	res = info->started;
 	
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 	
 	return res;
 }
@@ -276,11 +262,11 @@ nautilus_progress_info_get_is_finished (NautilusProgressInfo *info)
 {
 	gboolean res;
 	
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 	
 	res = info->finished;
 	
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 	
 	return res;
 }
@@ -290,11 +276,11 @@ nautilus_progress_info_get_is_paused (NautilusProgressInfo *info)
 {
 	gboolean res;
 	
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 	
 	res = info->paused;
 	
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 	
 	return res;
 }
@@ -311,24 +297,18 @@ idle_callback (gpointer data)
 
 	source = g_main_current_source ();
 	
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 
 	/* Protect agains races where the source has
-	   been destroyed on another thread while it
-	   was being dispatched.
-	   Similar to what gdk_threads_add_idle does.
+	   been replaced on another thread while it
+	   was being dispatched. The source holds a ref
+	   on the info, so that is still alive.
 	*/
 	if (g_source_is_destroyed (source)) {
-		G_UNLOCK (progress_info);
+		g_mutex_unlock (info->mutex);
 		return FALSE;
 	}
 
-	/* We hadn't destroyed the source, so take a ref.
-	 * This might ressurect the object from dispose, but
-	 * that should be ok.
-	 */
-	g_object_ref (info);
-
 	g_assert (source == info->idle_source);
 	
 	g_source_unref (source);
@@ -341,10 +321,10 @@ idle_callback (gpointer data)
 	
 	info->start_at_idle = FALSE;
 	info->finish_at_idle = FALSE;
-	info->changed_at_idle = FALSE;
-	info->progress_at_idle = FALSE;
+	g_atomic_int_set (&info->changed_at_idle, FALSE);
+	g_atomic_int_set (&info->progress_at_idle, FALSE);
 	
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 	
 	if (start_at_idle) {
 		g_signal_emit (info,
@@ -370,8 +350,6 @@ idle_callback (gpointer data)
 			       0);
 	}
 	
-	g_object_unref (info);
-	
 	return FALSE;
 }
 
@@ -393,7 +371,8 @@ queue_idle (NautilusProgressInfo *info, gboolean now)
 		} else {
 			info->idle_source = g_timeout_source_new (SIGNAL_DELAY_MSEC);
 		}
-		g_source_set_callback (info->idle_source, idle_callback, info, NULL);
+		g_source_set_callback (info->idle_source, idle_callback,
+				       g_object_ref (info), g_object_unref);
 		g_source_attach (info->idle_source, NULL);
 	}
 }
@@ -401,31 +380,31 @@ queue_idle (NautilusProgressInfo *info, gboolean now)
 void
 nautilus_progress_info_pause (NautilusProgressInfo *info)
 {
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 
 	if (!info->paused) {
 		info->paused = TRUE;
 	}
 
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 }
 
 void
 nautilus_progress_info_resume (NautilusProgressInfo *info)
 {
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 
 	if (info->paused) {
 		info->paused = FALSE;
 	}
 
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 }
 
 void
 nautilus_progress_info_start (NautilusProgressInfo *info)
 {
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 	
 	if (!info->started) {
 		info->started = TRUE;
@@ -434,13 +413,13 @@ nautilus_progress_info_start (NautilusProgressInfo *info)
 		queue_idle (info, TRUE);
 	}
 	
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 }
 
 void
 nautilus_progress_info_finish (NautilusProgressInfo *info)
 {
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 	
 	if (!info->finished) {
 		info->finished = TRUE;
@@ -449,43 +428,43 @@ nautilus_progress_info_finish (NautilusProgressInfo *info)
 		queue_idle (info, TRUE);
 	}
 	
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 }
 
 void
 nautilus_progress_info_take_status (NautilusProgressInfo *info,
 				    char *status)
 {
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 	
 	if (eel_strcmp (info->status, status) != 0) {
 		g_free (info->status);
 		info->status = status;
 		
-		info->changed_at_idle = TRUE;
+		g_atomic_int_set (&info->changed_at_idle, TRUE);
 		queue_idle (info, FALSE);
 	} else {
 		g_free (status);
 	}
 	
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 }
 
 void
 nautilus_progress_info_set_status (NautilusProgressInfo *info,
 				   const char *status)
 {
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 	
 	if (eel_strcmp (info->status, status) != 0) {
 		g_free (info->status);
 		info->status = g_strdup (status);
 		
-		info->changed_at_idle = TRUE;
+		g_atomic_int_set (&info->changed_at_idle, TRUE);
 		queue_idle (info, FALSE);
 	}
 	
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 }
 
 
@@ -493,49 +472,62 @@ void
 nautilus_progress_info_take_details (NautilusProgressInfo *info,
 				     char           *details)
 {
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 	
 	if (eel_strcmp (info->details, details) != 0) {
 		g_free (info->details);
 		info->details = details;
 		
-		info->changed_at_idle = TRUE;
+		g_atomic_int_set (&info->changed_at_idle, TRUE);
 		queue_idle (info, FALSE);
 	} else {
 		g_free (details);
 	}
   
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 }
 
 void
 nautilus_progress_info_set_details (NautilusProgressInfo *info,
 				    const char           *details)
 {
-	G_LOCK (progress_info);
+	g_mutex_lock (info->mutex);
 	
 	if (eel_strcmp (info->details, details) != 0) {
 		g_free (info->details);
 		info->details = g_strdup (details);
 		
-		info->changed_at_idle = TRUE;
+		g_atomic_int_set (&info->changed_at_idle, TRUE);
 		queue_idle (info, FALSE);
 	}
   
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
+}
+
+gboolean
+nautilus_progress_info_get_wants_text (NautilusProgressInfo *info)
+{
+	return !g_atomic_int_get (&info->changed_at_idle);
 }
 
 void
 nautilus_progress_info_pulse_progress (NautilusProgressInfo *info)
 {
-	G_LOCK (progress_info);
+	/* Nothing new to show until the pending pulse is emitted */
+	if (g_atomic_int_get (&info->activity_mode) &&
+	    g_atomic_int_get (&info->progress_at_idle)) {
+		return;
+	}
 
-	info->activity_mode = TRUE;
+	g_mutex_lock (info->mutex);
+
+	g_atomic_int_set (&info->activity_mode, TRUE);
 	info->progress = 0.0;
-	info->progress_at_idle = TRUE;
+	g_atomic_int_set (&info->shown_progress, 0);
+	g_atomic_int_set (&info->progress_at_idle, TRUE);
 	queue_idle (info, FALSE);
 	
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 }
 
 void
@@ -559,16 +551,21 @@ nautilus_progress_info_set_progress (NautilusProgressInfo *info,
 		}
 	}
 	
-	G_LOCK (progress_info);
-	
-	if (info->activity_mode || /* emit on switch from activity mode */
-	    fabs (current_percent - info->progress) > 0.005 /* Emit on change of 0.5 percent */
-	    ) {
-		info->activity_mode = FALSE;
-		info->progress = current_percent;
-		info->progress_at_idle = TRUE;
-		queue_idle (info, FALSE);
+	/* Emit on switch from activity mode or on change of 0.5 percent.
+	 * Most calls do neither, so check that without the lock.
+	 */
+	if (!g_atomic_int_get (&info->activity_mode) &&
+	    ABS ((int) (current_percent * 1000) - g_atomic_int_get (&info->shown_progress)) <= 5) {
+		return;
 	}
+
+	g_mutex_lock (info->mutex);
+	
+	g_atomic_int_set (&info->activity_mode, FALSE);
+	info->progress = current_percent;
+	g_atomic_int_set (&info->shown_progress, (int) (current_percent * 1000));
+	g_atomic_int_set (&info->progress_at_idle, TRUE);
+	queue_idle (info, FALSE);
 	
-	G_UNLOCK (progress_info);
+	g_mutex_unlock (info->mutex);
 }
@@ -62,6 +62,11 @@ void          nautilus_progress_info_cancel          (NautilusProgressInfo *info
 gboolean      nautilus_progress_info_get_is_started  (NautilusProgressInfo *info);
 gboolean      nautilus_progress_info_get_is_finished (NautilusProgressInfo *info);
 gboolean      nautilus_progress_info_get_is_paused   (NautilusProgressInfo *info);
+/* FALSE while the last status or details are still waiting to be
+ * emitted, so jobs can skip formatting texts nobody would see.
+ * Takes no lock, so it is cheap to call often.
+ */
+gboolean      nautilus_progress_info_get_wants_text  (NautilusProgressInfo *info);
 
 void          nautilus_progress_info_start           (NautilusProgressInfo *info);
 void          nautilus_progress_info_finish          (NautilusProgressInfo *info);
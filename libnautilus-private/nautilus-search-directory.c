@@ -467,21 +467,27 @@ search_engine_hits_added (NautilusSearchEngine *engine, GList *hits,
 	GList *hit_list;
 	GList *file_list;
 	NautilusFile *file;
-	char *uri;
+	NautilusSearchHit *hit;
 	SearchMonitor *monitor;
 	GList *monitor_list;
 
 	file_list = NULL;
 
 	for (hit_list = hits; hit_list != NULL; hit_list = hit_list->next) {
-		uri = hit_list->data;
+		hit = hit_list->data;
 
-		if (g_str_has_suffix (uri, NAUTILUS_SAVED_SEARCH_EXTENSION)) {
+		if (g_str_has_suffix (hit->uri, NAUTILUS_SAVED_SEARCH_EXTENSION)) {
 			/* Never return saved searches themselves as hits */
 			continue;
 		}
 		
-		file = nautilus_file_get_by_uri (uri);
+		file = nautilus_file_get_by_uri (hit->uri);
+
+		/* Use the info the engine found, unless the file is
+		 * already known and up to date */
+		if (hit->info != NULL && !file->details->file_info_is_up_to_date) {
+			nautilus_file_update_info (file, hit->info);
+		}
 		
 		for (monitor_list = search->details->monitor_list; monitor_list; monitor_list = monitor_list->next) {
 			monitor = monitor_list->data;
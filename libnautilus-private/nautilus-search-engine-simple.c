@@ -23,6 +23,7 @@
 
 #include <config.h>
 #include "nautilus-search-engine-simple.h"
+#include "nautilus-file-private.h"
 
 #include <string.h>
 #include <glib.h>
@@ -44,7 +45,7 @@ typedef struct {
 	GHashTable *visited;
 	
 	gint n_processed_files;
-	GList *uri_hits;
+	GList *hits;
 } SearchThreadData;
 
 
@@ -132,7 +133,7 @@ search_thread_data_free (SearchThreadData *data)
 	g_object_unref (data->cancellable);
 	g_strfreev (data->words);	
 	g_list_free_full (data->mime_types, g_free);
-	g_list_free_full (data->uri_hits, g_free);
+	g_list_free_full (data->hits, (GDestroyNotify) nautilus_search_hit_free);
 	g_free (data);
 }
 
@@ -154,7 +155,7 @@ search_thread_done_idle (gpointer user_data)
 }
 
 typedef struct {
-	GList *uris;
+	GList *hits;
 	SearchThreadData *thread_data;
 } SearchHits;
 
@@ -168,10 +169,10 @@ search_thread_add_hits_idle (gpointer user_data)
 
 	if (!g_cancellable_is_cancelled (hits->thread_data->cancellable)) {
 		nautilus_search_engine_hits_added (NAUTILUS_SEARCH_ENGINE (hits->thread_data->engine),
-						   hits->uris);
+						   hits->hits);
 	}
 
-	g_list_free_full (hits->uris, g_free);
+	g_list_free_full (hits->hits, (GDestroyNotify) nautilus_search_hit_free);
 	g_free (hits);
 	
 	return FALSE;
@@ -184,13 +185,13 @@ send_batch (SearchThreadData *data)
 	
 	data->n_processed_files = 0;
 	
-	if (data->uri_hits) {
+	if (data->hits) {
 		hits = g_new (SearchHits, 1);
-		hits->uris = data->uri_hits;
+		hits->hits = data->hits;
 		hits->thread_data = data;
 		g_idle_add (search_thread_add_hits_idle, hits);
 	}
-	data->uri_hits = NULL;
+	data->hits = NULL;
 }
 
 #define STD_ATTRIBUTES \
@@ -200,6 +201,30 @@ send_batch (SearchThreadData *data)
 	G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
 	G_FILE_ATTRIBUTE_ID_FILE
 
+/* Hits are usually few compared to the files crawled, so only they get
+ * the full attribute set that NautilusFile wants. Doing it here in the
+ * thread saves the async code from querying every result again, one at
+ * a time, once it shows up in the view.
+ */
+static NautilusSearchHit *
+search_hit_new_for_file (GFile *file, SearchThreadData *data)
+{
+	NautilusSearchHit *hit;
+	GFileInfo *info;
+	char *uri;
+
+	info = g_file_query_info (file, NAUTILUS_FILE_DEFAULT_ATTRIBUTES,
+				  0, data->cancellable, NULL);
+	uri = g_file_get_uri (file);
+	hit = nautilus_search_hit_new (uri, info);
+	g_free (uri);
+	if (info != NULL) {
+		g_object_unref (info);
+	}
+
+	return hit;
+}
+
 static void
 visit_directory (GFile *dir, SearchThreadData *data)
 {
@@ -265,7 +290,7 @@ visit_directory (GFile *dir, SearchThreadData *data)
 		child = g_file_get_child (dir, g_file_info_get_name (info));
 		
 		if (hit) {
-			data->uri_hits = g_list_prepend (data->uri_hits, g_file_get_uri (child));
+			data->hits = g_list_prepend (data->hits, search_hit_new_for_file (child, data));
 		}
 		
 		data->n_processed_files++;
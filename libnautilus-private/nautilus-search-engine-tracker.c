@@ -200,6 +200,7 @@ cursor_callback (GObject      *object,
 	GError *error = NULL;
 	TrackerSparqlCursor *cursor;
 	GList *hits;
+	NautilusSearchHit *hit;
 	gboolean success;
 
 	tracker = NAUTILUS_SEARCH_ENGINE_TRACKER (user_data);
@@ -229,9 +230,11 @@ cursor_callback (GObject      *object,
 	}
 
 	/* We iterate result by result, not n at a time. */
-	hits = g_list_append (NULL, (gchar*) tracker_sparql_cursor_get_string (cursor, 0, NULL));
+	hit = nautilus_search_hit_new (tracker_sparql_cursor_get_string (cursor, 0, NULL), NULL);
+	hits = g_list_append (NULL, hit);
 	nautilus_search_engine_hits_added (NAUTILUS_SEARCH_ENGINE (tracker), hits);
 	g_list_free (hits);
+	nautilus_search_hit_free (hit);
 
 	/* Get next */
 	cursor_next (tracker, cursor);
@@ -171,6 +171,28 @@ nautilus_search_engine_is_indexed (NautilusSearchEngine *engine)
 	return NAUTILUS_SEARCH_ENGINE_GET_CLASS (engine)->is_indexed (engine);
 }
 
+NautilusSearchHit *
+nautilus_search_hit_new (const char *uri, GFileInfo *info)
+{
+	NautilusSearchHit *hit;
+
+	hit = g_new (NautilusSearchHit, 1);
+	hit->uri = g_strdup (uri);
+	hit->info = info != NULL ? g_object_ref (info) : NULL;
+
+	return hit;
+}
+
+void
+nautilus_search_hit_free (NautilusSearchHit *hit)
+{
+	g_free (hit->uri);
+	if (hit->info != NULL) {
+		g_object_unref (hit->info);
+	}
+	g_free (hit);
+}
+
 void	       
 nautilus_search_engine_hits_added (NautilusSearchEngine *engine, GList *hits)
 {
@@ -25,6 +25,7 @@
 #define NAUTILUS_SEARCH_ENGINE_H
 
 #include <glib-object.h>
+#include <gio/gio.h>
 #include <libnautilus-private/nautilus-query.h>
 
 #define NAUTILUS_TYPE_SEARCH_ENGINE		(nautilus_search_engine_get_type ())
@@ -41,6 +42,16 @@ typedef struct NautilusSearchEngine {
 	NautilusSearchEngineDetails *details;
 } NautilusSearchEngine;
 
+/* The elements of the list passed with "hits-added". Engines that
+ * already have a GFileInfo with NAUTILUS_FILE_DEFAULT_ATTRIBUTES for a
+ * hit pass it along, so the file doesn't have to be queried again;
+ * otherwise info is NULL.
+ */
+typedef struct {
+	char *uri;
+	GFileInfo *info;
+} NautilusSearchHit;
+
 typedef struct {
 	GObjectClass parent_class;
 	
@@ -67,6 +78,9 @@ void	       nautilus_search_engine_start (NautilusSearchEngine *engine);
 void	       nautilus_search_engine_stop (NautilusSearchEngine *engine);
 gboolean       nautilus_search_engine_is_indexed (NautilusSearchEngine *engine);
 
+NautilusSearchHit *nautilus_search_hit_new (const char *uri, GFileInfo *info);
+void	       nautilus_search_hit_free (NautilusSearchHit *hit);
+
 void	       nautilus_search_engine_hits_added (NautilusSearchEngine *engine, GList *hits);
 void	       nautilus_search_engine_hits_subtracted (NautilusSearchEngine *engine, GList *hits);
 void	       nautilus_search_engine_finished (NautilusSearchEngine *engine);
@@ -39,6 +39,7 @@ enum {
 	POPUP_MENU_CHANGED,
 	USER_DIRS_CHANGED,
 	MIME_DATA_CHANGED,
+	USERS_GROUPS_CHANGED,
 	LAST_SIGNAL
 };
 
@@ -101,4 +102,12 @@ nautilus_signaller_class_init (NautilusSignallerClass *class)
 		              NULL, NULL,
 		              g_cclosure_marshal_VOID__VOID,
 		              G_TYPE_NONE, 0);
+	signals[USERS_GROUPS_CHANGED] =
+		g_signal_new ("users_groups_changed",
+		              G_TYPE_FROM_CLASS (class),
+		              G_SIGNAL_RUN_LAST,
+		              0,
+		              NULL, NULL,
+		              g_cclosure_marshal_VOID__POINTER,
+		              G_TYPE_NONE, 1, G_TYPE_POINTER);
 }
@@ -320,6 +320,38 @@ nautilus_thumbnail_unframe_image (GdkPixbuf *pixbuf)
 	return pixbuf_without_frame;
 }
 
+/* Returns a list of copies of pixbuf, each half the size of the one
+ * before it, down to NAUTILUS_ICON_SIZE_SMALLEST. Scaling a thumbnail
+ * for display from the closest of these is much cheaper than scaling
+ * the full one. Doesn't touch any global state, so it can be called
+ * from any thread.
+ */
+GList *
+nautilus_thumbnail_make_mipmaps (GdkPixbuf *pixbuf)
+{
+	GList *mipmaps;
+	GdkPixbuf *mipmap;
+	int width, height;
+
+	mipmaps = NULL;
+	width = gdk_pixbuf_get_width (pixbuf) / 2;
+	height = gdk_pixbuf_get_height (pixbuf) / 2;
+	while (MAX (width, height) >= NAUTILUS_ICON_SIZE_SMALLEST &&
+	       MIN (width, height) > 0) {
+		mipmap = gdk_pixbuf_scale_simple (pixbuf, width, height,
+						  GDK_INTERP_BILINEAR);
+		if (mipmap == NULL) {
+			break;
+		}
+		mipmaps = g_list_prepend (mipmaps, mipmap);
+		pixbuf = mipmap;
+		width /= 2;
+		height /= 2;
+	}
+
+	return g_list_reverse (mipmaps);
+}
+
 void
 nautilus_thumbnail_remove_from_queue (const char *file_uri)
 {
@@ -745,3 +777,204 @@ thumbnail_thread_start (gpointer data)
 				 g_strdup (info->image_uri), NULL);
 	}
 }
+
+/*
+ * Cache of decoded thumbnails.
+ *
+ * Loaded thumbnails otherwise only live as long as their NautilusFile,
+ * so going back to a folder would read and decode all of them again.
+ * The cache is only used from the main thread.
+ */
+
+typedef struct {
+	char *path;
+	time_t mtime;
+	int size;
+	GdkPixbuf *pixbuf;
+	gsize bytes;
+	GList *link; /* in thumbnail_cache_lru, most recently used first */
+} ThumbnailCacheEntry;
+
+static GHashTable *thumbnail_cache = NULL;
+static GQueue thumbnail_cache_lru = G_QUEUE_INIT;
+static gsize thumbnail_cache_bytes = 0;
+static gsize thumbnail_cache_max_bytes = 0;
+static guint thumbnail_cache_hits = 0;
+static guint thumbnail_cache_misses = 0;
+
+static guint
+thumbnail_cache_entry_hash (gconstpointer p)
+{
+	const ThumbnailCacheEntry *entry;
+
+	entry = p;
+	return g_str_hash (entry->path) ^ (guint) entry->mtime ^ (guint) entry->size;
+}
+
+static gboolean
+thumbnail_cache_entry_equal (gconstpointer a,
+			     gconstpointer b)
+{
+	const ThumbnailCacheEntry *entry_a, *entry_b;
+
+	entry_a = a;
+	entry_b = b;
+	return entry_a->mtime == entry_b->mtime &&
+		entry_a->size == entry_b->size &&
+		strcmp (entry_a->path, entry_b->path) == 0;
+}
+
+static void
+thumbnail_cache_entry_free (ThumbnailCacheEntry *entry)
+{
+	g_free (entry->path);
+	g_object_unref (entry->pixbuf);
+	g_free (entry);
+}
+
+static void
+thumbnail_cache_remove (ThumbnailCacheEntry *entry)
+{
+	g_queue_delete_link (&thumbnail_cache_lru, entry->link);
+	thumbnail_cache_bytes -= entry->bytes;
+	/* Frees the entry */
+	g_hash_table_remove (thumbnail_cache, entry);
+}
+
+static void
+thumbnail_cache_trim (void)
+{
+	while (thumbnail_cache_bytes > thumbnail_cache_max_bytes &&
+	       thumbnail_cache_lru.tail != NULL) {
+		thumbnail_cache_remove (thumbnail_cache_lru.tail->data);
+	}
+}
+
+static void
+thumbnail_cache_size_changed_callback (gpointer user_data)
+{
+	int megabytes;
+
+	megabytes = g_settings_get_int (nautilus_preferences,
+					NAUTILUS_PREFERENCES_THUMBNAIL_CACHE_SIZE);
+	thumbnail_cache_max_bytes = (gsize) MAX (megabytes, 0) * 1024 * 1024;
+	thumbnail_cache_trim ();
+}
+
+static void
+thumbnail_cache_free (void)
+{
+#ifdef DEBUG_THUMBNAILS
+	g_print ("thumbnail cache: %u hits, %u misses, %" G_GSIZE_FORMAT " bytes\n",
+		 thumbnail_cache_hits, thumbnail_cache_misses, thumbnail_cache_bytes);
+#endif
+	g_queue_clear (&thumbnail_cache_lru);
+	g_hash_table_destroy (thumbnail_cache);
+	thumbnail_cache = NULL;
+	thumbnail_cache_bytes = 0;
+}
+
+static GHashTable *
+get_thumbnail_cache (void)
+{
+	if (thumbnail_cache == NULL) {
+		thumbnail_cache = g_hash_table_new_full (thumbnail_cache_entry_hash,
+							 thumbnail_cache_entry_equal,
+							 (GDestroyNotify) thumbnail_cache_entry_free,
+							 NULL);
+		eel_debug_call_at_shutdown (thumbnail_cache_free);
+
+		thumbnail_cache_size_changed_callback (NULL);
+		g_signal_connect_swapped (nautilus_preferences,
+					  "changed::" NAUTILUS_PREFERENCES_THUMBNAIL_CACHE_SIZE,
+					  G_CALLBACK (thumbnail_cache_size_changed_callback),
+					  NULL);
+	}
+
+	return thumbnail_cache;
+}
+
+/* Returns a new reference to the cached thumbnail of a file with the
+ * given modification time, decoded for the given thumbnail size, or
+ * NULL if there is none.
+ */
+GdkPixbuf *
+nautilus_thumbnail_cache_lookup (const char *path,
+				 time_t      mtime,
+				 int         size)
+{
+	ThumbnailCacheEntry key, *entry;
+
+	key.path = (char *) path;
+	key.mtime = mtime;
+	key.size = size;
+
+	entry = g_hash_table_lookup (get_thumbnail_cache (), &key);
+	if (entry == NULL) {
+		thumbnail_cache_misses++;
+		return NULL;
+	}
+
+	thumbnail_cache_hits++;
+
+	/* Move to the front of the LRU list */
+	g_queue_unlink (&thumbnail_cache_lru, entry->link);
+	g_queue_push_head_link (&thumbnail_cache_lru, entry->link);
+
+	return g_object_ref (entry->pixbuf);
+}
+
+void
+nautilus_thumbnail_cache_insert (const char *path,
+				 time_t      mtime,
+				 int         size,
+				 GdkPixbuf  *pixbuf)
+{
+	ThumbnailCacheEntry key, *entry;
+	GHashTable *cache;
+	gsize bytes;
+
+	cache = get_thumbnail_cache ();
+
+	bytes = (gsize) gdk_pixbuf_get_rowstride (pixbuf) * gdk_pixbuf_get_height (pixbuf);
+	if (bytes > thumbnail_cache_max_bytes) {
+		return;
+	}
+
+	key.path = (char *) path;
+	key.mtime = mtime;
+	key.size = size;
+	entry = g_hash_table_lookup (cache, &key);
+	if (entry != NULL) {
+		thumbnail_cache_remove (entry);
+	}
+
+	entry = g_new0 (ThumbnailCacheEntry, 1);
+	entry->path = g_strdup (path);
+	entry->mtime = mtime;
+	entry->size = size;
+	entry->pixbuf = g_object_ref (pixbuf);
+	entry->bytes = bytes;
+	g_queue_push_head (&thumbnail_cache_lru, entry);
+	entry->link = thumbnail_cache_lru.head;
+	g_hash_table_insert (cache, entry, entry);
+
+	thumbnail_cache_bytes += bytes;
+	thumbnail_cache_trim ();
+}
+
+void
+nautilus_thumbnail_cache_get_stats (guint *hits,
+				    guint *misses,
+				    gsize *bytes)
+{
+	if (hits != NULL) {
+		*hits = thumbnail_cache_hits;
+	}
+	if (misses != NULL) {
+		*misses = thumbnail_cache_misses;
+	}
+	if (bytes != NULL) {
+		*bytes = thumbnail_cache_bytes;
+	}
+}
@@ -51,6 +51,7 @@ gboolean   nautilus_thumbnail_is_mimetype_limited_by_size
 						    (const char *mime_type);
 void       nautilus_thumbnail_frame_image           (GdkPixbuf **pixbuf);
 GdkPixbuf *nautilus_thumbnail_unframe_image         (GdkPixbuf  *pixbuf);
+GList *    nautilus_thumbnail_make_mipmaps          (GdkPixbuf  *pixbuf);
 GdkPixbuf *nautilus_thumbnail_load_image            (const char *path,
 						     guint       base_size,
 						     guint       nominal_size,
@@ -76,5 +77,17 @@ void       nautilus_thumbnail_remove_from_queue     (const char   *file_uri);
 void       nautilus_thumbnail_remove_all_from_queue (void);
 void       nautilus_thumbnail_prioritize            (const char   *file_uri);
 
+/* Cache of decoded thumbnails, shared by all directories: */
+GdkPixbuf *nautilus_thumbnail_cache_lookup          (const char   *path,
+						     time_t        mtime,
+						     int           size);
+void       nautilus_thumbnail_cache_insert          (const char   *path,
+						     time_t        mtime,
+						     int           size,
+						     GdkPixbuf    *pixbuf);
+void       nautilus_thumbnail_cache_get_stats       (guint        *hits,
+						     guint        *misses,
+						     gsize        *bytes);
+
 
 #endif /* NAUTILUS_THUMBNAILS_H */
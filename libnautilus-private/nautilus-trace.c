@@ -0,0 +1,271 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*-
+
+   nautilus-trace.c: Lightweight tracepoints for the hot paths.
+
+   Copyright (C) 2011 The Nautilus contributors
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public
+   License along with this program; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+#include <config.h>
+#include "nautilus-trace.h"
+
+#include <eel/eel-debug.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#ifdef ENABLE_DEBUG
+
+/* Stop recording after this many events, so a forgotten
+ * NAUTILUS_TRACE can't eat all memory.
+ */
+#define MAX_TRACE_EVENTS 2000000
+
+typedef struct {
+	char phase; /* Chrome trace event phase: X, b, e or C */
+	const char *category;
+	const char *name;
+	gint64 timestamp;
+	gint64 value; /* duration for X, counter value for C */
+	gconstpointer id;
+	char *detail;
+	GThread *thread;
+} TraceEvent;
+
+gboolean nautilus_trace_enabled = FALSE;
+
+static char *trace_file_name;
+static GArray *trace_events;
+static guint dropped_events;
+static gint64 trace_start_time;
+
+G_LOCK_DEFINE_STATIC (trace_events);
+
+gint64
+nautilus_trace_now (void)
+{
+	return g_get_monotonic_time ();
+}
+
+static void
+add_event (char phase,
+	   const char *category,
+	   const char *name,
+	   gint64 timestamp,
+	   gint64 value,
+	   gconstpointer id,
+	   const char *detail)
+{
+	TraceEvent event;
+
+	G_LOCK (trace_events);
+
+	if (trace_events->len >= MAX_TRACE_EVENTS) {
+		dropped_events++;
+		G_UNLOCK (trace_events);
+		return;
+	}
+
+	event.phase = phase;
+	event.category = category;
+	event.name = name;
+	event.timestamp = timestamp;
+	event.value = value;
+	event.id = id;
+	event.detail = g_strdup (detail);
+	event.thread = g_thread_self ();
+	g_array_append_val (trace_events, event);
+
+	G_UNLOCK (trace_events);
+}
+
+void
+nautilus_trace_complete (const char *category,
+			 const char *name,
+			 gint64 start_time,
+			 const char *detail)
+{
+	add_event ('X', category, name, start_time,
+		   nautilus_trace_now () - start_time, NULL, detail);
+}
+
+void
+nautilus_trace_async_begin (const char *category,
+			    const char *name,
+			    gconstpointer id)
+{
+	add_event ('b', category, name, nautilus_trace_now (), 0, id, NULL);
+}
+
+void
+nautilus_trace_async_end (const char *category,
+			  const char *name,
+			  gconstpointer id)
+{
+	add_event ('e', category, name, nautilus_trace_now (), 0, id, NULL);
+}
+
+void
+nautilus_trace_counter (const char *name,
+			gconstpointer id,
+			gint64 value)
+{
+	add_event ('C', "counter", name, nautilus_trace_now (), value, id, NULL);
+}
+
+static void
+write_json_string (FILE *out, const char *str)
+{
+	const char *p;
+
+	fputc ('"', out);
+	for (p = str; *p != '\0'; p++) {
+		if (*p == '"' || *p == '\\') {
+			fputc ('\\', out);
+			fputc (*p, out);
+		} else if ((guchar) *p < 0x20) {
+			fprintf (out, "\\u%04x", (guchar) *p);
+		} else {
+			fputc (*p, out);
+		}
+	}
+	fputc ('"', out);
+}
+
+static int
+get_thread_number (GHashTable *threads, GThread *thread)
+{
+	gpointer number;
+
+	number = g_hash_table_lookup (threads, thread);
+	if (number == NULL) {
+		number = GINT_TO_POINTER (g_hash_table_size (threads) + 1);
+		g_hash_table_insert (threads, thread, number);
+	}
+	return GPOINTER_TO_INT (number);
+}
+
+void
+nautilus_trace_write (void)
+{
+	FILE *out;
+	GHashTable *threads;
+	TraceEvent *event;
+	guint i;
+	int pid;
+
+	if (!nautilus_trace_enabled) {
+		return;
+	}
+
+	G_LOCK (trace_events);
+
+	out = fopen (trace_file_name, "w");
+	if (out == NULL) {
+		g_warning ("Could not write trace to %s", trace_file_name);
+		G_UNLOCK (trace_events);
+		return;
+	}
+
+	pid = getpid ();
+	threads = g_hash_table_new (NULL, NULL);
+
+	fputs ("{\"traceEvents\":[\n", out);
+	for (i = 0; i < trace_events->len; i++) {
+		event = &g_array_index (trace_events, TraceEvent, i);
+
+		fprintf (out, "%s{\"ph\":\"%c\",\"cat\":",
+			 i == 0 ? "" : ",\n", event->phase);
+		write_json_string (out, event->category);
+		fputs (",\"name\":", out);
+		write_json_string (out, event->name);
+		fprintf (out, ",\"pid\":%d,\"tid\":%d,\"ts\":%" G_GINT64_FORMAT,
+			 pid, get_thread_number (threads, event->thread),
+			 event->timestamp - trace_start_time);
+
+		switch (event->phase) {
+		case 'X':
+			fprintf (out, ",\"dur\":%" G_GINT64_FORMAT, event->value);
+			break;
+		case 'b':
+		case 'e':
+			fprintf (out, ",\"id\":\"%p\"", event->id);
+			break;
+		case 'C':
+			if (event->id != NULL) {
+				fprintf (out, ",\"id\":\"%p\"", event->id);
+			}
+			fprintf (out, ",\"args\":{\"value\":%" G_GINT64_FORMAT "}", event->value);
+			break;
+		default:
+			g_assert_not_reached ();
+		}
+
+		if (event->detail != NULL) {
+			fputs (",\"args\":{\"detail\":", out);
+			write_json_string (out, event->detail);
+			fputc ('}', out);
+		}
+		fputc ('}', out);
+
+		g_free (event->detail);
+	}
+	fprintf (out, "\n],\"otherData\":{\"droppedEvents\":%u}}\n", dropped_events);
+
+	fclose (out);
+	g_hash_table_destroy (threads);
+
+	g_array_set_size (trace_events, 0);
+	dropped_events = 0;
+
+	G_UNLOCK (trace_events);
+}
+
+static void
+free_trace_events (void)
+{
+	nautilus_trace_write ();
+
+	nautilus_trace_enabled = FALSE;
+	g_array_free (trace_events, TRUE);
+	trace_events = NULL;
+	g_free (trace_file_name);
+	trace_file_name = NULL;
+}
+
+void
+nautilus_trace_init (void)
+{
+	const char *file_name;
+
+	if (trace_events != NULL) {
+		return;
+	}
+
+	file_name = g_getenv ("NAUTILUS_TRACE");
+	if (file_name == NULL || file_name[0] == '\0') {
+		return;
+	}
+
+	trace_file_name = g_strdup (file_name);
+	trace_events = g_array_sized_new (FALSE, FALSE, sizeof (TraceEvent), 4096);
+	trace_start_time = nautilus_trace_now ();
+	nautilus_trace_enabled = TRUE;
+
+	eel_debug_call_at_shutdown (free_trace_events);
+}
+
+#endif /* ENABLE_DEBUG */
@@ -0,0 +1,122 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*-
+
+   nautilus-trace.h: Lightweight tracepoints for the hot paths.
+
+   Copyright (C) 2011 The Nautilus contributors
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation; either version 2 of the
+   License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public
+   License along with this program; if not, write to the
+   Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+   Boston, MA 02111-1307, USA.
+*/
+
+/* Tracepoints record timestamped events in memory while
+ * NAUTILUS_TRACE is set to a file name, and write them there at
+ * shutdown in the Chrome trace event format (load it in
+ * chrome://tracing). When the variable is unset each tracepoint costs
+ * one test of a global flag, and without ENABLE_DEBUG they compile
+ * to nothing.
+ *
+ * Names and categories must be static strings; details are copied.
+ */
+
+#ifndef NAUTILUS_TRACE_H
+#define NAUTILUS_TRACE_H
+
+#include <config.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#ifdef ENABLE_DEBUG
+
+extern gboolean nautilus_trace_enabled;
+
+void   nautilus_trace_init          (void);
+gint64 nautilus_trace_now           (void);
+void   nautilus_trace_complete      (const char    *category,
+				     const char    *name,
+				     gint64         start_time,
+				     const char    *detail);
+void   nautilus_trace_async_begin   (const char    *category,
+				     const char    *name,
+				     gconstpointer  id);
+void   nautilus_trace_async_end     (const char    *category,
+				     const char    *name,
+				     gconstpointer  id);
+void   nautilus_trace_counter       (const char    *name,
+				     gconstpointer  id,
+				     gint64         value);
+void   nautilus_trace_write         (void);
+
+#define NAUTILUS_TRACING (G_UNLIKELY (nautilus_trace_enabled))
+
+/* Time a synchronous section:
+ *	gint64 start;
+ *	NAUTILUS_TRACE_BEGIN (start);
+ *	...
+ *	NAUTILUS_TRACE_END ("view", "display pending files", start, NULL);
+ */
+#define NAUTILUS_TRACE_BEGIN(start) \
+	G_STMT_START { (start) = NAUTILUS_TRACING ? nautilus_trace_now () : 0; } G_STMT_END
+
+#define NAUTILUS_TRACE_END(category, name, start, detail) \
+	G_STMT_START { \
+		if (NAUTILUS_TRACING && (start) != 0) \
+			nautilus_trace_complete ((category), (name), (start), (detail)); \
+	} G_STMT_END
+
+/* Overlapping operations, matched by name and id. */
+#define NAUTILUS_TRACE_ASYNC_BEGIN(category, name, id) \
+	G_STMT_START { \
+		if (NAUTILUS_TRACING) \
+			nautilus_trace_async_begin ((category), (name), (id)); \
+	} G_STMT_END
+
+#define NAUTILUS_TRACE_ASYNC_END(category, name, id) \
+	G_STMT_START { \
+		if (NAUTILUS_TRACING) \
+			nautilus_trace_async_end ((category), (name), (id)); \
+	} G_STMT_END
+
+/* Counters with an id, such as the directory they belong to, are
+ * drawn as a series of their own for each id; NULL is for global ones.
+ */
+#define NAUTILUS_TRACE_COUNTER(name, id, value) \
+	G_STMT_START { \
+		if (NAUTILUS_TRACING) \
+			nautilus_trace_counter ((name), (id), (value)); \
+	} G_STMT_END
+
+#else /* ENABLE_DEBUG */
+
+#define nautilus_trace_init() G_STMT_START { } G_STMT_END
+
+#define NAUTILUS_TRACING 0
+
+#define NAUTILUS_TRACE_BEGIN(start) \
+	G_STMT_START { (start) = 0; } G_STMT_END
+#define NAUTILUS_TRACE_END(category, name, start, detail) \
+	G_STMT_START { } G_STMT_END
+#define NAUTILUS_TRACE_ASYNC_BEGIN(category, name, id) \
+	G_STMT_START { } G_STMT_END
+#define NAUTILUS_TRACE_ASYNC_END(category, name, id) \
+	G_STMT_START { } G_STMT_END
+#define NAUTILUS_TRACE_COUNTER(name, id, value) \
+	G_STMT_START { } G_STMT_END
+
+#endif /* ENABLE_DEBUG */
+
+G_END_DECLS
+
+#endif /* NAUTILUS_TRACE_H */
@@ -25,9 +25,13 @@
 #include <config.h>
 #include "nautilus-users-groups-cache.h"
 
-#include <glib.h>
+#include "nautilus-signaller.h"
+
+#include <gio/gio.h>
+#include <errno.h>
 #include <grp.h>
 #include <pwd.h>
+#include <unistd.h>
 
 
 typedef struct _ExpiringCache ExpiringCache;
@@ -46,10 +50,25 @@ static ExpiringCache *groups_cache = NULL;
 /**
  * Generic implementation of cache with guint keys and values which expire
  * after specified amount of time.
+ *
+ * Values are looked up in a thread, since getpwuid () and friends can
+ * block for a long time with network user databases. A lookup returns
+ * NULL until the value is there; keys asked for in the meantime are
+ * looked up together. Keys without a value are cached too, so unknown
+ * ids aren't looked up over and over.
+ *
+ * An expired value is still returned while it is looked up again, and
+ * is only dropped after going unused for another expire time. Only the
+ * keys that got a new, non-NULL value are passed on to the changed
+ * function, so refreshing the same names doesn't redraw anything.
  */
 
+/* Called in a thread to obtain a value by a key */
 typedef gpointer (*ExpiringCacheGetValFunc) (guint key);
 
+/* Called with the keys whose values changed to something other than NULL */
+typedef void (*ExpiringCacheChangedFunc) (GArray *keys);
+
 
 struct _ExpiringCache
 {
@@ -62,8 +81,21 @@ struct _ExpiringCache
 	/* Called to destroy a value */
 	GDestroyNotify value_destroy_func;
 
+	/* Called to compare two non-NULL values */
+	GEqualFunc value_equal_func;
+
+	/* Called after a lookup changed some values */
+	ExpiringCacheChangedFunc changed_func;
+
 	/* Stores cached values */
 	GHashTable *cached_values;
+
+	/* Keys waiting for the next lookup batch */
+	GArray *pending_keys;
+	gboolean lookup_running;
+
+	/* Removes expired entries */
+	guint sweep_timeout_id;
 };
 
 
@@ -71,60 +103,204 @@ typedef struct _ExpiringCacheEntry ExpiringCacheEntry;
 
 struct _ExpiringCacheEntry
 {
-	ExpiringCache *cache;
 	guint key;
 	gpointer value;
+	gboolean queued; /* waiting for or in a lookup */
+	gint64 expire_at; /* monotonic time, valid once looked up */
 };
 
+typedef struct {
+	ExpiringCache *cache;
+	GArray *keys;
+	GPtrArray *values;
+} ExpiringCacheLookup;
+
+
+static void expiring_cache_start_lookup (ExpiringCache *cache);
 
 static ExpiringCache *
 expiring_cache_new (time_t expire_time, ExpiringCacheGetValFunc get_value_func,
-                    GDestroyNotify value_destroy_func)
+                    GDestroyNotify value_destroy_func, GEqualFunc value_equal_func,
+                    ExpiringCacheChangedFunc changed_func)
 {
 	ExpiringCache *cache;
 
 	g_assert (get_value_func != NULL);
+	g_assert (value_equal_func != NULL);
+	g_assert (changed_func != NULL);
 
 	cache = g_new (ExpiringCache, 1);
 	cache->expire_time = expire_time;
 	cache->get_value_func = get_value_func;
 	cache->value_destroy_func = value_destroy_func;
-	cache->cached_values = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, NULL);
+	cache->value_equal_func = value_equal_func;
+	cache->changed_func = changed_func;
+	cache->cached_values = g_hash_table_new (g_direct_hash, g_direct_equal);
+	cache->pending_keys = g_array_new (FALSE, FALSE, sizeof (guint));
+	cache->lookup_running = FALSE;
+	cache->sweep_timeout_id = 0;
 
 	return cache;
 }
 
 static ExpiringCacheEntry *
-expiring_cache_entry_new (ExpiringCache *cache, guint key, gpointer value)
+expiring_cache_entry_new (guint key)
 {
 	ExpiringCacheEntry *entry;
 
-	entry = g_slice_new (ExpiringCacheEntry);
-	entry->cache = cache;
+	entry = g_slice_new0 (ExpiringCacheEntry);
 	entry->key = key;
-	entry->value = value;
 
 	return entry;
 }
 
 static void
-expiring_cache_entry_destroy (ExpiringCacheEntry *entry)
+expiring_cache_value_destroy (ExpiringCache *cache, gpointer value)
 {
-	if (entry->cache->value_destroy_func != NULL) {
-		entry->cache->value_destroy_func (entry->value);
+	if (value != NULL && cache->value_destroy_func != NULL) {
+		cache->value_destroy_func (value);
 	}
+}
+
+static void
+expiring_cache_entry_destroy (ExpiringCache *cache, ExpiringCacheEntry *entry)
+{
+	expiring_cache_value_destroy (cache, entry->value);
 	g_slice_free (ExpiringCacheEntry, entry);
 }
 
+/* One timer per cache, rather than one per entry, that runs only
+ * while there's something in the cache.
+ */
 static gboolean
-cb_cache_entry_expired (ExpiringCacheEntry *entry)
+cb_cache_sweep (gpointer data)
 {
-	g_hash_table_remove (entry->cache->cached_values, GSIZE_TO_POINTER (entry->key));
-	expiring_cache_entry_destroy (entry);
+	ExpiringCache *cache;
+	GHashTableIter iter;
+	ExpiringCacheEntry *entry;
+	gint64 unused_since;
+
+	cache = data;
+	unused_since = g_get_monotonic_time () - (gint64) cache->expire_time * G_USEC_PER_SEC;
+
+	/* Entries still in use are looked up again when they expire,
+	 * so one that expired a whole expire time ago wasn't asked for.
+	 */
+	g_hash_table_iter_init (&iter, cache->cached_values);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry)) {
+		if (!entry->queued && entry->expire_at <= unused_since) {
+			g_hash_table_iter_remove (&iter);
+			expiring_cache_entry_destroy (cache, entry);
+		}
+	}
 
-	return FALSE;
+	if (g_hash_table_size (cache->cached_values) == 0) {
+		cache->sweep_timeout_id = 0;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+expiring_cache_lookup_thread (GSimpleAsyncResult *res,
+			      GObject *object,
+			      GCancellable *cancellable)
+{
+	ExpiringCacheLookup *lookup;
+	guint i;
+
+	lookup = g_simple_async_result_get_op_res_gpointer (res);
+
+	for (i = 0; i < lookup->keys->len; i++) {
+		g_ptr_array_add (lookup->values,
+				 lookup->cache->get_value_func (g_array_index (lookup->keys, guint, i)));
+	}
 }
 
+static void
+expiring_cache_lookup_callback (GObject *source_object,
+				GAsyncResult *res,
+				gpointer user_data)
+{
+	ExpiringCacheLookup *lookup;
+	ExpiringCache *cache;
+	ExpiringCacheEntry *entry;
+	GArray *changed_keys;
+	gpointer value;
+	gint64 expire_at;
+	guint i;
+
+	lookup = user_data;
+	cache = lookup->cache;
+
+	changed_keys = g_array_new (FALSE, FALSE, sizeof (guint));
+	expire_at = g_get_monotonic_time () + (gint64) cache->expire_time * G_USEC_PER_SEC;
+	for (i = 0; i < lookup->keys->len; i++) {
+		entry = g_hash_table_lookup (cache->cached_values,
+					     GSIZE_TO_POINTER (g_array_index (lookup->keys, guint, i)));
+		g_assert (entry != NULL && entry->queued);
+
+		value = g_ptr_array_index (lookup->values, i);
+		if (value != NULL && entry->value != NULL &&
+		    cache->value_equal_func (value, entry->value)) {
+			expiring_cache_value_destroy (cache, value);
+		} else if (value != NULL || entry->value != NULL) {
+			if (value != NULL) {
+				g_array_append_val (changed_keys, entry->key);
+			}
+			expiring_cache_value_destroy (cache, entry->value);
+			entry->value = value;
+		}
+		entry->queued = FALSE;
+		entry->expire_at = expire_at;
+	}
+
+	g_array_free (lookup->keys, TRUE);
+	g_ptr_array_free (lookup->values, TRUE);
+	g_free (lookup);
+
+	cache->lookup_running = FALSE;
+	if (cache->pending_keys->len > 0) {
+		expiring_cache_start_lookup (cache);
+	}
+
+	if (changed_keys->len > 0) {
+		cache->changed_func (changed_keys);
+	}
+	g_array_free (changed_keys, TRUE);
+}
+
+static void
+expiring_cache_start_lookup (ExpiringCache *cache)
+{
+	ExpiringCacheLookup *lookup;
+	GSimpleAsyncResult *res;
+
+	g_assert (!cache->lookup_running);
+
+	lookup = g_new (ExpiringCacheLookup, 1);
+	lookup->cache = cache;
+	lookup->keys = cache->pending_keys;
+	lookup->values = g_ptr_array_sized_new (lookup->keys->len);
+	cache->pending_keys = g_array_new (FALSE, FALSE, sizeof (guint));
+	cache->lookup_running = TRUE;
+
+	res = g_simple_async_result_new (NULL,
+					 expiring_cache_lookup_callback,
+					 lookup,
+					 expiring_cache_start_lookup);
+	g_simple_async_result_set_op_res_gpointer (res, lookup, NULL);
+	g_simple_async_result_run_in_thread (res,
+					     expiring_cache_lookup_thread,
+					     G_PRIORITY_DEFAULT,
+					     NULL);
+	g_object_unref (res);
+}
+
+/* Returns the value for key, or NULL if there is none or it hasn't
+ * been looked up yet.
+ */
 static gpointer
 expiring_cache_get_value (ExpiringCache *cache, guint key)
 {
@@ -132,16 +308,39 @@ expiring_cache_get_value (ExpiringCache *cache, guint key)
 
 	g_assert (cache != NULL);
 
-	if (!g_hash_table_lookup_extended (cache->cached_values, GSIZE_TO_POINTER (key),
-	                                   NULL, (gpointer) &entry)) {
-		entry = expiring_cache_entry_new (cache, key, cache->get_value_func (key));
+	entry = g_hash_table_lookup (cache->cached_values, GSIZE_TO_POINTER (key));
+	if (entry == NULL) {
+		entry = expiring_cache_entry_new (key);
 		g_hash_table_insert (cache->cached_values, GSIZE_TO_POINTER (key), entry);
-		g_timeout_add_seconds (cache->expire_time, (GSourceFunc) cb_cache_entry_expired, entry);
+	} else if (entry->queued || entry->expire_at > g_get_monotonic_time ()) {
+		return entry->value;
+	}
+
+	/* New or expired, the old value is kept until the lookup is done */
+	entry->queued = TRUE;
+	g_array_append_val (cache->pending_keys, key);
+	if (!cache->lookup_running) {
+		expiring_cache_start_lookup (cache);
+	}
+
+	if (cache->sweep_timeout_id == 0) {
+		cache->sweep_timeout_id =
+			g_timeout_add_seconds (cache->expire_time, cb_cache_sweep, cache);
 	}
 
 	return entry->value;
 }
 
+static char *
+get_lookup_buffer (gsize *size)
+{
+	long max;
+
+	max = sysconf (_SC_GETPW_R_SIZE_MAX);
+	*size = max > 0 ? max : 1024;
+	return g_malloc (*size);
+}
+
 
 /*
  * Cache of users' names based on ExpiringCache.
@@ -181,10 +380,43 @@ user_info_free (UserInfo *uinfo)
 	}
 }
 
+static gboolean
+user_info_equal (UserInfo *a, UserInfo *b)
+{
+	return g_strcmp0 (a->name, b->name) == 0 &&
+		g_strcmp0 (a->gecos, b->gecos) == 0;
+}
+
+static void
+users_cache_changed (GArray *uids)
+{
+	NautilusUsersGroupsChange change;
+
+	change.uids = uids;
+	change.gids = NULL;
+	g_signal_emit_by_name (nautilus_signaller_get_current (),
+			       "users_groups_changed", &change);
+}
+
 static gpointer
 users_cache_get_value (guint key)
 {
-	return user_info_new (getpwuid (key));
+	struct passwd password_info, *result;
+	UserInfo *uinfo;
+	char *buffer;
+	gsize size;
+	int error;
+
+	buffer = get_lookup_buffer (&size);
+	while ((error = getpwuid_r (key, &password_info, buffer, size, &result)) == ERANGE) {
+		size *= 2;
+		buffer = g_realloc (buffer, size);
+	}
+
+	uinfo = user_info_new (error == 0 ? result : NULL);
+	g_free (buffer);
+
+	return uinfo;
 }
 
 static UserInfo *
@@ -192,7 +424,9 @@ get_cached_user_info(guint uid)
 {
 	if (users_cache == NULL) {
 		users_cache = expiring_cache_new (USERS_CACHE_EXPIRE_TIME, users_cache_get_value,
-		                                  (GDestroyNotify) user_info_free);
+		                                  (GDestroyNotify) user_info_free,
+		                                  (GEqualFunc) user_info_equal,
+		                                  users_cache_changed);
 	}
 
 	return expiring_cache_get_value (users_cache, uid);
@@ -202,7 +436,10 @@ get_cached_user_info(guint uid)
  * nautilus_users_cache_get_name:
  *
  * Returns name of user with given uid (using cached data if possible) or
- * NULL in case a user with given uid can't be found.
+ * NULL in case a user with given uid can't be found. Doesn't block: if
+ * the user wasn't looked up yet, returns NULL and looks it up in the
+ * background, then emits "users_groups_changed" on the signaller if
+ * the name was found.
  *
  * Returns: Newly allocated string or NULL.
  */
@@ -223,7 +460,8 @@ nautilus_users_cache_get_name (uid_t uid)
  * nautilus_users_cache_get_gecos:
  *
  * Returns gecos of user with given uid (using cached data if possible) or
- * NULL in case a user with given uid can't be found.
+ * NULL in case a user with given uid can't be found. Doesn't block, see
+ * nautilus_users_cache_get_name().
  *
  * Returns: Newly allocated string or NULL.
  */
@@ -244,17 +482,39 @@ nautilus_users_cache_get_gecos (uid_t uid)
  * Cache of groups' names based on ExpiringCache.
  */
 
+static void
+groups_cache_changed (GArray *gids)
+{
+	NautilusUsersGroupsChange change;
+
+	change.uids = NULL;
+	change.gids = gids;
+	g_signal_emit_by_name (nautilus_signaller_get_current (),
+			       "users_groups_changed", &change);
+}
+
 static gpointer
 groups_cache_get_value (guint key)
 {
-	struct group *group_info;
+	struct group group_info, *result;
+	char *buffer, *name;
+	gsize size;
+	int error;
+
+	buffer = get_lookup_buffer (&size);
+	while ((error = getgrgid_r (key, &group_info, buffer, size, &result)) == ERANGE) {
+		size *= 2;
+		buffer = g_realloc (buffer, size);
+	}
 
-	group_info = getgrgid (GPOINTER_TO_SIZE (key));
-	if (group_info != NULL) {
-		return g_strdup (group_info->gr_name);
+	if (error == 0 && result != NULL) {
+		name = g_strdup (result->gr_name);
 	} else {
-		return NULL;
+		name = NULL;
 	}
+	g_free (buffer);
+
+	return name;
 }
 
 
@@ -262,7 +522,8 @@ groups_cache_get_value (guint key)
  * nautilus_groups_cache_get_name:
  *
  * Returns name of group with given gid (using cached data if possible) or
- * NULL in case a group with given gid can't be found.
+ * NULL in case a group with given gid can't be found. Doesn't block, see
+ * nautilus_users_cache_get_name().
  *
  * Returns: Newly allocated string or NULL.
  */
@@ -270,7 +531,8 @@ char *
 nautilus_groups_cache_get_name (gid_t gid)
 {
 	if (groups_cache == NULL) {
-		groups_cache = expiring_cache_new (GROUPS_CACHE_EXPIRE_TIME, groups_cache_get_value, g_free);
+		groups_cache = expiring_cache_new (GROUPS_CACHE_EXPIRE_TIME, groups_cache_get_value, g_free,
+		                                   g_str_equal, groups_cache_changed);
 	}
 
 	return g_strdup (expiring_cache_get_value (groups_cache, gid));
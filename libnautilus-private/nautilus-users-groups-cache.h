@@ -26,6 +26,13 @@
 #define NAUTILUS_USERS_GROUPS_CACHE_H
 
 #include <sys/types.h>
+#include <glib.h>
+
+/* Passed with "users_groups_changed" on the signaller */
+typedef struct {
+	GArray *uids; /* of guint, users whose names were found, or NULL */
+	GArray *gids; /* of guint, groups whose names were found, or NULL */
+} NautilusUsersGroupsChange;
 
 char *nautilus_users_cache_get_name (uid_t uid);
 char *nautilus_users_cache_get_gecos (uid_t uid);
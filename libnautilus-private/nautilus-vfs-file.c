@@ -29,8 +29,10 @@
 #include "nautilus-directory-notify.h"
 #include "nautilus-directory-private.h"
 #include "nautilus-file-private.h"
+#include <eel/eel-debug.h>
 #include <eel/eel-gtk-macros.h>
 #include <glib/gi18n.h>
+#include <string.h>
 
 static void nautilus_vfs_file_init       (gpointer   object,
 						gpointer   klass);
@@ -89,59 +91,314 @@ vfs_file_check_if_ready (NautilusFile *file,
 		 file_attributes);
 }
 
+/* Metadata is written behind: the in-memory copy is changed right away
+ * and the writes are queued, keeping only the latest value of each key
+ * of each file. They are flushed from an idle, one thread job per
+ * directory, so arranging thousands of icons ends up as one write per
+ * file with nothing to read back afterwards.
+ */
+
+static GHashTable *pending_metadata; /* NautilusFile -> GFileInfo */
+static GHashTable *writing_metadata; /* NautilusFile -> GFileInfo, in a thread job */
+static guint flush_metadata_idle_id;
+
+/* Counted down by the thread jobs, so the synchronous flush can wait
+ * for them */
+static GMutex *metadata_mutex;
+static GCond *metadata_cond;
+static int metadata_batches_in_flight;
+
+typedef struct {
+	GList *files;
+	GList *locations;
+	GList *infos;
+} MetadataBatch;
+
+static gboolean flush_metadata_idle_callback (gpointer data);
+
 static void
-set_metadata_get_info_callback (GObject *source_object,
-				GAsyncResult *res,
-				gpointer callback_data)
+metadata_batch_free (MetadataBatch *batch)
 {
-	NautilusFile *file;
-	GFileInfo *new_info;
+	nautilus_file_list_free (batch->files);
+	g_list_free_full (batch->locations, g_object_unref);
+	g_list_free_full (batch->infos, g_object_unref);
+	g_free (batch);
+}
+
+static int
+get_metadata_batches_in_flight (void)
+{
+	int count;
+
+	g_mutex_lock (metadata_mutex);
+	count = metadata_batches_in_flight;
+	g_mutex_unlock (metadata_mutex);
+
+	return count;
+}
+
+static void
+write_metadata_batch (MetadataBatch *batch)
+{
+	GList *l, *m;
 	GError *error;
 
-	file = callback_data;
+	for (l = batch->locations, m = batch->infos;
+	     l != NULL && m != NULL;
+	     l = l->next, m = m->next) {
+		error = NULL;
+		if (!g_file_set_attributes_from_info (l->data, m->data, 0, NULL, &error)) {
+			g_error_free (error);
+		}
+	}
+}
 
-	error = NULL;
-	new_info = g_file_query_info_finish (G_FILE (source_object), res, &error);
-	if (new_info != NULL) {
-		if (nautilus_file_update_info (file, new_info)) {
-			nautilus_file_changed (file);
+static void
+write_metadata_batch_thread (GSimpleAsyncResult *res,
+			     GObject *object,
+			     GCancellable *cancellable)
+{
+	write_metadata_batch (g_simple_async_result_get_op_res_gpointer (res));
+
+	g_mutex_lock (metadata_mutex);
+	metadata_batches_in_flight--;
+	g_cond_broadcast (metadata_cond);
+	g_mutex_unlock (metadata_mutex);
+}
+
+static void
+write_metadata_batch_callback (GObject *source_object,
+			       GAsyncResult *res,
+			       gpointer user_data)
+{
+	MetadataBatch *batch;
+	GList *l, *m;
+
+	/* What is on disk now is what the file was given */
+	batch = g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res));
+	for (l = batch->files, m = batch->infos;
+	     l != NULL && m != NULL && writing_metadata != NULL;
+	     l = l->next, m = m->next) {
+		if (g_hash_table_lookup (writing_metadata, l->data) == m->data) {
+			g_hash_table_remove (writing_metadata, l->data);
 		}
-		g_object_unref (new_info);
 	}
-	nautilus_file_unref (file);
-	if (error) {
-		g_error_free (error);
+
+	/* Values queued while this batch was written were held back, so
+	 * that an older write can't land after a newer one */
+	if (get_metadata_batches_in_flight () == 0 &&
+	    pending_metadata != NULL &&
+	    g_hash_table_size (pending_metadata) > 0 &&
+	    flush_metadata_idle_id == 0) {
+		flush_metadata_idle_id = g_idle_add (flush_metadata_idle_callback, NULL);
 	}
 }
 
-static void
-set_metadata_callback (GObject *source_object,
-		       GAsyncResult *result,
-		       gpointer callback_data)
+/* Takes the pending writes, grouped by directory */
+static GList *
+steal_pending_metadata (void)
 {
+	GHashTable *batches;
+	GHashTableIter iter;
+	gpointer key, value;
 	NautilusFile *file;
-	GError *error;
-	gboolean res;
+	MetadataBatch *batch;
+	GList *list;
 
-	file = callback_data;
+	batches = g_hash_table_new (NULL, NULL);
 
-	error = NULL;
-	res = g_file_set_attributes_finish (G_FILE (source_object),
-					    result,
-					    NULL,
-					    &error);
-
-	if (res) {
-		g_file_query_info_async (G_FILE (source_object),
-					 NAUTILUS_FILE_DEFAULT_ATTRIBUTES,
-					 0,
-					 G_PRIORITY_DEFAULT,
-					 NULL,
-					 set_metadata_get_info_callback, file);
-	} else {
-		nautilus_file_unref (file);
-		g_error_free (error);
+	g_hash_table_iter_init (&iter, pending_metadata);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		file = key;
+
+		batch = g_hash_table_lookup (batches, file->details->directory);
+		if (batch == NULL) {
+			batch = g_new0 (MetadataBatch, 1);
+			g_hash_table_insert (batches, file->details->directory, batch);
+		}
+
+		batch->files = g_list_prepend (batch->files, nautilus_file_ref (file));
+		batch->locations = g_list_prepend (batch->locations,
+						   nautilus_file_get_location (file));
+		batch->infos = g_list_prepend (batch->infos, g_object_ref (value));
+	}
+	g_hash_table_remove_all (pending_metadata);
+
+	list = g_hash_table_get_values (batches);
+	g_hash_table_destroy (batches);
+
+	return list;
+}
+
+static gboolean
+flush_metadata_idle_callback (gpointer data)
+{
+	GList *batches, *l, *files, *infos;
+	MetadataBatch *batch;
+	GSimpleAsyncResult *res;
+
+	flush_metadata_idle_id = 0;
+
+	if (get_metadata_batches_in_flight () > 0) {
+		/* write_metadata_batch_callback () comes back here */
+		return FALSE;
+	}
+
+	batches = steal_pending_metadata ();
+	for (l = batches; l != NULL; l = l->next) {
+		batch = l->data;
+
+		for (files = batch->files, infos = batch->infos;
+		     files != NULL && infos != NULL;
+		     files = files->next, infos = infos->next) {
+			g_hash_table_insert (writing_metadata,
+					     nautilus_file_ref (files->data),
+					     g_object_ref (infos->data));
+		}
+
+		g_mutex_lock (metadata_mutex);
+		metadata_batches_in_flight++;
+		g_mutex_unlock (metadata_mutex);
+
+		res = g_simple_async_result_new (NULL,
+						 write_metadata_batch_callback,
+						 NULL,
+						 flush_metadata_idle_callback);
+		g_simple_async_result_set_op_res_gpointer (res, batch,
+							   (GDestroyNotify) metadata_batch_free);
+		g_simple_async_result_run_in_thread (res,
+						     write_metadata_batch_thread,
+						     G_PRIORITY_DEFAULT,
+						     NULL);
+		g_object_unref (res);
+	}
+	g_list_free (batches);
+
+	return FALSE;
+}
+
+void
+nautilus_vfs_file_flush_metadata (void)
+{
+	GList *batches, *l;
+
+	if (pending_metadata == NULL) {
+		return;
+	}
+
+	if (flush_metadata_idle_id != 0) {
+		g_source_remove (flush_metadata_idle_id);
+		flush_metadata_idle_id = 0;
+	}
+
+	/* The queued values are newer than the ones being written */
+	g_mutex_lock (metadata_mutex);
+	while (metadata_batches_in_flight > 0) {
+		g_cond_wait (metadata_cond, metadata_mutex);
+	}
+	g_mutex_unlock (metadata_mutex);
+
+	batches = steal_pending_metadata ();
+	for (l = batches; l != NULL; l = l->next) {
+		write_metadata_batch (l->data);
+		metadata_batch_free (l->data);
+	}
+	g_list_free (batches);
+}
+
+static void
+free_pending_metadata (void)
+{
+	nautilus_vfs_file_flush_metadata ();
+
+	g_hash_table_destroy (pending_metadata);
+	pending_metadata = NULL;
+	g_hash_table_destroy (writing_metadata);
+	writing_metadata = NULL;
+}
+
+static GFileInfo *
+get_pending_metadata_info (NautilusFile *file)
+{
+	GFileInfo *info;
+
+	if (pending_metadata == NULL) {
+		pending_metadata = g_hash_table_new_full (NULL, NULL,
+							  (GDestroyNotify) nautilus_file_unref,
+							  g_object_unref);
+		writing_metadata = g_hash_table_new_full (NULL, NULL,
+							  (GDestroyNotify) nautilus_file_unref,
+							  g_object_unref);
+		eel_debug_call_at_shutdown (free_pending_metadata);
+	}
+
+	info = g_hash_table_lookup (pending_metadata, file);
+	if (info == NULL) {
+		info = g_file_info_new ();
+		g_hash_table_insert (pending_metadata, nautilus_file_ref (file), info);
+	}
+
+	if (flush_metadata_idle_id == 0 && get_metadata_batches_in_flight () == 0) {
+		flush_metadata_idle_id = g_idle_add (flush_metadata_idle_callback, NULL);
+	}
+
+	return info;
+}
+
+static gboolean
+apply_metadata_info (NautilusFile *file,
+		     GFileInfo *info)
+{
+	char **attrs;
+	const char *key;
+	GFileAttributeType type;
+	gpointer value;
+	gboolean changed;
+	int i;
+
+	changed = FALSE;
+	attrs = g_file_info_list_attributes (info, "metadata");
+	for (i = 0; attrs[i] != NULL; i++) {
+		if (!g_file_info_get_attribute_data (info, attrs[i],
+						     &type, &value, NULL)) {
+			continue;
+		}
+
+		key = attrs[i] + strlen ("metadata::");
+		if (type == G_FILE_ATTRIBUTE_TYPE_STRINGV) {
+			changed |= nautilus_file_update_metadata_list_value (file, key, value);
+		} else if (type == G_FILE_ATTRIBUTE_TYPE_STRING) {
+			changed |= nautilus_file_update_metadata_value (file, key, value);
+		} else {
+			changed |= nautilus_file_update_metadata_value (file, key, NULL);
+		}
 	}
+	g_strfreev (attrs);
+
+	return changed;
+}
+
+gboolean
+nautilus_vfs_file_apply_unwritten_metadata (NautilusFile *file)
+{
+	GFileInfo *info;
+	gboolean changed;
+
+	if (pending_metadata == NULL) {
+		return FALSE;
+	}
+
+	changed = FALSE;
+	info = g_hash_table_lookup (writing_metadata, file);
+	if (info != NULL) {
+		changed |= apply_metadata_info (file, info);
+	}
+	info = g_hash_table_lookup (pending_metadata, file);
+	if (info != NULL) {
+		changed |= apply_metadata_info (file, info);
+	}
+
+	return changed;
 }
 
 static void
@@ -150,11 +407,11 @@ vfs_file_set_metadata (NautilusFile           *file,
 		       const char             *value)
 {
 	GFileInfo *info;
-	GFile *location;
 	char *gio_key;
 
-	info = g_file_info_new ();
-	
+	info = get_pending_metadata_info (file);
+
+	/* Setting an attribute again replaces the queued value */
 	gio_key = g_strconcat ("metadata::", key, NULL);
 	if (value != NULL) {
 		g_file_info_set_attribute_string (info, gio_key, value);
@@ -166,16 +423,9 @@ vfs_file_set_metadata (NautilusFile           *file,
 	}
 	g_free (gio_key);
 
-	location = nautilus_file_get_location (file);
-	g_file_set_attributes_async (location,
-				     info,
-				     0,
-				     G_PRIORITY_DEFAULT,
-				     NULL,
-				     set_metadata_callback,
-				     nautilus_file_ref (file));
-	g_object_unref (location);
-	g_object_unref (info);
+	if (nautilus_file_update_metadata_value (file, key, value)) {
+		nautilus_file_changed (file);
+	}
 }
 
 static void
@@ -183,26 +433,18 @@ vfs_file_set_metadata_as_list (NautilusFile           *file,
 			       const char             *key,
 			       char                  **value)
 {
-	GFile *location;
 	GFileInfo *info;
 	char *gio_key;
 
-	info = g_file_info_new ();
+	info = get_pending_metadata_info (file);
 
 	gio_key = g_strconcat ("metadata::", key, NULL);
 	g_file_info_set_attribute_stringv (info, gio_key, value);
 	g_free (gio_key);
 
-	location = nautilus_file_get_location (file);
-	g_file_set_attributes_async (location,
-				     info,
-				     0,
-				     G_PRIORITY_DEFAULT,
-				     NULL,
-				     set_metadata_callback,
-				     nautilus_file_ref (file));
-	g_object_unref (info);
-	g_object_unref (location);
+	if (nautilus_file_update_metadata_list_value (file, key, value)) {
+		nautilus_file_changed (file);
+	}
 }
 
 static gboolean
@@ -699,6 +941,9 @@ nautilus_vfs_file_class_init (gpointer klass)
 
 	file_class = NAUTILUS_FILE_CLASS (klass);
 
+	metadata_mutex = g_mutex_new ();
+	metadata_cond = g_cond_new ();
+
 	file_class->monitor_add = vfs_file_monitor_add;
 	file_class->monitor_remove = vfs_file_monitor_remove;
 	file_class->call_when_ready = vfs_file_call_when_ready;
@@ -52,4 +52,10 @@ typedef struct {
 
 GType   nautilus_vfs_file_get_type (void);
 
+/* Write out queued metadata changes now, instead of from an idle */
+void     nautilus_vfs_file_flush_metadata           (void);
+/* Put queued metadata changes back after reading the file info, since
+ * they aren't on disk yet. Returns TRUE if the metadata changed. */
+gboolean nautilus_vfs_file_apply_unwritten_metadata (NautilusFile *file);
+
 #endif /* NAUTILUS_VFS_FILE_H */
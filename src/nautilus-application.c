@@ -56,8 +56,10 @@
 #include <libnautilus-private/nautilus-lib-self-check-functions.h>
 #include <libnautilus-private/nautilus-module.h>
 #include <libnautilus-private/nautilus-signaller.h>
+#include <libnautilus-private/nautilus-trace.h>
 #include <libnautilus-private/nautilus-ui-utilities.h>
 #include <libnautilus-private/nautilus-undo-manager.h>
+#include <libnautilus-private/nautilus-vfs-file.h>
 #include <libnautilus-extension/nautilus-menu-provider.h>
 
 #define DEBUG_FLAG NAUTILUS_DEBUG_APPLICATION
@@ -108,8 +110,31 @@ struct _NautilusApplicationPriv {
 
 	gboolean no_desktop;
 	gchar *geometry;
+
+	guint deferred_init_id;
+	guint deferred_init_step;
 };
 
+/* Startup profiling: with NAUTILUS_DEBUG=Application each phase of
+ * startup logs how long it took, and the first window logs when it is
+ * first drawn, counted from the start of startup.
+ */
+static gint64 startup_time;
+static gint64 startup_phase_time;
+static gboolean first_window_drawn;
+
+static void
+startup_phase_done (const char *phase)
+{
+	gint64 now;
+
+	now = g_get_monotonic_time ();
+	DEBUG ("Startup phase \"%s\" took %.1f ms", phase,
+	       (now - startup_phase_time) / 1000.0);
+	NAUTILUS_TRACE_END ("startup", "startup phase", startup_phase_time, phase);
+	startup_phase_time = now;
+}
+
 static gboolean
 check_required_directories (NautilusApplication *application)
 {
@@ -189,22 +214,23 @@ menu_provider_items_updated_handler (NautilusMenuProvider *provider, GtkWidget*
 }
 
 static void
-menu_provider_init_callback (void)
+menu_provider_added_callback (GObject *provider,
+			      gpointer user_data)
 {
-        GList *providers;
-        GList *l;
-
-        providers = nautilus_module_get_extensions_for_type (NAUTILUS_TYPE_MENU_PROVIDER);
-
-        for (l = providers; l != NULL; l = l->next) {
-                NautilusMenuProvider *provider = NAUTILUS_MENU_PROVIDER (l->data);
-
-		g_signal_connect_after (G_OBJECT (provider), "items_updated",
-                           (GCallback)menu_provider_items_updated_handler,
-                           NULL);
-        }
+	g_signal_connect_after (provider, "items_updated",
+				(GCallback)menu_provider_items_updated_handler,
+				NULL);
+}
 
-        nautilus_module_extension_list_free (providers);
+static void
+menu_provider_init_callback (void)
+{
+	/* Menu providers can come from modules that are only loaded
+	 * later, so don't ask for them here; that would load them all.
+	 */
+	nautilus_module_watch_extensions (NAUTILUS_TYPE_MENU_PROVIDER,
+					  menu_provider_added_callback,
+					  NULL);
 }
 
 static void
@@ -479,6 +505,24 @@ nautilus_window_delete_event_callback (GtkWidget *widget,
 }				       
 
 
+static gboolean
+first_window_draw_callback (GtkWidget *widget,
+			    cairo_t *cr,
+			    gpointer user_data)
+{
+	g_signal_handlers_disconnect_by_func (widget, first_window_draw_callback, user_data);
+
+	if (!first_window_drawn) {
+		first_window_drawn = TRUE;
+		DEBUG ("First window drawn %.1f ms after startup began",
+		       (g_get_monotonic_time () - startup_time) / 1000.0);
+		NAUTILUS_TRACE_END ("startup", "first window drawn",
+				    startup_time, NULL);
+	}
+
+	return FALSE;
+}
+
 static NautilusWindow *
 create_window (NautilusApplication *application,
 	       GdkScreen *screen)
@@ -495,6 +539,11 @@ create_window (NautilusApplication *application,
 			       G_CALLBACK (nautilus_window_delete_event_callback), NULL, NULL,
 			       G_CONNECT_AFTER);
 
+	if (!first_window_drawn) {
+		g_signal_connect_after (window, "draw",
+					G_CALLBACK (first_window_draw_callback), NULL);
+	}
+
 	gtk_application_add_window (GTK_APPLICATION (application),
 				    GTK_WINDOW (window));
 
@@ -835,6 +884,11 @@ nautilus_application_finalize (GObject *object)
 
 	nautilus_bookmarks_exiting ();
 
+	if (application->priv->deferred_init_id != 0) {
+		g_source_remove (application->priv->deferred_init_id);
+		application->priv->deferred_init_id = 0;
+	}
+
 	g_clear_object (&application->undo_manager);
 	g_clear_object (&application->priv->volume_monitor);
 	g_clear_object (&application->priv->progress_handler);
@@ -1141,24 +1195,85 @@ init_gtk_accels (void)
 			  G_CALLBACK (queue_accel_map_save_callback), NULL);
 }
 
+static void
+init_volume_monitor (NautilusApplication *self)
+{
+	/* Watch for unmounts so we can close open windows */
+	/* TODO-gio: This should be using the UNMOUNTED feature of GFileMonitor instead */
+	self->priv->volume_monitor = g_volume_monitor_get ();
+	g_signal_connect_object (self->priv->volume_monitor, "mount_removed",
+				 G_CALLBACK (mount_removed_callback), self, 0);
+	g_signal_connect_object (self->priv->volume_monitor, "mount_added",
+				 G_CALLBACK (mount_added_callback), self, 0);
+}
+
+static void
+init_check_required_directories (NautilusApplication *self)
+{
+	/* Check the user's ~/.nautilus directories and post warnings
+	 * if there are problems.
+	 */
+	check_required_directories (self);
+}
+
+/* Startup work that can wait until the first window is up. It runs
+ * from a low priority idle, one step per iteration, so it doesn't hold
+ * up drawing or input either.
+ */
+static const struct {
+	const char *name;
+	void (* func) (NautilusApplication *self);
+} deferred_init_steps[] = {
+	{ "volume monitor", init_volume_monitor },
+	{ "required directories", init_check_required_directories },
+	{ "upgrades", do_upgrades_once },
+};
+
+static gboolean
+deferred_init_callback (gpointer user_data)
+{
+	NautilusApplication *self;
+	guint step;
+
+	self = NAUTILUS_APPLICATION (user_data);
+	step = self->priv->deferred_init_step++;
+
+	startup_phase_time = g_get_monotonic_time ();
+	deferred_init_steps[step].func (self);
+	startup_phase_done (deferred_init_steps[step].name);
+
+	if (self->priv->deferred_init_step < G_N_ELEMENTS (deferred_init_steps)) {
+		return TRUE;
+	}
+
+	self->priv->deferred_init_id = 0;
+	return FALSE;
+}
+
 static void
 nautilus_application_startup (GApplication *app)
 {
 	NautilusApplication *self = NAUTILUS_APPLICATION (app);
 
+	startup_time = g_get_monotonic_time ();
+	startup_phase_time = startup_time;
+
 	/* chain up to the GTK+ implementation early, so gtk_init()
 	 * is called for us.
 	 */
 	G_APPLICATION_CLASS (nautilus_application_parent_class)->startup (app);
+	startup_phase_done ("gtk");
 
 	/* create an undo manager */
 	self->undo_manager = nautilus_undo_manager_new ();
 
 	/* create DBus manager */
 	nautilus_dbus_manager_start (app);
+	startup_phase_done ("dbus");
 
 	/* initialize preferences and create the global GSettings objects */
 	nautilus_global_preferences_init ();
+	startup_phase_done ("preferences");
 
 	/* register views */
 	nautilus_icon_view_register ();
@@ -1171,36 +1286,31 @@ nautilus_application_startup (GApplication *app)
 
 	/* register property pages */
 	nautilus_image_properties_page_register ();
+	startup_phase_done ("views");
 
 	/* initialize theming */
 	init_icons_and_styles ();
 	init_gtk_accels ();
+	startup_phase_done ("theming");
 	
 	/* initialize nautilus modules */
 	nautilus_module_setup ();
 
 	/* attach menu-provider module callback */
 	menu_provider_init_callback ();
+	startup_phase_done ("modules");
 	
 	/* Initialize the UI handler singleton for file operations */
 	notify_init (GETTEXT_PACKAGE);
 	self->priv->progress_handler = nautilus_progress_ui_handler_new ();
+	startup_phase_done ("progress ui");
 
-	/* Watch for unmounts so we can close open windows */
-	/* TODO-gio: This should be using the UNMOUNTED feature of GFileMonitor instead */
-	self->priv->volume_monitor = g_volume_monitor_get ();
-	g_signal_connect_object (self->priv->volume_monitor, "mount_removed",
-				 G_CALLBACK (mount_removed_callback), self, 0);
-	g_signal_connect_object (self->priv->volume_monitor, "mount_added",
-				 G_CALLBACK (mount_added_callback), self, 0);
-
-	/* Check the user's ~/.nautilus directories and post warnings
-	 * if there are problems.
-	 */
-	check_required_directories (self);
 	init_desktop (self);
+	startup_phase_done ("desktop");
 
-	do_upgrades_once (self);
+	/* The rest isn't needed to show the first window */
+	self->priv->deferred_init_id =
+		g_idle_add_full (G_PRIORITY_LOW, deferred_init_callback, self, NULL);
 }
 
 static void
@@ -1210,6 +1320,7 @@ nautilus_application_quit_mainloop (GApplication *app)
 
 	nautilus_icon_info_clear_caches ();
  	nautilus_application_save_accel_map (NULL);
+	nautilus_vfs_file_flush_metadata ();
 
 	G_APPLICATION_CLASS (nautilus_application_parent_class)->quit_mainloop (app);
 }
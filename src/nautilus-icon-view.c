@@ -1239,6 +1239,26 @@ nautilus_icon_view_get_selection (NautilusView *view)
 	return list;
 }
 
+static int
+nautilus_icon_view_get_selection_count (NautilusView *view)
+{
+	g_return_val_if_fail (NAUTILUS_IS_ICON_VIEW (view), 0);
+
+	return nautilus_icon_container_get_selection_count
+		(get_icon_container (NAUTILUS_ICON_VIEW (view)));
+}
+
+static gboolean
+nautilus_icon_view_is_file_selected (NautilusView *view,
+				     NautilusFile *file)
+{
+	g_return_val_if_fail (NAUTILUS_IS_ICON_VIEW (view), FALSE);
+
+	return nautilus_icon_container_is_data_selected
+		(get_icon_container (NAUTILUS_ICON_VIEW (view)),
+		 NAUTILUS_ICON_CONTAINER_ICON_DATA (file));
+}
+
 static void
 count_item (NautilusIconData *icon_data,
 	    gpointer callback_data)
@@ -2819,6 +2839,8 @@ nautilus_icon_view_class_init (NautilusIconViewClass *klass)
 	nautilus_view_class->get_selected_icon_locations = nautilus_icon_view_get_selected_icon_locations;
 	nautilus_view_class->get_selection = nautilus_icon_view_get_selection;
 	nautilus_view_class->get_selection_for_file_transfer = nautilus_icon_view_get_selection;
+	nautilus_view_class->get_selection_count = nautilus_icon_view_get_selection_count;
+	nautilus_view_class->is_file_selected = nautilus_icon_view_is_file_selected;
 	nautilus_view_class->get_item_count = nautilus_icon_view_get_item_count;
 	nautilus_view_class->is_empty = nautilus_icon_view_is_empty;
 	nautilus_view_class->remove_file = nautilus_icon_view_remove_file;
@@ -49,6 +49,8 @@ static GQuark attribute_name_q,
 /* msec delay after Loading... dummy row turns into (empty) */
 #define LOADING_TO_EMPTY_DELAY 100
 
+#define N_ICON_COLUMNS (NAUTILUS_LIST_MODEL_LARGEST_ICON_COLUMN - NAUTILUS_LIST_MODEL_SMALLEST_ICON_COLUMN + 1)
+
 static guint list_model_signals[LAST_SIGNAL] = { 0 };
 
 static int nautilus_list_model_file_entry_compare_func (gconstpointer a,
@@ -77,6 +79,12 @@ struct NautilusListModelDetails {
 	GPtrArray *columns;
 
 	GList *highlight_files;
+
+	GHashTable *parent_folders; /* parent NautilusFile -> ParentFolder */
+
+	/* Dates are shown as "Today", "Yesterday" and so on, so the
+	 * cached strings go stale at midnight */
+	guint day_changed_timeout_id;
 };
 
 typedef struct {
@@ -85,6 +93,15 @@ typedef struct {
 	GList *path_list;
 } DragDataGetInfo;
 
+/* What the rows of one folder's files need to know about it, kept
+ * up to date instead of asked for on every draw.
+ */
+typedef struct {
+	NautilusFile *file;
+	gulong changed_handler_id;
+	gboolean can_write;
+} ParentFolder;
+
 typedef struct FileEntry FileEntry;
 
 struct FileEntry {
@@ -95,6 +112,16 @@ struct FileEntry {
 	GSequence *files;
 	GSequenceIter *ptr;
 	guint loaded : 1;
+
+	/* Values computed on first use and kept until the file
+	 * changes, so redraws don't redo the work.
+	 */
+	GdkPixbuf *icons[N_ICON_COLUMNS];
+	guint icons_parent_can_write : 1; /* the icons' CANT_WRITE emblem depends on it */
+	guint parent_folder_known : 1;
+	ParentFolder *parent_folder; /* NULL if the file has no parent */
+	char **strings; /* indexed like details->columns */
+	guint n_strings;
 };
 
 G_DEFINE_TYPE_WITH_CODE (NautilusListModel, nautilus_list_model, G_TYPE_OBJECT,
@@ -112,9 +139,62 @@ static const GtkTargetEntry drag_types [] = {
 
 static GtkTargetList *drag_target_list = NULL;
 
+static void
+file_entry_clear_icons (FileEntry *file_entry)
+{
+	guint i;
+
+	for (i = 0; i < N_ICON_COLUMNS; i++) {
+		if (file_entry->icons[i] != NULL) {
+			g_object_unref (file_entry->icons[i]);
+			file_entry->icons[i] = NULL;
+		}
+	}
+}
+
+static void
+file_entry_clear_strings (FileEntry *file_entry)
+{
+	guint i;
+
+	for (i = 0; i < file_entry->n_strings; i++) {
+		g_free (file_entry->strings[i]);
+	}
+	g_free (file_entry->strings);
+	file_entry->strings = NULL;
+	file_entry->n_strings = 0;
+}
+
+static void
+file_entry_clear_cache (FileEntry *file_entry)
+{
+	file_entry_clear_icons (file_entry);
+	file_entry_clear_strings (file_entry);
+
+	/* The file may have moved to another folder */
+	file_entry->parent_folder = NULL;
+	file_entry->parent_folder_known = FALSE;
+}
+
+static void
+parent_folder_changed (NautilusFile *file,
+		       ParentFolder *folder)
+{
+	folder->can_write = nautilus_file_can_write (file);
+}
+
+static void
+parent_folder_free (ParentFolder *folder)
+{
+	g_signal_handler_disconnect (folder->file, folder->changed_handler_id);
+	nautilus_file_unref (folder->file);
+	g_free (folder);
+}
+
 static void
 file_entry_free (FileEntry *file_entry)
 {
+	file_entry_clear_cache (file_entry);
 	nautilus_file_unref (file_entry->file);
 	if (file_entry->reverse_map) {
 		g_hash_table_destroy (file_entry->reverse_map);
@@ -241,24 +321,131 @@ nautilus_list_model_get_path (GtkTreeModel *tree_model, GtkTreeIter *iter)
 	return path;
 }
 
+/* The CANT_WRITE emblem is left out when the whole folder is read only */
+static gboolean
+nautilus_list_model_parent_can_write (NautilusListModel *model,
+				      FileEntry *file_entry)
+{
+	NautilusFile *parent_file;
+	ParentFolder *folder;
+
+	if (!file_entry->parent_folder_known) {
+		parent_file = nautilus_file_get_parent (file_entry->file);
+		if (parent_file != NULL) {
+			folder = g_hash_table_lookup (model->details->parent_folders, parent_file);
+			if (folder == NULL) {
+				folder = g_new0 (ParentFolder, 1);
+				folder->file = parent_file;
+				folder->can_write = nautilus_file_can_write (parent_file);
+				folder->changed_handler_id =
+					g_signal_connect (parent_file, "changed",
+							  G_CALLBACK (parent_folder_changed), folder);
+				g_hash_table_insert (model->details->parent_folders,
+						     parent_file, folder);
+			} else {
+				nautilus_file_unref (parent_file);
+			}
+			file_entry->parent_folder = folder;
+		}
+		file_entry->parent_folder_known = TRUE;
+	}
+
+	return file_entry->parent_folder == NULL ||
+		file_entry->parent_folder->can_write;
+}
+
+static GdkPixbuf *
+nautilus_list_model_render_icon (NautilusFile *file,
+				 int icon_size,
+				 NautilusFileIconFlags flags,
+				 gboolean parent_can_write)
+{
+	GdkPixbuf *icon;
+	GIcon *gicon, *emblemed_icon, *emblem_icon;
+	NautilusIconInfo *icon_info;
+	GEmblem *emblem;
+	GList *emblem_icons, *l;
+	char *emblems_to_ignore[3];
+	int i;
+
+	gicon = G_ICON (nautilus_file_get_icon_pixbuf (file, icon_size, TRUE, flags));
+
+	/* render emblems with GEmblemedIcon */
+	i = 0;
+	emblems_to_ignore[i++] = NAUTILUS_FILE_EMBLEM_NAME_TRASH;
+	if (!parent_can_write) {
+		emblems_to_ignore[i++] = NAUTILUS_FILE_EMBLEM_NAME_CANT_WRITE;
+	}
+	emblems_to_ignore[i++] = NULL;
+
+	emblem_icons = nautilus_file_get_emblem_icons (file,
+						       emblems_to_ignore);
+
+	/* pick only the first emblem we can render for the list view */
+	for (l = emblem_icons; l != NULL; l = l->next) {
+		emblem_icon = l->data;
+		if (nautilus_icon_theme_can_render (G_THEMED_ICON (emblem_icon))) {
+			emblem = g_emblem_new (emblem_icon);
+			emblemed_icon = g_emblemed_icon_new (gicon, emblem);
+
+			g_object_unref (gicon);
+			g_object_unref (emblem);
+			gicon = emblemed_icon;
+
+			break;
+		}
+	}
+
+	g_list_free_full (emblem_icons, g_object_unref);
+
+	icon_info = nautilus_icon_info_lookup (gicon, icon_size);
+	icon = nautilus_icon_info_get_pixbuf_at_size (icon_info, icon_size);
+
+	g_object_unref (icon_info);
+	g_object_unref (gicon);
+
+	return icon;
+}
+
+static gboolean
+nautilus_list_model_is_drag_dest_row (NautilusListModel *model,
+				      GtkTreeIter *iter)
+{
+	GtkTreePath *path_a, *path_b;
+	gboolean result;
+
+	if (model->details->drag_view == NULL) {
+		return FALSE;
+	}
+
+	gtk_tree_view_get_drag_dest_row (model->details->drag_view,
+					 &path_a,
+					 NULL);
+	if (path_a == NULL) {
+		return FALSE;
+	}
+
+	path_b = gtk_tree_model_get_path (GTK_TREE_MODEL (model), iter);
+	result = gtk_tree_path_compare (path_a, path_b) == 0;
+
+	gtk_tree_path_free (path_a);
+	gtk_tree_path_free (path_b);
+
+	return result;
+}
+
 static void
 nautilus_list_model_get_value (GtkTreeModel *tree_model, GtkTreeIter *iter, int column, GValue *value)
 {
 	NautilusListModel *model;
 	FileEntry *file_entry;
 	NautilusFile *file;
-	char *str;
 	GdkPixbuf *icon, *rendered_icon;
-	GIcon *gicon, *emblemed_icon, *emblem_icon;
-	NautilusIconInfo *icon_info;
-	GEmblem *emblem;
-	GList *emblem_icons, *l;
 	int icon_size;
 	NautilusZoomLevel zoom_level;
-	NautilusFile *parent_file;
-	char *emblems_to_ignore[3];
-	int i;
 	NautilusFileIconFlags flags;
+	gboolean parent_can_write;
+	guint index;
 	
 	model = (NautilusListModel *)tree_model;
 
@@ -295,69 +482,39 @@ nautilus_list_model_get_value (GtkTreeModel *tree_model, GtkTreeIter *iter, int
 			flags = NAUTILUS_FILE_ICON_FLAGS_USE_THUMBNAILS |
 				NAUTILUS_FILE_ICON_FLAGS_FORCE_THUMBNAIL_SIZE |
 				NAUTILUS_FILE_ICON_FLAGS_USE_MOUNT_ICON_AS_EMBLEM;
-			if (model->details->drag_view != NULL) {
-				GtkTreePath *path_a, *path_b;
-				
-				gtk_tree_view_get_drag_dest_row (model->details->drag_view,
-								 &path_a,
-								 NULL);
-				if (path_a != NULL) {
-					path_b = gtk_tree_model_get_path (tree_model, iter);
-
-					if (gtk_tree_path_compare (path_a, path_b) == 0) {
-						flags |= NAUTILUS_FILE_ICON_FLAGS_FOR_DRAG_ACCEPT;
-					}
-						
-					gtk_tree_path_free (path_a);
-					gtk_tree_path_free (path_b);
-				}
-			}
 
-			gicon = G_ICON (nautilus_file_get_icon_pixbuf (file, icon_size, TRUE, flags));
+			parent_can_write = nautilus_list_model_parent_can_write (model, file_entry);
 
-			/* render emblems with GEmblemedIcon */
-			parent_file = nautilus_file_get_parent (file);
-			i = 0;
-			emblems_to_ignore[i++] = NAUTILUS_FILE_EMBLEM_NAME_TRASH;
-			if (parent_file) {
-				if (!nautilus_file_can_write (parent_file)) {
-					emblems_to_ignore[i++] = NAUTILUS_FILE_EMBLEM_NAME_CANT_WRITE;
+			/* The drag accept icon is short lived, so only
+			 * the plain icon is cached.
+			 */
+			if (nautilus_list_model_is_drag_dest_row (model, iter)) {
+				flags |= NAUTILUS_FILE_ICON_FLAGS_FOR_DRAG_ACCEPT;
+				icon = nautilus_list_model_render_icon (file, icon_size, flags,
+									parent_can_write);
+			} else {
+				/* The folder's permissions can change without
+				 * the file changing.
+				 */
+				if (file_entry->icons_parent_can_write != parent_can_write) {
+					file_entry_clear_icons (file_entry);
+					file_entry->icons_parent_can_write = parent_can_write;
 				}
-				nautilus_file_unref (parent_file);
-			}
-			emblems_to_ignore[i++] = NULL;
-
-			emblem_icons = nautilus_file_get_emblem_icons (file,
-								       emblems_to_ignore);
 
-			/* pick only the first emblem we can render for the list view */
-			for (l = emblem_icons; l != NULL; l = l->next) {
-				emblem_icon = l->data;
-				if (nautilus_icon_theme_can_render (G_THEMED_ICON (emblem_icon))) {
-					emblem = g_emblem_new (emblem_icon);
-					emblemed_icon = g_emblemed_icon_new (gicon, emblem);
-
-					g_object_unref (gicon);
-					g_object_unref (emblem);
-					gicon = emblemed_icon;
-
-					break;
+				index = column - NAUTILUS_LIST_MODEL_SMALLEST_ICON_COLUMN;
+				if (file_entry->icons[index] == NULL) {
+					file_entry->icons[index] =
+						nautilus_list_model_render_icon (file, icon_size, flags,
+										 parent_can_write);
 				}
+				icon = g_object_ref (file_entry->icons[index]);
 			}
 
-			g_list_free_full (emblem_icons, g_object_unref);
-
-			icon_info = nautilus_icon_info_lookup (gicon, icon_size);
-			icon = nautilus_icon_info_get_pixbuf_at_size (icon_info, icon_size);
-
-			g_object_unref (icon_info);
-			g_object_unref (gicon);
-
 			if (model->details->highlight_files != NULL &&
 			    g_list_find_custom (model->details->highlight_files,
 			                        file, (GCompareFunc) nautilus_file_compare_location))
 			{
-				rendered_icon = eel_create_spotlight_pixbuf (icon);
+				rendered_icon = eel_get_spotlight_pixbuf (icon);
 
 				if (rendered_icon != NULL) {
 					g_object_unref (icon);
@@ -385,9 +542,21 @@ nautilus_list_model_get_value (GtkTreeModel *tree_model, GtkTreeIter *iter, int
 				      "attribute_q", &attribute, 
 				      NULL);
 			if (file != NULL) {
-				str = nautilus_file_get_string_attribute_with_default_q (file, 
-											 attribute);
-				g_value_take_string (value, str);
+				index = column - NAUTILUS_LIST_MODEL_NUM_COLUMNS;
+				if (index >= file_entry->n_strings) {
+					/* Columns were added since the cache was made. */
+					file_entry->strings = g_renew (char *, file_entry->strings,
+								       model->details->columns->len);
+					memset (file_entry->strings + file_entry->n_strings, 0,
+						(model->details->columns->len - file_entry->n_strings) * sizeof (char *));
+					file_entry->n_strings = model->details->columns->len;
+				}
+				if (file_entry->strings[index] == NULL) {
+					file_entry->strings[index] =
+						nautilus_file_get_string_attribute_with_default_q (file, 
+												   attribute);
+				}
+				g_value_set_string (value, file_entry->strings[index]);
 			} else if (attribute == attribute_name_q) {
 				if (file_entry->parent->loaded) {
 					g_value_set_string (value, _("(Empty)"));
@@ -687,12 +856,14 @@ static void
 nautilus_list_model_sort_file_entries (NautilusListModel *model, GSequence *files, GtkTreePath *path)
 {
 	GSequenceIter **old_order;
+	GSequenceIter *ptr, *end;
+	NautilusFile **sort_files;
 	GtkTreeIter iter;
 	int *new_order;
 	int length;
 	int i;
 	FileEntry *file_entry;
-	gboolean has_iter;
+	gboolean has_iter, has_dummy;
 
 	length = g_sequence_get_length (files);
 
@@ -702,9 +873,10 @@ nautilus_list_model_sort_file_entries (NautilusListModel *model, GSequence *file
 	
 	/* generate old order of GSequenceIter's */
 	old_order = g_new (GSequenceIter *, length);
+	sort_files = g_new (NautilusFile *, length);
+	has_dummy = FALSE;
+	ptr = g_sequence_get_begin_iter (files);
 	for (i = 0; i < length; ++i) {
-		GSequenceIter *ptr = g_sequence_get_iter_at_pos (files, i);
-		
 		file_entry = g_sequence_get (ptr);
 		if (file_entry->files != NULL) {
 			gtk_tree_path_append_index (path, i);
@@ -713,17 +885,36 @@ nautilus_list_model_sort_file_entries (NautilusListModel *model, GSequence *file
 		}
 
 		old_order[i] = ptr;
+		sort_files[i] = file_entry->file;
+		has_dummy |= file_entry->file == NULL;
+		ptr = g_sequence_iter_next (ptr);
 	}
 
-	/* sort */
-	g_sequence_sort (files, nautilus_list_model_file_entry_compare_func, model);
-
-	/* generate new order */
-	new_order = g_new (int, length);
 	/* Note: new_order[newpos] = oldpos */
-	for (i = 0; i < length; ++i) {
-		new_order[g_sequence_iter_get_position (old_order[i])] = i;
+	new_order = g_new (int, length);
+
+	if (!has_dummy) {
+		/* Sort with keys made once per file, then move the
+		 * entries into place.
+		 */
+		nautilus_file_sort_by_attribute_q (sort_files, length,
+						   model->details->sort_attribute,
+						   model->details->sort_directories_first,
+						   (model->details->order == GTK_SORT_DESCENDING),
+						   new_order);
+
+		end = g_sequence_get_end_iter (files);
+		for (i = 0; i < length; ++i) {
+			g_sequence_move (old_order[new_order[i]], end);
+		}
+	} else {
+		g_sequence_sort (files, nautilus_list_model_file_entry_compare_func, model);
+
+		for (i = 0; i < length; ++i) {
+			new_order[g_sequence_iter_get_position (old_order[i])] = i;
+		}
 	}
+	g_free (sort_files);
 
 	/* Let the world know about our new order */
 
@@ -1026,6 +1217,7 @@ nautilus_list_model_file_changed (NautilusListModel *model, NautilusFile *file,
 		return;
 	}
 
+	file_entry_clear_cache (g_sequence_get (ptr));
 	
 	pos_before = g_sequence_iter_get_position (ptr);
 		
@@ -1201,6 +1393,7 @@ nautilus_list_model_clear (NautilusListModel *model)
 	g_return_if_fail (model != NULL);
 
 	nautilus_list_model_clear_directory (model, model->details->files);
+	g_hash_table_remove_all (model->details->parent_folders);
 }
 
 NautilusFile *
@@ -1477,6 +1670,56 @@ nautilus_list_model_get_column_number (NautilusListModel *model,
 	return -1;
 }
 
+static gboolean
+clear_strings_foreach (GtkTreeModel *tree_model,
+		       GtkTreePath *path,
+		       GtkTreeIter *iter,
+		       gpointer data)
+{
+	file_entry_clear_strings (g_sequence_get (iter->user_data));
+	gtk_tree_model_row_changed (tree_model, path, iter);
+
+	return FALSE;
+}
+
+static void schedule_day_changed (NautilusListModel *model);
+
+static gboolean
+day_changed_callback (gpointer data)
+{
+	NautilusListModel *model;
+
+	model = NAUTILUS_LIST_MODEL (data);
+
+	gtk_tree_model_foreach (GTK_TREE_MODEL (model), clear_strings_foreach, NULL);
+	schedule_day_changed (model);
+
+	return FALSE;
+}
+
+static void
+schedule_day_changed (NautilusListModel *model)
+{
+	GDateTime *now, *today, *tomorrow;
+	GTimeSpan until_tomorrow;
+
+	now = g_date_time_new_now_local ();
+	today = g_date_time_new_local (g_date_time_get_year (now),
+				       g_date_time_get_month (now),
+				       g_date_time_get_day_of_month (now),
+				       0, 0, 0);
+	tomorrow = g_date_time_add_days (today, 1);
+	until_tomorrow = g_date_time_difference (tomorrow, now);
+
+	g_date_time_unref (tomorrow);
+	g_date_time_unref (today);
+	g_date_time_unref (now);
+
+	model->details->day_changed_timeout_id =
+		g_timeout_add_seconds (until_tomorrow / G_USEC_PER_SEC + 1,
+				       day_changed_callback, model);
+}
+
 static void
 nautilus_list_model_dispose (GObject *object)
 {
@@ -1485,6 +1728,11 @@ nautilus_list_model_dispose (GObject *object)
 
 	model = NAUTILUS_LIST_MODEL (object);
 
+	if (model->details->day_changed_timeout_id != 0) {
+		g_source_remove (model->details->day_changed_timeout_id);
+		model->details->day_changed_timeout_id = 0;
+	}
+
 	if (model->details->columns) {
 		for (i = 0; i < model->details->columns->len; i++) {
 			g_object_unref (model->details->columns->pdata[i]);
@@ -1506,6 +1754,10 @@ nautilus_list_model_dispose (GObject *object)
 		g_hash_table_destroy (model->details->directory_reverse_map);
 		model->details->directory_reverse_map = NULL;
 	}
+	if (model->details->parent_folders) {
+		g_hash_table_destroy (model->details->parent_folders);
+		model->details->parent_folders = NULL;
+	}
 
 	G_OBJECT_CLASS (nautilus_list_model_parent_class)->dispose (object);
 }
@@ -1534,9 +1786,13 @@ nautilus_list_model_init (NautilusListModel *model)
 	model->details->files = g_sequence_new ((GDestroyNotify)file_entry_free);
 	model->details->top_reverse_map = g_hash_table_new (g_direct_hash, g_direct_equal);
 	model->details->directory_reverse_map = g_hash_table_new (g_direct_hash, g_direct_equal);
+	model->details->parent_folders = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+								NULL, (GDestroyNotify) parent_folder_free);
 	model->details->stamp = g_random_int ();
 	model->details->sort_attribute = 0;
 	model->details->columns = g_ptr_array_new ();
+
+	schedule_day_changed (model);
 }
 
 static void
@@ -2247,6 +2247,36 @@ nautilus_list_view_get_selection (NautilusView *view)
 	return g_list_reverse (list);
 }
 
+static int
+nautilus_list_view_get_selection_count (NautilusView *view)
+{
+	return gtk_tree_selection_count_selected_rows
+		(gtk_tree_view_get_selection (NAUTILUS_LIST_VIEW (view)->details->tree_view));
+}
+
+static gboolean
+nautilus_list_view_is_file_selected (NautilusView *view,
+				     NautilusFile *file)
+{
+	NautilusListView *list_view;
+	GtkTreeSelection *selection;
+	GList *iters, *l;
+	gboolean selected;
+
+	list_view = NAUTILUS_LIST_VIEW (view);
+	selection = gtk_tree_view_get_selection (list_view->details->tree_view);
+
+	/* A file can show up more than once when subfolders are expanded */
+	iters = nautilus_list_model_get_all_iters_for_file (list_view->details->model, file);
+	selected = FALSE;
+	for (l = iters; l != NULL && !selected; l = l->next) {
+		selected = gtk_tree_selection_iter_is_selected (selection, l->data);
+	}
+	g_list_free_full (iters, g_free);
+
+	return selected;
+}
+
 static void
 nautilus_list_view_get_selection_for_file_transfer_foreach_func (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, gpointer data)
 {
@@ -3305,6 +3335,8 @@ nautilus_list_view_class_init (NautilusListViewClass *class)
 	nautilus_view_class->file_changed = nautilus_list_view_file_changed;
 	nautilus_view_class->get_backing_uri = nautilus_list_view_get_backing_uri;
 	nautilus_view_class->get_selection = nautilus_list_view_get_selection;
+	nautilus_view_class->get_selection_count = nautilus_list_view_get_selection_count;
+	nautilus_view_class->is_file_selected = nautilus_list_view_is_file_selected;
 	nautilus_view_class->get_selection_for_file_transfer = nautilus_list_view_get_selection_for_file_transfer;
 	nautilus_view_class->get_item_count = nautilus_list_view_get_item_count;
 	nautilus_view_class->is_empty = nautilus_list_view_is_empty;
@@ -33,6 +33,7 @@
 #include "nautilus-application.h"
 
 #include <libnautilus-private/nautilus-debug.h>
+#include <libnautilus-private/nautilus-trace.h>
 #include <eel/eel-debug.h>
 
 #include <glib/gi18n.h>
@@ -78,6 +79,8 @@ main (int argc, char *argv[])
 	g_type_init ();
 	g_thread_init (NULL);
 
+	nautilus_trace_init ();
+
 	/* This will be done by gtk+ later, but for now, force it to GNOME */
 	g_desktop_app_info_set_desktop_env ("GNOME");
 
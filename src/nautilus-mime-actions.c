@@ -28,6 +28,7 @@
 
 #include "nautilus-window-slot.h"
 
+#include <eel/eel-debug.h>
 #include <eel/eel-glib-extensions.h>
 #include <eel/eel-stock-dialogs.h>
 #include <eel/eel-string.h>
@@ -276,6 +277,186 @@ filter_non_uri_apps (GList *apps)
 }
 
 
+/* Asking GIO for the applications of a mime type reads the mime
+ * database every time, which adds up when a large selection is opened
+ * or right-clicked. The answers are remembered per mime type until the
+ * mime data changes, or for at most MIME_APPS_CACHE_LIFETIME seconds so
+ * that associations changed by other programs are still picked up.
+ */
+#define MIME_APPS_CACHE_LIFETIME 30
+
+static GHashTable *default_app_cache;	/* "type\tremote" -> GAppInfo or NULL */
+static GHashTable *uri_handler_cache;	/* scheme -> GAppInfo or NULL */
+static GHashTable *all_apps_cache;	/* type -> GList of GAppInfo */
+static gint64 mime_apps_cache_time;
+
+static void
+app_info_unref_if_set (GAppInfo *app)
+{
+	if (app != NULL) {
+		g_object_unref (app);
+	}
+}
+
+static void
+app_info_list_free (GList *apps)
+{
+	g_list_free_full (apps, g_object_unref);
+}
+
+static void
+clear_mime_apps_cache (void)
+{
+	if (default_app_cache == NULL) {
+		return;
+	}
+
+	g_hash_table_remove_all (default_app_cache);
+	g_hash_table_remove_all (uri_handler_cache);
+	g_hash_table_remove_all (all_apps_cache);
+	mime_apps_cache_time = g_get_monotonic_time ();
+}
+
+static void
+mime_data_changed_callback (GObject *signaller,
+			    gpointer user_data)
+{
+	DEBUG ("Mime data changed, dropping cached applications");
+	clear_mime_apps_cache ();
+}
+
+static void
+free_mime_apps_cache (void)
+{
+	g_hash_table_destroy (default_app_cache);
+	default_app_cache = NULL;
+	g_hash_table_destroy (uri_handler_cache);
+	uri_handler_cache = NULL;
+	g_hash_table_destroy (all_apps_cache);
+	all_apps_cache = NULL;
+}
+
+static void
+ensure_mime_apps_cache (void)
+{
+	static gboolean connected = FALSE;
+
+	if (default_app_cache != NULL) {
+		if (g_get_monotonic_time () - mime_apps_cache_time >
+		    MIME_APPS_CACHE_LIFETIME * G_USEC_PER_SEC) {
+			clear_mime_apps_cache ();
+		}
+		return;
+	}
+
+	default_app_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+						   (GDestroyNotify) app_info_unref_if_set);
+	uri_handler_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+						   (GDestroyNotify) app_info_unref_if_set);
+	all_apps_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+						(GDestroyNotify) app_info_list_free);
+	mime_apps_cache_time = g_get_monotonic_time ();
+
+	if (!connected) {
+		g_signal_connect (nautilus_signaller_get_current (), "mime_data_changed",
+				  G_CALLBACK (mime_data_changed_callback), NULL);
+		eel_debug_call_at_shutdown (free_mime_apps_cache);
+		connected = TRUE;
+	}
+}
+
+static GAppInfo *
+get_default_application_for_type (const char *mime_type,
+				  gboolean must_support_uris)
+{
+	GAppInfo *app;
+	char *key;
+
+	ensure_mime_apps_cache ();
+
+	key = g_strdup_printf ("%s\t%d", mime_type, must_support_uris);
+	if (g_hash_table_lookup_extended (default_app_cache, key,
+					  NULL, (gpointer *) &app)) {
+		g_free (key);
+	} else {
+		app = g_app_info_get_default_for_type (mime_type, must_support_uris);
+		g_hash_table_insert (default_app_cache, key, app);
+	}
+
+	return app != NULL ? g_object_ref (app) : NULL;
+}
+
+static GAppInfo *
+get_default_application_for_uri_scheme (const char *uri_scheme)
+{
+	GAppInfo *app;
+
+	ensure_mime_apps_cache ();
+
+	if (!g_hash_table_lookup_extended (uri_handler_cache, uri_scheme,
+					   NULL, (gpointer *) &app)) {
+		app = g_app_info_get_default_for_uri_scheme (uri_scheme);
+		g_hash_table_insert (uri_handler_cache, g_strdup (uri_scheme), app);
+	}
+
+	return app != NULL ? g_object_ref (app) : NULL;
+}
+
+static GList *
+get_all_applications_for_type (const char *mime_type)
+{
+	GList *apps;
+
+	ensure_mime_apps_cache ();
+
+	if (!g_hash_table_lookup_extended (all_apps_cache, mime_type,
+					   NULL, (gpointer *) &apps)) {
+		apps = g_app_info_get_all_for_type (mime_type);
+		g_hash_table_insert (all_apps_cache, g_strdup (mime_type), apps);
+	}
+
+	return eel_g_object_list_copy (apps);
+}
+
+/* Returns one file for each distinct pair of mime type and parent
+ * folder in @files. The parent decides the uri scheme and whether the
+ * file has a local path, so these are all the application lookups
+ * depend on. The files are not reffed.
+ */
+static GList *
+get_files_with_distinct_mime_types (GList *files)
+{
+	GHashTable *seen;
+	GList *l, *ret;
+	NautilusFile *file;
+	char *mime_type, *parent_uri, *key;
+
+	seen = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+	ret = NULL;
+	for (l = files; l != NULL; l = l->next) {
+		file = l->data;
+
+		mime_type = nautilus_file_get_mime_type (file);
+		parent_uri = nautilus_file_get_parent_uri (file);
+		key = g_strconcat (mime_type, "\n", parent_uri, NULL);
+		g_free (mime_type);
+		g_free (parent_uri);
+
+		if (g_hash_table_lookup_extended (seen, key, NULL, NULL)) {
+			g_free (key);
+			continue;
+		}
+
+		g_hash_table_insert (seen, key, NULL);
+		ret = g_list_prepend (ret, file);
+	}
+
+	g_hash_table_destroy (seen);
+
+	return g_list_reverse (ret);
+}
+
 static gboolean
 nautilus_mime_actions_check_if_required_attributes_ready (NautilusFile *file)
 {
@@ -332,13 +513,13 @@ nautilus_mime_get_default_application_for_file (NautilusFile *file)
 	}
 
 	mime_type = nautilus_file_get_mime_type (file);
-	app = g_app_info_get_default_for_type (mime_type, !file_has_local_path (file));
+	app = get_default_application_for_type (mime_type, !file_has_local_path (file));
 	g_free (mime_type);
 
 	if (app == NULL) {
 		uri_scheme = nautilus_file_get_uri_scheme (file);
 		if (uri_scheme != NULL) {
-			app = g_app_info_get_default_for_uri_scheme (uri_scheme);
+			app = get_default_application_for_uri_scheme (uri_scheme);
 			g_free (uri_scheme);
 		}
 	}
@@ -346,41 +527,6 @@ nautilus_mime_get_default_application_for_file (NautilusFile *file)
 	return app;
 }
 
-static int
-file_compare_by_mime_type (NautilusFile *file_a,
-			   NautilusFile *file_b)
-{
-	char *mime_type_a, *mime_type_b;
-	int ret;
-	
-	mime_type_a = nautilus_file_get_mime_type (file_a);
-	mime_type_b = nautilus_file_get_mime_type (file_b);
-	
-	ret = strcmp (mime_type_a, mime_type_b);
-	
-	g_free (mime_type_a);
-	g_free (mime_type_b);
-	
-	return ret;
-}
-
-static int
-file_compare_by_parent_uri (NautilusFile *file_a,
-			    NautilusFile *file_b) {
-	char *parent_uri_a, *parent_uri_b;
-	int ret;
-
-	parent_uri_a = nautilus_file_get_parent_uri (file_a);
-	parent_uri_b = nautilus_file_get_parent_uri (file_b);
-
-	ret = strcmp (parent_uri_a, parent_uri_b);
-
-	g_free (parent_uri_a);
-	g_free (parent_uri_b);
-
-	return ret;
-}
-
 static int
 application_compare_by_name (const GAppInfo *app_a,
 			     const GAppInfo *app_b)
@@ -432,11 +578,11 @@ nautilus_mime_get_applications_for_file (NautilusFile *file)
 		return NULL;
 	}
 	mime_type = nautilus_file_get_mime_type (file);
-	result = g_app_info_get_all_for_type (mime_type);
+	result = get_all_applications_for_type (mime_type);
 
 	uri_scheme = nautilus_file_get_uri_scheme (file);
 	if (uri_scheme != NULL) {
-		uri_handler = g_app_info_get_default_for_uri_scheme (uri_scheme);
+		uri_handler = get_default_application_for_uri_scheme (uri_scheme);
 		if (uri_handler) {
 			result = g_list_prepend (result, uri_handler);
 		}
@@ -457,24 +603,18 @@ nautilus_mime_get_applications_for_file (NautilusFile *file)
 GAppInfo *
 nautilus_mime_get_default_application_for_files (GList *files)
 {
-	GList *l, *sorted_files;
+	GList *l, *distinct_files;
 	NautilusFile *file;
 	GAppInfo *app, *one_app;
 
 	g_assert (files != NULL);
 
-	sorted_files = g_list_sort (g_list_copy (files), (GCompareFunc) file_compare_by_mime_type);
+	distinct_files = get_files_with_distinct_mime_types (files);
 
 	app = NULL;
-	for (l = sorted_files; l != NULL; l = l->next) {
+	for (l = distinct_files; l != NULL; l = l->next) {
 		file = l->data;
 
-		if (l->prev &&
-		    file_compare_by_mime_type (file, l->prev->data) == 0 &&
-		    file_compare_by_parent_uri (file, l->prev->data) == 0) {
-			continue;
-		}
-
 		one_app = nautilus_mime_get_default_application_for_file (file);
 		if (one_app == NULL || (app != NULL && !g_app_info_equal (app, one_app))) {
 			if (app) {
@@ -494,7 +634,7 @@ nautilus_mime_get_default_application_for_files (GList *files)
 		}
 	}
 
-	g_list_free (sorted_files);
+	g_list_free (distinct_files);
 
 	return app;
 }
@@ -548,24 +688,18 @@ intersect_application_lists (GList *a,
 GList *
 nautilus_mime_get_applications_for_files (GList *files)
 {
-	GList *l, *sorted_files;
+	GList *l, *distinct_files;
 	NautilusFile *file;
 	GList *one_ret, *ret;
 
 	g_assert (files != NULL);
 
-	sorted_files = g_list_sort (g_list_copy (files), (GCompareFunc) file_compare_by_mime_type);
+	distinct_files = get_files_with_distinct_mime_types (files);
 
 	ret = NULL;
-	for (l = sorted_files; l != NULL; l = l->next) {
+	for (l = distinct_files; l != NULL; l = l->next) {
 		file = l->data;
 
-		if (l->prev &&
-		    file_compare_by_mime_type (file, l->prev->data) == 0 &&
-		    file_compare_by_parent_uri (file, l->prev->data) == 0) {
-			continue;
-		}
-
 		one_ret = nautilus_mime_get_applications_for_file (file);
 		one_ret = g_list_sort (one_ret, (GCompareFunc) application_compare_by_id);
 		if (ret != NULL) {
@@ -579,7 +713,7 @@ nautilus_mime_get_applications_for_files (GList *files)
 		}
 	}
 
-	g_list_free (sorted_files);
+	g_list_free (distinct_files);
 
 	ret = g_list_sort (ret, (GCompareFunc) application_compare_by_name);
 	
@@ -100,6 +100,7 @@ typedef struct {
 	GtkTreePath *eject_highlight_path;
 
 	guint bookmarks_changed_id;
+	guint update_places_idle_id;
 } NautilusPlacesSidebar;
 
 typedef struct {
@@ -130,6 +131,7 @@ enum {
 	PLACES_SIDEBAR_COLUMN_EJECT_ICON,
 	PLACES_SIDEBAR_COLUMN_SECTION_TYPE,
 	PLACES_SIDEBAR_COLUMN_HEADING_TEXT,
+	PLACES_SIDEBAR_COLUMN_GICON,
 
 	PLACES_SIDEBAR_COLUMN_COUNT
 };
@@ -272,38 +274,69 @@ is_built_in_bookmark (NautilusFile *file)
 	return built_in;
 }
 
-static GtkTreeIter
+/* A row as update_places() wants it; the store is then changed to
+ * match, so rows that stay the same aren't touched and their icons
+ * aren't looked up again.
+ */
+typedef struct {
+	PlaceType place_type;
+	SectionType section_type;
+	char *name;
+	GIcon *icon;
+	char *uri;
+	GDrive *drive;
+	GVolume *volume;
+	GMount *mount;
+	int index;
+	char *tooltip;
+	gboolean show_eject_button;
+} PlaceRow;
+
+static void
+place_row_free (PlaceRow *row)
+{
+	g_free (row->name);
+	if (row->icon != NULL) {
+		g_object_unref (row->icon);
+	}
+	g_free (row->uri);
+	if (row->drive != NULL) {
+		g_object_unref (row->drive);
+	}
+	if (row->volume != NULL) {
+		g_object_unref (row->volume);
+	}
+	if (row->mount != NULL) {
+		g_object_unref (row->mount);
+	}
+	g_free (row->tooltip);
+	g_free (row);
+}
+
+static void
 add_heading (NautilusPlacesSidebar *sidebar,
+	     GPtrArray *rows,
 	     SectionType section_type,
 	     const gchar *title)
 {
-	GtkTreeIter iter, child_iter;
-
-	gtk_list_store_append (sidebar->store, &iter);
-	gtk_list_store_set (sidebar->store, &iter,
-			    PLACES_SIDEBAR_COLUMN_ROW_TYPE, PLACES_HEADING,
-			    PLACES_SIDEBAR_COLUMN_SECTION_TYPE, section_type,	
-			    PLACES_SIDEBAR_COLUMN_HEADING_TEXT, title,
-			    PLACES_SIDEBAR_COLUMN_EJECT, FALSE,
-			    PLACES_SIDEBAR_COLUMN_NO_EJECT, TRUE,
-			    -1);
-
-	gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (sidebar->filter_model));
-	gtk_tree_model_filter_convert_child_iter_to_iter (GTK_TREE_MODEL_FILTER (sidebar->filter_model),
-							  &child_iter,
-							  &iter);
+	PlaceRow *row;
 
-	return child_iter;
+	row = g_new0 (PlaceRow, 1);
+	row->place_type = PLACES_HEADING;
+	row->section_type = section_type;
+	row->name = g_strdup (title);
+	g_ptr_array_add (rows, row);
 }
 
 static void
 check_heading_for_section (NautilusPlacesSidebar *sidebar,
+			   GPtrArray *rows,
 			   SectionType section_type)
 {
 	switch (section_type) {
 	case SECTION_DEVICES:
 		if (!sidebar->devices_header_added) {
-			add_heading (sidebar, SECTION_DEVICES,
+			add_heading (sidebar, rows, SECTION_DEVICES,
 				     _("Devices"));
 			sidebar->devices_header_added = TRUE;
 		}
@@ -311,7 +344,7 @@ check_heading_for_section (NautilusPlacesSidebar *sidebar,
 		break;
 	case SECTION_BOOKMARKS:
 		if (!sidebar->bookmarks_header_added) {
-			add_heading (sidebar, SECTION_BOOKMARKS,
+			add_heading (sidebar, rows, SECTION_BOOKMARKS,
 				     _("Bookmarks"));
 			sidebar->bookmarks_header_added = TRUE;
 		}
@@ -322,8 +355,9 @@ check_heading_for_section (NautilusPlacesSidebar *sidebar,
 	}
 }
 
-static GtkTreeIter
+static void
 add_place (NautilusPlacesSidebar *sidebar,
+	   GPtrArray *rows,
 	   PlaceType place_type,
 	   SectionType section_type,
 	   const char *name,
@@ -335,67 +369,270 @@ add_place (NautilusPlacesSidebar *sidebar,
 	   const int index,
 	   const char *tooltip)
 {
-	GdkPixbuf            *pixbuf;
-	GtkTreeIter           iter, child_iter;
-	GdkPixbuf	     *eject;
-	NautilusIconInfo *icon_info;
-	int icon_size;
+	PlaceRow *row;
 	gboolean show_eject, show_unmount;
-	gboolean show_eject_button;
 
-	check_heading_for_section (sidebar, section_type);
+	check_heading_for_section (sidebar, rows, section_type);
+
+	check_unmount_and_eject (mount, volume, drive,
+				 &show_unmount, &show_eject);
+
+	if (show_unmount || show_eject) {
+		g_assert (place_type != PLACES_BOOKMARK);
+	}
+
+	row = g_new0 (PlaceRow, 1);
+	row->place_type = place_type;
+	row->section_type = section_type;
+	row->name = g_strdup (name);
+	row->icon = g_object_ref (icon);
+	row->uri = g_strdup (uri);
+	row->drive = drive != NULL ? g_object_ref (drive) : NULL;
+	row->volume = volume != NULL ? g_object_ref (volume) : NULL;
+	row->mount = mount != NULL ? g_object_ref (mount) : NULL;
+	row->index = index;
+	row->tooltip = g_strdup (tooltip);
+	row->show_eject_button = mount != NULL && (show_unmount || show_eject);
+	g_ptr_array_add (rows, row);
+}
+
+/* Whether the store row at iter is the place in row, maybe with a
+ * different name, icon or such.
+ */
+static gboolean
+place_row_is_at_iter (NautilusPlacesSidebar *sidebar,
+		      PlaceRow *row,
+		      GtkTreeIter *iter)
+{
+	PlaceType place_type;
+	SectionType section_type;
+	char *uri;
+	GDrive *drive;
+	GVolume *volume;
+	GMount *mount;
+	gboolean same;
+
+	gtk_tree_model_get (GTK_TREE_MODEL (sidebar->store), iter,
+			    PLACES_SIDEBAR_COLUMN_ROW_TYPE, &place_type,
+			    PLACES_SIDEBAR_COLUMN_SECTION_TYPE, &section_type,
+			    -1);
+	if (place_type != row->place_type ||
+	    section_type != row->section_type) {
+		return FALSE;
+	}
+	if (place_type == PLACES_HEADING) {
+		return TRUE;
+	}
+
+	gtk_tree_model_get (GTK_TREE_MODEL (sidebar->store), iter,
+			    PLACES_SIDEBAR_COLUMN_URI, &uri,
+			    PLACES_SIDEBAR_COLUMN_DRIVE, &drive,
+			    PLACES_SIDEBAR_COLUMN_VOLUME, &volume,
+			    PLACES_SIDEBAR_COLUMN_MOUNT, &mount,
+			    -1);
+
+	same = g_strcmp0 (uri, row->uri) == 0 &&
+		drive == row->drive &&
+		volume == row->volume &&
+		mount == row->mount;
+
+	g_free (uri);
+	if (drive != NULL) {
+		g_object_unref (drive);
+	}
+	if (volume != NULL) {
+		g_object_unref (volume);
+	}
+	if (mount != NULL) {
+		g_object_unref (mount);
+	}
+
+	return same;
+}
+
+static GdkPixbuf *
+get_place_icon (GIcon *icon)
+{
+	NautilusIconInfo *icon_info;
+	GdkPixbuf *pixbuf;
+	int icon_size;
 
 	icon_size = nautilus_get_icon_size_for_stock_size (GTK_ICON_SIZE_MENU);
 	icon_info = nautilus_icon_info_lookup (icon, icon_size);
-
 	pixbuf = nautilus_icon_info_get_pixbuf_at_size (icon_info, icon_size);
 	g_object_unref (icon_info);
 
-	check_unmount_and_eject (mount, volume, drive,
-				 &show_unmount, &show_eject);
+	return pixbuf;
+}
 
-	if (show_unmount || show_eject) {
-		g_assert (place_type != PLACES_BOOKMARK);
+/* Makes the store row at iter show row. Only the columns that
+ * differ are set; returns whether there were any.
+ */
+static gboolean
+set_place_row (NautilusPlacesSidebar *sidebar,
+	       PlaceRow *row,
+	       GtkTreeIter *iter,
+	       gboolean new_row)
+{
+	GtkTreeModel *model;
+	char *name, *tooltip;
+	GIcon *icon;
+	int index;
+	gboolean show_eject_button, changed;
+	GdkPixbuf *pixbuf, *eject;
+
+	model = GTK_TREE_MODEL (sidebar->store);
+
+	if (row->place_type == PLACES_HEADING) {
+		if (!new_row) {
+			return FALSE;
+		}
+		gtk_list_store_set (sidebar->store, iter,
+				    PLACES_SIDEBAR_COLUMN_ROW_TYPE, PLACES_HEADING,
+				    PLACES_SIDEBAR_COLUMN_SECTION_TYPE, row->section_type,
+				    PLACES_SIDEBAR_COLUMN_HEADING_TEXT, row->name,
+				    PLACES_SIDEBAR_COLUMN_EJECT, FALSE,
+				    PLACES_SIDEBAR_COLUMN_NO_EJECT, TRUE,
+				    -1);
+		return TRUE;
 	}
 
-	if (mount == NULL) {
-		show_eject_button = FALSE;
+	if (new_row) {
+		gtk_list_store_set (sidebar->store, iter,
+				    PLACES_SIDEBAR_COLUMN_URI, row->uri,
+				    PLACES_SIDEBAR_COLUMN_DRIVE, row->drive,
+				    PLACES_SIDEBAR_COLUMN_VOLUME, row->volume,
+				    PLACES_SIDEBAR_COLUMN_MOUNT, row->mount,
+				    PLACES_SIDEBAR_COLUMN_ROW_TYPE, row->place_type,
+				    PLACES_SIDEBAR_COLUMN_BOOKMARK, row->place_type != PLACES_BOOKMARK,
+				    PLACES_SIDEBAR_COLUMN_SECTION_TYPE, row->section_type,
+				    -1);
+		name = NULL;
+		tooltip = NULL;
+		icon = NULL;
+		index = -1;
+		show_eject_button = !row->show_eject_button;
 	} else {
-		show_eject_button = (show_unmount || show_eject);
+		gtk_tree_model_get (model, iter,
+				    PLACES_SIDEBAR_COLUMN_NAME, &name,
+				    PLACES_SIDEBAR_COLUMN_TOOLTIP, &tooltip,
+				    PLACES_SIDEBAR_COLUMN_GICON, &icon,
+				    PLACES_SIDEBAR_COLUMN_INDEX, &index,
+				    PLACES_SIDEBAR_COLUMN_EJECT, &show_eject_button,
+				    -1);
 	}
 
-	if (show_eject_button) {
-		eject = get_eject_icon (sidebar, FALSE);
-	} else {
-		eject = NULL;
-	}
-
-	gtk_list_store_append (sidebar->store, &iter);
-	gtk_list_store_set (sidebar->store, &iter,
-			    PLACES_SIDEBAR_COLUMN_ICON, pixbuf,
-			    PLACES_SIDEBAR_COLUMN_NAME, name,
-			    PLACES_SIDEBAR_COLUMN_URI, uri,
-			    PLACES_SIDEBAR_COLUMN_DRIVE, drive,
-			    PLACES_SIDEBAR_COLUMN_VOLUME, volume,
-			    PLACES_SIDEBAR_COLUMN_MOUNT, mount,
-			    PLACES_SIDEBAR_COLUMN_ROW_TYPE, place_type,
-			    PLACES_SIDEBAR_COLUMN_INDEX, index,
-			    PLACES_SIDEBAR_COLUMN_EJECT, show_eject_button,
-			    PLACES_SIDEBAR_COLUMN_NO_EJECT, !show_eject_button,
-			    PLACES_SIDEBAR_COLUMN_BOOKMARK, place_type != PLACES_BOOKMARK,
-			    PLACES_SIDEBAR_COLUMN_TOOLTIP, tooltip,
-			    PLACES_SIDEBAR_COLUMN_EJECT_ICON, eject,
-			    PLACES_SIDEBAR_COLUMN_SECTION_TYPE, section_type,
-			    -1);
+	changed = new_row;
+
+	if (g_strcmp0 (name, row->name) != 0) {
+		gtk_list_store_set (sidebar->store, iter,
+				    PLACES_SIDEBAR_COLUMN_NAME, row->name,
+				    -1);
+		changed = TRUE;
+	}
+	if (g_strcmp0 (tooltip, row->tooltip) != 0) {
+		gtk_list_store_set (sidebar->store, iter,
+				    PLACES_SIDEBAR_COLUMN_TOOLTIP, row->tooltip,
+				    -1);
+		changed = TRUE;
+	}
+	if (index != row->index) {
+		gtk_list_store_set (sidebar->store, iter,
+				    PLACES_SIDEBAR_COLUMN_INDEX, row->index,
+				    -1);
+		changed = TRUE;
+	}
+	if (icon == NULL || !g_icon_equal (icon, row->icon)) {
+		pixbuf = get_place_icon (row->icon);
+		gtk_list_store_set (sidebar->store, iter,
+				    PLACES_SIDEBAR_COLUMN_ICON, pixbuf,
+				    PLACES_SIDEBAR_COLUMN_GICON, row->icon,
+				    -1);
+		if (pixbuf != NULL) {
+			g_object_unref (pixbuf);
+		}
+		changed = TRUE;
+	}
+	if (show_eject_button != row->show_eject_button) {
+		if (row->show_eject_button) {
+			eject = get_eject_icon (sidebar, FALSE);
+		} else {
+			eject = NULL;
+		}
+		gtk_list_store_set (sidebar->store, iter,
+				    PLACES_SIDEBAR_COLUMN_EJECT, row->show_eject_button,
+				    PLACES_SIDEBAR_COLUMN_NO_EJECT, !row->show_eject_button,
+				    PLACES_SIDEBAR_COLUMN_EJECT_ICON, eject,
+				    -1);
+		if (eject != NULL) {
+			g_object_unref (eject);
+		}
+		changed = TRUE;
+	}
+
+	g_free (name);
+	g_free (tooltip);
+	if (icon != NULL) {
+		g_object_unref (icon);
+	}
+
+	return changed;
+}
+
+/* Changes the store to show rows, keeping the rows that are still
+ * there. Returns whether anything changed.
+ */
+static gboolean
+update_store (NautilusPlacesSidebar *sidebar,
+	      GPtrArray *rows)
+{
+	GtkTreeIter iter, new_iter;
+	gboolean valid, found, changed;
+	guint i, j;
+
+	changed = FALSE;
+	valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (sidebar->store), &iter);
+
+	for (i = 0; i < rows->len; i++) {
+		/* Drop the rows that are gone, up to the next one that
+		 * is still there.
+		 */
+		found = FALSE;
+		while (valid) {
+			if (place_row_is_at_iter (sidebar, g_ptr_array_index (rows, i), &iter)) {
+				found = TRUE;
+				break;
+			}
+			for (j = i + 1; j < rows->len; j++) {
+				if (place_row_is_at_iter (sidebar, g_ptr_array_index (rows, j), &iter)) {
+					break;
+				}
+			}
+			if (j < rows->len) {
+				/* The row is wanted further down, so rows[i] is new. */
+				break;
+			}
+			valid = gtk_list_store_remove (sidebar->store, &iter);
+			changed = TRUE;
+		}
+
+		if (found) {
+			changed |= set_place_row (sidebar, g_ptr_array_index (rows, i), &iter, FALSE);
+			valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (sidebar->store), &iter);
+		} else {
+			gtk_list_store_insert_before (sidebar->store, &new_iter,
+						      valid ? &iter : NULL);
+			set_place_row (sidebar, g_ptr_array_index (rows, i), &new_iter, TRUE);
+			changed = TRUE;
+		}
+	}
 
-	if (pixbuf != NULL) {
-		g_object_unref (pixbuf);
+	while (valid) {
+		valid = gtk_list_store_remove (sidebar->store, &iter);
+		changed = TRUE;
 	}
-	gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (sidebar->filter_model));
-	gtk_tree_model_filter_convert_child_iter_to_iter (GTK_TREE_MODEL_FILTER (sidebar->filter_model),
-							  &child_iter,
-							  &iter);
-	return child_iter;
+
+	return changed;
 }
 
 static void
@@ -425,13 +662,52 @@ compare_for_selection (NautilusPlacesSidebar *sidebar,
 	}
 }
 
+static void
+select_place (NautilusPlacesSidebar *sidebar,
+	      GtkTreeSelection *selection,
+	      const char *location,
+	      const char *last_uri)
+{
+	GtkTreeIter iter, filter_iter;
+	GtkTreePath *select_path;
+	PlaceType place_type;
+	gboolean valid;
+	char *uri;
+
+	select_path = NULL;
+
+	valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (sidebar->store), &iter);
+	while (valid) {
+		gtk_tree_model_get (GTK_TREE_MODEL (sidebar->store), &iter,
+				    PLACES_SIDEBAR_COLUMN_ROW_TYPE, &place_type,
+				    PLACES_SIDEBAR_COLUMN_URI, &uri,
+				    -1);
+		if (place_type != PLACES_HEADING && uri != NULL) {
+			gtk_tree_model_filter_convert_child_iter_to_iter (GTK_TREE_MODEL_FILTER (sidebar->filter_model),
+									  &filter_iter,
+									  &iter);
+			compare_for_selection (sidebar,
+					       location, uri, last_uri,
+					       &filter_iter, &select_path);
+		}
+		g_free (uri);
+		valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (sidebar->store), &iter);
+	}
+
+	if (select_path != NULL) {
+		gtk_tree_selection_select_path (selection, select_path);
+		gtk_tree_path_free (select_path);
+	} else {
+		gtk_tree_selection_unselect_all (selection);
+	}
+}
+
 static void
 update_places (NautilusPlacesSidebar *sidebar)
 {
 	NautilusBookmark *bookmark;
 	GtkTreeSelection *selection;
 	GtkTreeIter last_iter;
-	GtkTreePath *select_path;
 	GtkTreeModel *model;
 	GVolumeMonitor *volume_monitor;
 	GList *mounts, *l, *ll;
@@ -449,10 +725,15 @@ update_places (NautilusPlacesSidebar *sidebar)
 	char *tooltip;
 	GList *network_mounts;
 	NautilusFile *file;
+	GPtrArray *rows;
+
+	if (sidebar->update_places_idle_id != 0) {
+		g_source_remove (sidebar->update_places_idle_id);
+		sidebar->update_places_idle_id = 0;
+	}
 
 	model = NULL;
 	last_uri = NULL;
-	select_path = NULL;
 
 	selection = gtk_tree_view_get_selection (sidebar->tree_view);
 	if (gtk_tree_selection_get_selected (selection, &model, &last_iter)) {
@@ -460,8 +741,8 @@ update_places (NautilusPlacesSidebar *sidebar)
 				    &last_iter,
 				    PLACES_SIDEBAR_COLUMN_URI, &last_uri, -1);
 	}
-	gtk_list_store_clear (sidebar->store);
 
+	rows = g_ptr_array_new_with_free_func ((GDestroyNotify) place_row_free);
 	sidebar->devices_header_added = FALSE;
 	sidebar->bookmarks_header_added = FALSE;
 
@@ -489,13 +770,10 @@ update_places (NautilusPlacesSidebar *sidebar)
 					name = g_mount_get_name (mount);
 					tooltip = g_file_get_parse_name (root);
 
-					last_iter = add_place (sidebar, PLACES_MOUNTED_VOLUME,
-							       SECTION_DEVICES,
-							       name, icon, mount_uri,
-							       drive, volume, mount, 0, tooltip);
-					compare_for_selection (sidebar,
-							       location, mount_uri, last_uri,
-							       &last_iter, &select_path);
+					add_place (sidebar, rows, PLACES_MOUNTED_VOLUME,
+						   SECTION_DEVICES,
+						   name, icon, mount_uri,
+						   drive, volume, mount, 0, tooltip);
 					g_object_unref (root);
 					g_object_unref (mount);
 					g_object_unref (icon);
@@ -515,10 +793,10 @@ update_places (NautilusPlacesSidebar *sidebar)
 					name = g_volume_get_name (volume);
 					tooltip = g_strdup_printf (_("Mount and open %s"), name);
 
-					last_iter = add_place (sidebar, PLACES_MOUNTED_VOLUME,
-							       SECTION_DEVICES,
-							       name, icon, NULL,
-							       drive, volume, NULL, 0, tooltip);
+					add_place (sidebar, rows, PLACES_MOUNTED_VOLUME,
+						   SECTION_DEVICES,
+						   name, icon, NULL,
+						   drive, volume, NULL, 0, tooltip);
 					g_object_unref (icon);
 					g_free (name);
 					g_free (tooltip);
@@ -540,10 +818,10 @@ update_places (NautilusPlacesSidebar *sidebar)
 				name = g_drive_get_name (drive);
 				tooltip = g_strdup_printf (_("Mount and open %s"), name);
 
-				last_iter = add_place (sidebar, PLACES_BUILT_IN,
-						       SECTION_DEVICES,
-						       name, icon, NULL,
-						       drive, NULL, NULL, 0, tooltip);
+				add_place (sidebar, rows, PLACES_BUILT_IN,
+					   SECTION_DEVICES,
+					   name, icon, NULL,
+					   drive, NULL, NULL, 0, tooltip);
 				g_object_unref (icon);
 				g_free (tooltip);
 				g_free (name);
@@ -571,13 +849,10 @@ update_places (NautilusPlacesSidebar *sidebar)
 			tooltip = g_file_get_parse_name (root);
 			g_object_unref (root);
 			name = g_mount_get_name (mount);
-			last_iter = add_place (sidebar, PLACES_MOUNTED_VOLUME,
-					       SECTION_DEVICES,
-					       name, icon, mount_uri,
-					       NULL, volume, mount, 0, tooltip);
-			compare_for_selection (sidebar,
-					       location, mount_uri, last_uri,
-					       &last_iter, &select_path);
+			add_place (sidebar, rows, PLACES_MOUNTED_VOLUME,
+				   SECTION_DEVICES,
+				   name, icon, mount_uri,
+				   NULL, volume, mount, 0, tooltip);
 			g_object_unref (mount);
 			g_object_unref (icon);
 			g_free (name);
@@ -587,10 +862,10 @@ update_places (NautilusPlacesSidebar *sidebar)
 			/* see comment above in why we add an icon for an unmounted mountable volume */
 			icon = g_volume_get_icon (volume);
 			name = g_volume_get_name (volume);
-			last_iter = add_place (sidebar, PLACES_MOUNTED_VOLUME,
-					       SECTION_DEVICES,
-					       name, icon, NULL,
-					       NULL, volume, NULL, 0, name);
+			add_place (sidebar, rows, PLACES_MOUNTED_VOLUME,
+				   SECTION_DEVICES,
+				   name, icon, NULL,
+				   NULL, volume, NULL, 0, name);
 			g_object_unref (icon);
 			g_free (name);
 		}
@@ -623,14 +898,11 @@ update_places (NautilusPlacesSidebar *sidebar)
 		mount_uri = nautilus_bookmark_get_uri (bookmark);
 		tooltip = g_file_get_parse_name (root);
 
-		last_iter = add_place (sidebar, PLACES_BOOKMARK,
-				       SECTION_BOOKMARKS,
-				       bookmark_name, icon, mount_uri,
-				       NULL, NULL, NULL, index,
-				       tooltip);
-		compare_for_selection (sidebar,
-				       location, mount_uri, last_uri,
-				       &last_iter, &select_path);
+		add_place (sidebar, rows, PLACES_BOOKMARK,
+			   SECTION_BOOKMARKS,
+			   bookmark_name, icon, mount_uri,
+			   NULL, NULL, NULL, index,
+			   tooltip);
 
 		g_object_unref (root);
 		g_object_unref (icon);
@@ -638,23 +910,20 @@ update_places (NautilusPlacesSidebar *sidebar)
 		g_free (tooltip);
 	}
 
-	last_iter = add_heading (sidebar, SECTION_COMPUTER,
-			       _("Computer"));
+	add_heading (sidebar, rows, SECTION_COMPUTER,
+		     _("Computer"));
 
 	/* add built in bookmarks */
 
 	/* home folder */
 	mount_uri = nautilus_get_home_directory_uri ();
 	icon = g_themed_icon_new (NAUTILUS_ICON_HOME);
-	last_iter = add_place (sidebar, PLACES_BUILT_IN,
-			       SECTION_COMPUTER,
-			       _("Home"), icon,
-			       mount_uri, NULL, NULL, NULL, 0,
-			       _("Open your personal folder"));
+	add_place (sidebar, rows, PLACES_BUILT_IN,
+		   SECTION_COMPUTER,
+		   _("Home"), icon,
+		   mount_uri, NULL, NULL, NULL, 0,
+		   _("Open your personal folder"));
 	g_object_unref (icon);
-	compare_for_selection (sidebar,
-			       location, mount_uri, last_uri,
-			       &last_iter, &select_path);
 	g_free (mount_uri);
 
 	if (g_settings_get_boolean (gnome_background_preferences, NAUTILUS_PREFERENCES_SHOW_DESKTOP) &&
@@ -663,15 +932,12 @@ update_places (NautilusPlacesSidebar *sidebar)
 		desktop_path = nautilus_get_desktop_directory ();
 		mount_uri = g_filename_to_uri (desktop_path, NULL, NULL);
 		icon = g_themed_icon_new (NAUTILUS_ICON_DESKTOP);
-		last_iter = add_place (sidebar, PLACES_BUILT_IN,
-				       SECTION_COMPUTER,
-				       _("Desktop"), icon,
-				       mount_uri, NULL, NULL, NULL, 0,
-				       _("Open the contents of your desktop in a folder"));
+		add_place (sidebar, rows, PLACES_BUILT_IN,
+			   SECTION_COMPUTER,
+			   _("Desktop"), icon,
+			   mount_uri, NULL, NULL, NULL, 0,
+			   _("Open the contents of your desktop in a folder"));
 		g_object_unref (icon);
-		compare_for_selection (sidebar,
-				       location, mount_uri, last_uri,
-				       &last_iter, &select_path);
 		g_free (mount_uri);
 		g_free (desktop_path);
 	}
@@ -679,15 +945,12 @@ update_places (NautilusPlacesSidebar *sidebar)
 	/* file system root */
  	mount_uri = "file:///"; /* No need to strdup */
 	icon = g_themed_icon_new (NAUTILUS_ICON_FILESYSTEM);
-	last_iter = add_place (sidebar, PLACES_BUILT_IN,
-			       SECTION_COMPUTER,
-			       _("File System"), icon,
-			       mount_uri, NULL, NULL, NULL, 0,
-			       _("Open the contents of the File System"));
+	add_place (sidebar, rows, PLACES_BUILT_IN,
+		   SECTION_COMPUTER,
+		   _("File System"), icon,
+		   mount_uri, NULL, NULL, NULL, 0,
+		   _("Open the contents of the File System"));
 	g_object_unref (icon);
-	compare_for_selection (sidebar,
-			       location, mount_uri, last_uri,
-			       &last_iter, &select_path);
 
 	
 	/* XDG directories */
@@ -715,14 +978,11 @@ update_places (NautilusPlacesSidebar *sidebar)
 		mount_uri = g_file_get_uri (root);
 		tooltip = g_file_get_parse_name (root);
 
-		last_iter = add_place (sidebar, PLACES_BUILT_IN,
-				       SECTION_COMPUTER,
-				       name, icon, mount_uri,
-				       NULL, NULL, NULL, 0,
-				       tooltip);
-		compare_for_selection (sidebar,
-				       location, mount_uri, last_uri,
-				       &last_iter, &select_path);
+		add_place (sidebar, rows, PLACES_BUILT_IN,
+			   SECTION_COMPUTER,
+			   name, icon, mount_uri,
+			   NULL, NULL, NULL, 0,
+			   tooltip);
 		g_free (name);
 		g_object_unref (root);
 		g_object_unref (icon);
@@ -757,13 +1017,10 @@ update_places (NautilusPlacesSidebar *sidebar)
 		mount_uri = g_file_get_uri (root);
 		name = g_mount_get_name (mount);
 		tooltip = g_file_get_parse_name (root);
-		last_iter = add_place (sidebar, PLACES_MOUNTED_VOLUME,
-				       SECTION_COMPUTER,
-				       name, icon, mount_uri,
-				       NULL, NULL, mount, 0, tooltip);
-		compare_for_selection (sidebar,
-				       location, mount_uri, last_uri,
-				       &last_iter, &select_path);
+		add_place (sidebar, rows, PLACES_MOUNTED_VOLUME,
+			   SECTION_COMPUTER,
+			   name, icon, mount_uri,
+			   NULL, NULL, mount, 0, tooltip);
 		g_object_unref (root);
 		g_object_unref (mount);
 		g_object_unref (icon);
@@ -775,19 +1032,16 @@ update_places (NautilusPlacesSidebar *sidebar)
 
 	mount_uri = "trash:///"; /* No need to strdup */
 	icon = nautilus_trash_monitor_get_icon ();
-	last_iter = add_place (sidebar, PLACES_BUILT_IN,
-			       SECTION_COMPUTER,
-			       _("Trash"), icon, mount_uri,
-			       NULL, NULL, NULL, 0,
-			       _("Open the trash"));
-	compare_for_selection (sidebar,
-			       location, mount_uri, last_uri,
-			       &last_iter, &select_path);
+	add_place (sidebar, rows, PLACES_BUILT_IN,
+		   SECTION_COMPUTER,
+		   _("Trash"), icon, mount_uri,
+		   NULL, NULL, NULL, 0,
+		   _("Open the trash"));
 	g_object_unref (icon);
 
 	/* network */
-	last_iter = add_heading (sidebar, SECTION_NETWORK,
-				 _("Network"));
+	add_heading (sidebar, rows, SECTION_NETWORK,
+		     _("Network"));
 
 	network_mounts = g_list_reverse (network_mounts);
 	for (l = network_mounts; l != NULL; l = l->next) {
@@ -797,13 +1051,10 @@ update_places (NautilusPlacesSidebar *sidebar)
 		mount_uri = g_file_get_uri (root);
 		name = g_mount_get_name (mount);
 		tooltip = g_file_get_parse_name (root);
-		last_iter = add_place (sidebar, PLACES_MOUNTED_VOLUME,
-				       SECTION_NETWORK,
-				       name, icon, mount_uri,
-				       NULL, NULL, mount, 0, tooltip);
-		compare_for_selection (sidebar,
-				       location, mount_uri, last_uri,
-				       &last_iter, &select_path);
+		add_place (sidebar, rows, PLACES_MOUNTED_VOLUME,
+			   SECTION_NETWORK,
+			   name, icon, mount_uri,
+			   NULL, NULL, mount, 0, tooltip);
 		g_object_unref (root);
 		g_object_unref (mount);
 		g_object_unref (icon);
@@ -817,35 +1068,55 @@ update_places (NautilusPlacesSidebar *sidebar)
 	/* network:// */
  	mount_uri = "network:///"; /* No need to strdup */
 	icon = g_themed_icon_new (NAUTILUS_ICON_NETWORK);
-	last_iter = add_place (sidebar, PLACES_BUILT_IN,
-			       SECTION_NETWORK,
-			       _("Browse Network"), icon,
-			       mount_uri, NULL, NULL, NULL, 0,
-			       _("Browse the contents of the network"));
+	add_place (sidebar, rows, PLACES_BUILT_IN,
+		   SECTION_NETWORK,
+		   _("Browse Network"), icon,
+		   mount_uri, NULL, NULL, NULL, 0,
+		   _("Browse the contents of the network"));
 	g_object_unref (icon);
-	compare_for_selection (sidebar,
-			       location, mount_uri, last_uri,
-			       &last_iter, &select_path);
-	
-	g_free (location);
 
-	if (select_path != NULL) {
-		gtk_tree_selection_select_path (selection, select_path);
+	if (update_store (sidebar, rows)) {
+		gtk_tree_model_filter_refilter (GTK_TREE_MODEL_FILTER (sidebar->filter_model));
 	}
+	g_ptr_array_free (rows, TRUE);
 
-	if (select_path != NULL) {
-		gtk_tree_path_free (select_path);
-	}
+	select_place (sidebar, selection, location, last_uri);
 
+	g_free (location);
 	g_free (last_uri);
 }
 
+static gboolean
+update_places_idle_callback (gpointer data)
+{
+	NautilusPlacesSidebar *sidebar;
+
+	sidebar = NAUTILUS_PLACES_SIDEBAR (data);
+
+	sidebar->update_places_idle_id = 0;
+	update_places (sidebar);
+
+	return FALSE;
+}
+
+/* Volume monitor signals tend to come in bursts, for example when a
+ * lot of network shares get mounted, so only update once they stop.
+ */
+static void
+schedule_update_places (NautilusPlacesSidebar *sidebar)
+{
+	if (sidebar->update_places_idle_id == 0) {
+		sidebar->update_places_idle_id =
+			g_idle_add (update_places_idle_callback, sidebar);
+	}
+}
+
 static void
 mount_added_callback (GVolumeMonitor *volume_monitor,
 		      GMount *mount,
 		      NautilusPlacesSidebar *sidebar)
 {
-	update_places (sidebar);
+	schedule_update_places (sidebar);
 }
 
 static void
@@ -853,7 +1124,7 @@ mount_removed_callback (GVolumeMonitor *volume_monitor,
 			GMount *mount,
 			NautilusPlacesSidebar *sidebar)
 {
-	update_places (sidebar);
+	schedule_update_places (sidebar);
 }
 
 static void
@@ -861,7 +1132,7 @@ mount_changed_callback (GVolumeMonitor *volume_monitor,
 			GMount *mount,
 			NautilusPlacesSidebar *sidebar)
 {
-	update_places (sidebar);
+	schedule_update_places (sidebar);
 }
 
 static void
@@ -869,7 +1140,7 @@ volume_added_callback (GVolumeMonitor *volume_monitor,
 		       GVolume *volume,
 		       NautilusPlacesSidebar *sidebar)
 {
-	update_places (sidebar);
+	schedule_update_places (sidebar);
 }
 
 static void
@@ -877,7 +1148,7 @@ volume_removed_callback (GVolumeMonitor *volume_monitor,
 			 GVolume *volume,
 			 NautilusPlacesSidebar *sidebar)
 {
-	update_places (sidebar);
+	schedule_update_places (sidebar);
 }
 
 static void
@@ -885,7 +1156,7 @@ volume_changed_callback (GVolumeMonitor *volume_monitor,
 			 GVolume *volume,
 			 NautilusPlacesSidebar *sidebar)
 {
-	update_places (sidebar);
+	schedule_update_places (sidebar);
 }
 
 static void
@@ -893,7 +1164,7 @@ drive_disconnected_callback (GVolumeMonitor *volume_monitor,
 			     GDrive         *drive,
 			     NautilusPlacesSidebar *sidebar)
 {
-	update_places (sidebar);
+	schedule_update_places (sidebar);
 }
 
 static void
@@ -901,7 +1172,7 @@ drive_connected_callback (GVolumeMonitor *volume_monitor,
 			  GDrive         *drive,
 			  NautilusPlacesSidebar *sidebar)
 {
-	update_places (sidebar);
+	schedule_update_places (sidebar);
 }
 
 static void
@@ -909,7 +1180,7 @@ drive_changed_callback (GVolumeMonitor *volume_monitor,
 			GDrive         *drive,
 			NautilusPlacesSidebar *sidebar)
 {
-	update_places (sidebar);
+	schedule_update_places (sidebar);
 }
 
 static gboolean
@@ -3195,7 +3466,8 @@ nautilus_places_sidebar_init (NautilusPlacesSidebar *sidebar)
 					     G_TYPE_STRING,
 					     GDK_TYPE_PIXBUF,
 					     G_TYPE_INT,
-					     G_TYPE_STRING);
+					     G_TYPE_STRING,
+					     G_TYPE_ICON);
 
 	gtk_tree_view_set_tooltip_column (tree_view, PLACES_SIDEBAR_COLUMN_TOOLTIP);
 
@@ -3295,6 +3567,11 @@ nautilus_places_sidebar_dispose (GObject *object)
 		sidebar->bookmarks_changed_id = 0;
 	}
 
+	if (sidebar->update_places_idle_id != 0) {
+		g_source_remove (sidebar->update_places_idle_id);
+		sidebar->update_places_idle_id = 0;
+	}
+
 	g_clear_object (&sidebar->store);
 	g_clear_object (&sidebar->volume_monitor);
 	g_clear_object (&sidebar->bookmarks);
@@ -3380,6 +3657,8 @@ nautilus_places_sidebar_style_set (GtkWidget *widget,
 
 	sidebar = NAUTILUS_PLACES_SIDEBAR (widget);
 
+	/* The icons depend on the style, so don't keep any */
+	gtk_list_store_clear (sidebar->store);
 	update_places (sidebar);
 }
 
@@ -52,6 +52,7 @@
 #include <libnautilus-private/nautilus-entry.h>
 #include <libnautilus-private/nautilus-file-attributes.h>
 #include <libnautilus-private/nautilus-file-operations.h>
+#include <libnautilus-private/nautilus-filesystem-info.h>
 #include <libnautilus-private/nautilus-desktop-icon-file.h>
 #include <libnautilus-private/nautilus-global-preferences.h>
 #include <libnautilus-private/nautilus-link.h>
@@ -137,6 +138,11 @@ struct NautilusPropertiesWindowDetails {
  	
  	guint64 volume_capacity;
  	guint64 volume_free;
+	GtkWidget *volume_pie_canvas;
+	GtkLabel *volume_used_label;
+	GtkLabel *volume_free_label;
+	GtkLabel *volume_capacity_label;
+	GtkLabel *volume_fstype_label;
 	
 	GdkRGBA used_color;
 	GdkRGBA free_color;
@@ -2645,6 +2651,10 @@ paint_pie_chart (GtkWidget *widget,
 	width  = allocation.width;
   	height = allocation.height;
 	
+	/* Not known yet. */
+	if (window->details->volume_capacity == 0) {
+		return;
+	}
 		
 	free = (double)window->details->volume_free / (double)window->details->volume_capacity;
 	used =  1.0 - free;
@@ -2897,7 +2907,6 @@ _pie_style_shade (GdkRGBA *a,
 static GtkWidget* 
 create_pie_widget (NautilusPropertiesWindow *window)
 {
-	NautilusFile		*file;
 	GtkTable 		*table;
 	GtkStyleContext		*style;
 	GtkWidget 		*pie_canvas;
@@ -2907,21 +2916,6 @@ create_pie_widget (NautilusPropertiesWindow *window)
 	GtkWidget 		*free_label;
 	GtkWidget 		*capacity_label;
 	GtkWidget 		*fstype_label;
-	gchar			*capacity;
-	gchar 			*used;
-	gchar 			*free;
-	const char		*fs_type;
-	gchar			*uri;
-	GFile *location;
-	GFileInfo *info;
-	
-	capacity = g_format_size_for_display (window->details->volume_capacity);
-	free 	 = g_format_size_for_display (window->details->volume_free);
-	used 	 = g_format_size_for_display (window->details->volume_capacity - window->details->volume_free);	
-	
-	file = get_original_file (window);
-	
-	uri = nautilus_file_get_activation_uri (file);
 	
 	table = GTK_TABLE (gtk_table_new (4, 3, FALSE));
 
@@ -2949,34 +2943,21 @@ create_pie_widget (NautilusPropertiesWindow *window)
 
 	used_canvas = gtk_drawing_area_new ();
 	gtk_widget_set_size_request (used_canvas, 20, 20);
-	/* Translators: "used" refers to the capacity of the filesystem */
-	used_label = gtk_label_new (g_strconcat (used, " ", _("used"), NULL));
+	used_label = gtk_label_new (NULL);
 
 	free_canvas = gtk_drawing_area_new ();
 	gtk_widget_set_size_request (free_canvas,20,20);
-	/* Translators: "free" refers to the capacity of the filesystem */
-	free_label = gtk_label_new (g_strconcat (free, " ", _("free"), NULL));  
+	free_label = gtk_label_new (NULL);
 
-	capacity_label = gtk_label_new (g_strconcat (_("Total capacity:"), " ", capacity, NULL));
+	capacity_label = gtk_label_new (NULL);
 	fstype_label = gtk_label_new (NULL);
 
-	location = g_file_new_for_uri (uri);
-	info = g_file_query_filesystem_info (location, G_FILE_ATTRIBUTE_FILESYSTEM_TYPE,
-					     NULL, NULL);
-	if (info) {
-		fs_type = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_FILESYSTEM_TYPE);
-		if (fs_type != NULL) {
-			gtk_label_set_text (GTK_LABEL (fstype_label), g_strconcat (_("Filesystem type:"), " ", fs_type, NULL));
-		}
-		
-		g_object_unref (info);
-	}
-	g_object_unref (location);
-	
-	g_free (uri);
-	g_free (capacity);
-	g_free (used);
-	g_free (free);
+	/* Filled in by volume_usage_info_callback. */
+	window->details->volume_pie_canvas = pie_canvas;
+	window->details->volume_used_label = GTK_LABEL (used_label);
+	window->details->volume_free_label = GTK_LABEL (free_label);
+	window->details->volume_capacity_label = GTK_LABEL (capacity_label);
+	window->details->volume_fstype_label = GTK_LABEL (fstype_label);
 
 	gtk_table_attach (table, pie_canvas , 0, 1, 0, 4, GTK_FILL, 	GTK_SHRINK, 5, 5);
 		
@@ -2999,6 +2980,59 @@ create_pie_widget (NautilusPropertiesWindow *window)
 	return GTK_WIDGET (table);
 }
 
+static void
+volume_usage_info_callback (GFileInfo *info,
+			    gpointer callback_data)
+{
+	NautilusPropertiesWindow *window;
+	const char *fs_type;
+	char *capacity, *used, *free, *text;
+
+	window = NAUTILUS_PROPERTIES_WINDOW (callback_data);
+
+	/* The widgets are gone if the window was closed meanwhile. */
+	if (info == NULL || window->details->volume_pie_canvas == NULL) {
+		g_object_unref (window);
+		return;
+	}
+
+	window->details->volume_capacity = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
+	window->details->volume_free = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
+
+	capacity = g_format_size_for_display (window->details->volume_capacity);
+	free 	 = g_format_size_for_display (window->details->volume_free);
+	used 	 = g_format_size_for_display (window->details->volume_capacity - window->details->volume_free);	
+
+	/* Translators: "used" refers to the capacity of the filesystem */
+	text = g_strconcat (used, " ", _("used"), NULL);
+	gtk_label_set_text (window->details->volume_used_label, text);
+	g_free (text);
+
+	/* Translators: "free" refers to the capacity of the filesystem */
+	text = g_strconcat (free, " ", _("free"), NULL);
+	gtk_label_set_text (window->details->volume_free_label, text);
+	g_free (text);
+
+	text = g_strconcat (_("Total capacity:"), " ", capacity, NULL);
+	gtk_label_set_text (window->details->volume_capacity_label, text);
+	g_free (text);
+
+	fs_type = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_FILESYSTEM_TYPE);
+	if (fs_type != NULL) {
+		text = g_strconcat (_("Filesystem type:"), " ", fs_type, NULL);
+		gtk_label_set_text (window->details->volume_fstype_label, text);
+		g_free (text);
+	}
+
+	g_free (capacity);
+	g_free (used);
+	g_free (free);
+
+	gtk_widget_queue_draw (window->details->volume_pie_canvas);
+
+	g_object_unref (window);
+}
+
 static GtkWidget*
 create_volume_usage_widget (NautilusPropertiesWindow *window)
 {
@@ -3006,30 +3040,25 @@ create_volume_usage_widget (NautilusPropertiesWindow *window)
 	gchar *uri;
 	NautilusFile *file;
 	GFile *location;
-	GFileInfo *info;
 	
-	file = get_original_file (window);
-	
-	uri = nautilus_file_get_activation_uri (file);
-
-	location = g_file_new_for_uri (uri);
-	info = g_file_query_filesystem_info (location, "filesystem::*", NULL, NULL);
-
-	if (info) {
-		window->details->volume_capacity = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
-		window->details->volume_free = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
+	window->details->volume_capacity = 0;		
+	window->details->volume_free = 0;		
 
-		g_object_unref (info);
-	} else {
-		window->details->volume_capacity = 0;		
-		window->details->volume_free = 0;		
-	}
-	
-	g_object_unref (location);
-	
 	piewidget = create_pie_widget (window);
 	                   
         gtk_widget_show_all (piewidget);            
+
+	/* A slow or hung mount mustn't keep the window from opening,
+	 * so the numbers come in later.
+	 */
+	file = get_original_file (window);
+	uri = nautilus_file_get_activation_uri (file);
+	location = g_file_new_for_uri (uri);
+	nautilus_filesystem_info_query_async (location,
+					      volume_usage_info_callback,
+					      g_object_ref (window));
+	g_object_unref (location);
+	g_free (uri);
         
 	return piewidget;
 }
@@ -5221,6 +5250,12 @@ real_destroy (GtkWidget *object)
 	g_list_free (window->details->value_fields);
 	window->details->value_fields = NULL;
 
+	window->details->volume_pie_canvas = NULL;
+	window->details->volume_used_label = NULL;
+	window->details->volume_free_label = NULL;
+	window->details->volume_capacity_label = NULL;
+	window->details->volume_fstype_label = NULL;
+
 	if (window->details->update_directory_contents_timeout_id != 0) {
 		g_source_remove (window->details->update_directory_contents_timeout_id);
 		window->details->update_directory_contents_timeout_id = 0;
@@ -73,6 +73,7 @@ struct TreeNode {
 	TreeNode *parent;
 	TreeNode *next;
 	TreeNode *prev;
+	GSequenceIter *ptr; /* position in parent->children */
 
 	/* part of the node used only for directories */
 	int dummy_child_ref_count;
@@ -84,6 +85,10 @@ struct TreeNode {
 	guint files_changed_id;
 
 	TreeNode *first_child;
+	/* The children again, in the same order, so that a child's
+	 * index and the nth child can be found without walking the list.
+	 */
+	GSequence *children;
 
 	/* misc. flags */
 	guint done_loading : 1;
@@ -185,6 +190,10 @@ tree_node_unparent (FMTreeModel *model, TreeNode *node)
 	if (next != NULL) {
 		next->prev = prev;
 	}
+	if (parent != NULL) {
+		g_sequence_remove (node->ptr);
+		node->ptr = NULL;
+	}
 	if (prev == NULL && parent != NULL) {
 		g_assert (parent->first_child == node);
 		parent->first_child = next;
@@ -206,6 +215,11 @@ tree_node_destroy (FMTreeModel *model, TreeNode *node)
 
 	tree_node_unparent (model, node);
 
+	if (node->children != NULL) {
+		g_assert (g_sequence_get_length (node->children) == 0);
+		g_sequence_free (node->children);
+	}
+
 	g_object_unref (node->file);
 	g_free (node->display_name);
 	object_unref_if_not_NULL (node->icon);
@@ -242,6 +256,11 @@ tree_node_parent (TreeNode *node, TreeNode *parent)
 	}
 
 	parent->first_child = node;
+
+	if (parent->children == NULL) {
+		parent->children = g_sequence_new (NULL);
+	}
+	node->ptr = g_sequence_prepend (parent->children, node);
 }
 
 static GdkPixbuf *
@@ -321,7 +340,7 @@ get_menu_icon_for_file (TreeNode *node,
 	                                 file, (GCompareFunc) nautilus_file_compare_location) != NULL);
 
 	if (highlight) {
-		pixbuf = eel_create_spotlight_pixbuf (retval);
+		pixbuf = eel_get_spotlight_pixbuf (retval);
 
 		if (pixbuf != NULL) {
 			g_object_unref (retval);
@@ -440,22 +459,25 @@ static int
 tree_node_get_child_index (TreeNode *parent, TreeNode *child)
 {
 	int i;
-	TreeNode *node;
 
 	if (child == NULL) {
 		g_assert (tree_node_has_dummy_child (parent));
 		return 0;
 	}
 
+	g_assert (child->parent == parent);
+
 	i = tree_node_has_dummy_child (parent) ? 1 : 0;
-	for (node = parent->first_child; node != NULL; node = node->next, i++) {
-		if (child == node) {
-			return i;
-		}
-	}
+	return i + g_sequence_iter_get_position (child->ptr);
+}
 
-	g_assert_not_reached ();
-	return 0;
+static int
+tree_node_get_n_children (TreeNode *parent)
+{
+	if (parent->children == NULL) {
+		return 0;
+	}
+	return g_sequence_get_length (parent->children);
 }
 
 static gboolean
@@ -834,21 +856,29 @@ update_node_without_reporting (FMTreeModel *model, TreeNode *node)
 	return changed;
 }
 
+/* Insert a list of new nodes under one parent, taking care of the
+ * dummy row once for the whole list.
+ */
 static void
-insert_node (FMTreeModel *model, TreeNode *parent, TreeNode *node)
+insert_nodes (FMTreeModel *model, TreeNode *parent, GList *nodes)
 {
 	gboolean parent_empty;
+	GList *l;
+	TreeNode *node;
 
 	parent_empty = parent->first_child == NULL;
 	if (parent_empty) {
-		/* Make sure the dummy lives as we insert the new row */
+		/* Make sure the dummy lives as we insert the new rows */
 		parent->force_has_dummy = TRUE;
 	}
 
-	tree_node_parent (node, parent);
+	for (l = nodes; l != NULL; l = l->next) {
+		node = l->data;
+		tree_node_parent (node, parent);
 
-	update_node_without_reporting (model, node);
-	report_node_inserted (model, node);
+		update_node_without_reporting (model, node);
+		report_node_inserted (model, node);
+	}
 
 	if (parent_empty) {
 		parent->force_has_dummy = FALSE;
@@ -862,6 +892,14 @@ insert_node (FMTreeModel *model, TreeNode *parent, TreeNode *node)
 	}
 }
 
+static void
+insert_node (FMTreeModel *model, TreeNode *parent, TreeNode *node)
+{
+	GList nodes = { node, NULL, NULL };
+
+	insert_nodes (model, parent, &nodes);
+}
+
 static void
 reparent_node (FMTreeModel *model, TreeNode *node)
 {
@@ -985,19 +1023,60 @@ process_file_change (FMTreeModelRoot *root,
 	insert_node (root->model, parent, create_node_for_file (root, file));
 }
 
+static void
+flush_new_nodes (FMTreeModel *model, TreeNode *parent, GList **new_nodes)
+{
+	if (*new_nodes == NULL) {
+		return;
+	}
+
+	*new_nodes = g_list_reverse (*new_nodes);
+	insert_nodes (model, parent, *new_nodes);
+	g_list_free (*new_nodes);
+	*new_nodes = NULL;
+}
+
 static void
 files_changed_callback (NautilusDirectory *directory,
 			GList *changed_files,
 			gpointer callback_data)
 {
 	FMTreeModelRoot *root;
-	GList *node;
+	GList *node, *new_nodes;
+	TreeNode *parent, *new_parent;
+	NautilusFile *file;
 
 	root = (FMTreeModelRoot *) (callback_data);
 
+	/* A directory load hands us its files in big batches. Runs of
+	 * new files that share a parent are inserted together; anything
+	 * else first flushes the run, so updates see a consistent tree.
+	 */
+	parent = NULL;
+	new_nodes = NULL;
 	for (node = changed_files; node != NULL; node = node->next) {
-		process_file_change (root, NAUTILUS_FILE (node->data));
+		file = NAUTILUS_FILE (node->data);
+
+		new_parent = NULL;
+		if (get_node_from_file (root, file) == NULL &&
+		    should_show_file (root->model, file)) {
+			new_parent = get_parent_node_from_file (root, file);
+		}
+
+		if (new_parent == NULL || new_parent != parent) {
+			flush_new_nodes (root->model, parent, &new_nodes);
+		}
+
+		if (new_parent == NULL) {
+			process_file_change (root, file);
+			continue;
+		}
+
+		parent = new_parent;
+		new_nodes = g_list_prepend (new_nodes, create_node_for_file (root, file));
 	}
+
+	flush_new_nodes (root->model, parent, &new_nodes);
 }
 
 static void
@@ -1357,7 +1436,7 @@ fm_tree_model_iter_has_child (GtkTreeModel *model, GtkTreeIter *iter)
 static int
 fm_tree_model_iter_n_children (GtkTreeModel *model, GtkTreeIter *iter)
 {
-	TreeNode *parent, *node;
+	TreeNode *parent;
 	int n;
 	
 	g_return_val_if_fail (FM_IS_TREE_MODEL (model), FALSE);
@@ -1373,9 +1452,7 @@ fm_tree_model_iter_n_children (GtkTreeModel *model, GtkTreeIter *iter)
 	}
 
 	n = tree_node_has_dummy_child (parent) ? 1 : 0;
-	for (node = parent->first_child; node != NULL; node = node->next) {
-		n++;
-	}
+	n += tree_node_get_n_children (parent);
 
 	return n;
 }
@@ -1410,11 +1487,11 @@ fm_tree_model_iter_nth_child (GtkTreeModel *model, GtkTreeIter *iter,
 	if (n == 0 && i == 1) {
 		return make_iter_for_dummy_row (parent, iter, parent_iter->stamp);
 	}
-	for (node = parent->first_child; i != n; i++, node = node->next) {
-		if (node == NULL) {
-			return make_iter_invalid (iter);
-		}
+	n -= i;
+	if (n < 0 || n >= tree_node_get_n_children (parent)) {
+		return make_iter_invalid (iter);
 	}
+	node = g_sequence_get (g_sequence_get_iter_at_pos (parent->children, n));
 
 	return make_iter_for_node (node, iter, parent_iter->stamp);	
 }
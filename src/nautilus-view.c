@@ -76,6 +76,7 @@
 #include <libnautilus-private/nautilus-recent.h>
 #include <libnautilus-private/nautilus-module.h>
 #include <libnautilus-private/nautilus-program-choosing.h>
+#include <libnautilus-private/nautilus-trace.h>
 #include <libnautilus-private/nautilus-trash-monitor.h>
 #include <libnautilus-private/nautilus-ui-utilities.h>
 #include <libnautilus-private/nautilus-signaller.h>
@@ -792,6 +793,37 @@ nautilus_view_get_selection (NautilusView *view)
 		 get_selection, (view));
 }
 
+/**
+ * nautilus_view_is_file_selected:
+ *
+ * Check whether @file is one of the selected items, without building
+ * the selection list when the subclass can avoid it.
+ * @view: NautilusView whose selection is of interest.
+ * @file: The file to look for.
+ *
+ * Return value: TRUE if @file is selected in @view.
+ **/
+gboolean
+nautilus_view_is_file_selected (NautilusView *view,
+				NautilusFile *file)
+{
+	GList *selection;
+	gboolean selected;
+
+	g_return_val_if_fail (NAUTILUS_IS_VIEW (view), FALSE);
+	g_return_val_if_fail (NAUTILUS_IS_FILE (file), FALSE);
+
+	if (NAUTILUS_VIEW_CLASS (G_OBJECT_GET_CLASS (view))->is_file_selected != NULL) {
+		return NAUTILUS_VIEW_CLASS (G_OBJECT_GET_CLASS (view))->is_file_selected (view, file);
+	}
+
+	selection = nautilus_view_get_selection (view);
+	selected = g_list_find (selection, file) != NULL;
+	nautilus_file_list_free (selection);
+
+	return selected;
+}
+
 
 /**
  * nautilus_view_update_menus:
@@ -864,20 +896,6 @@ application_launch_parameters_free (ApplicationLaunchParameters *parameters)
 	g_free (parameters);
 }			      
 
-static GList *
-file_and_directory_list_to_files (GList *fad_list)
-{
-	GList *res, *l;
-	FileAndDirectory *fad;
-
-	res = NULL;
-	for (l = fad_list; l != NULL; l = l->next) {
-		fad = l->data;
-		res = g_list_prepend (res, nautilus_file_ref (fad->file));
-	}
-	return g_list_reverse (res);
-}
-
 
 static GList *
 file_and_directory_list_from_files (NautilusDirectory *directory, GList *files)
@@ -2457,10 +2475,15 @@ nautilus_view_grab_focus (NautilusView *view)
 int
 nautilus_view_get_selection_count (NautilusView *view)
 {
-	/* FIXME: This could be faster if we special cased it in subclasses */
 	GList *files;
 	int len;
 
+	g_return_val_if_fail (NAUTILUS_IS_VIEW (view), 0);
+
+	if (NAUTILUS_VIEW_CLASS (G_OBJECT_GET_CLASS (view))->get_selection_count != NULL) {
+		return NAUTILUS_VIEW_CLASS (G_OBJECT_GET_CLASS (view))->get_selection_count (view);
+	}
+
 	files = nautilus_view_get_selection (NAUTILUS_VIEW (view));
 	len = g_list_length (files);
 	nautilus_file_list_free (files);
@@ -3407,7 +3430,6 @@ process_old_files (NautilusView *view)
 {
 	GList *files_added, *files_changed, *node;
 	FileAndDirectory *pending;
-	GList *selection, *files;
 	gboolean send_selection_change;
 
 	files_added = view->details->old_added_files;
@@ -3435,12 +3457,16 @@ process_old_files (NautilusView *view)
 		g_signal_emit (view, signals[END_FILE_CHANGES], 0);
 
 		if (files_changed != NULL) {
-			selection = nautilus_view_get_selection (view);
-			files = file_and_directory_list_to_files (files_changed);
-			send_selection_change = eel_g_lists_sort_and_check_for_intersection
-				(&files, &selection);
-			nautilus_file_list_free (files);
-			nautilus_file_list_free (selection);
+			/* Only look up the changed files, the selection
+			 * itself may be huge.
+			 */
+			for (node = files_changed; node != NULL; node = node->next) {
+				pending = node->data;
+				if (nautilus_view_is_file_selected (view, pending->file)) {
+					send_selection_change = TRUE;
+					break;
+				}
+			}
 		}
 		
 		file_and_directory_list_free (view->details->old_added_files);
@@ -3461,15 +3487,21 @@ process_old_files (NautilusView *view)
 static void
 display_pending_files (NautilusView *view)
 {
+	gint64 trace_start;
 
 	/* Don't dispatch any updates while the view is frozen. */
 	if (view->details->updates_frozen) {
 		return;
 	}
 
+	NAUTILUS_TRACE_BEGIN (trace_start);
+
 	process_new_files (view);
 	process_old_files (view);
 
+	NAUTILUS_TRACE_END ("view", "display pending files", trace_start,
+			    G_OBJECT_TYPE_NAME (view));
+
 	if (view->details->model != NULL
 	    && nautilus_directory_are_all_files_seen (view->details->model)
 	    && g_hash_table_size (view->details->non_ready_files) == 0) {
@@ -165,6 +165,15 @@ struct NautilusViewClass {
 	 * in the selection is not included.
 	 */
 	GList *	(* get_selection_for_file_transfer)(NautilusView *view);
+
+	/* get_selection_count and is_file_selected are function pointers
+	 * that subclasses may override to answer without building the
+	 * whole selection list, which matters for very large selections.
+	 * The default implementations use get_selection.
+	 */
+	int      (* get_selection_count)	(NautilusView *view);
+	gboolean (* is_file_selected)		(NautilusView *view,
+						 NautilusFile *file);
 	
         /* select_all is a function pointer that subclasses must override to
          * select all of the items in the view */
@@ -382,6 +391,8 @@ void              nautilus_view_new_file_with_initial_contents (NautilusView *vi
 /* selection handling */
 int               nautilus_view_get_selection_count        (NautilusView      *view);
 GList *           nautilus_view_get_selection              (NautilusView      *view);
+gboolean          nautilus_view_is_file_selected           (NautilusView      *view,
+							    NautilusFile      *file);
 void              nautilus_view_set_selection              (NautilusView      *view,
 							    GList             *selection);
 
@@ -0,0 +1,335 @@
+#include "bench.h"
+
+#include <gtk/gtk.h>
+#include <stdlib.h>
+#include <libnautilus-private/nautilus-directory.h>
+#include <libnautilus-private/nautilus-file.h>
+#include <libnautilus-private/nautilus-file-attributes.h>
+#include <libnautilus-private/nautilus-query.h>
+#include <libnautilus-private/nautilus-search-engine-simple.h>
+
+/* Times loading, sorting, deep counting and searching a folder of
+ * generated files, for each of the given sizes.
+ */
+
+static const char *sort_attributes[] = {
+	"name", "size", "type", "date_modified", "owner", "permissions"
+};
+
+/* The old way of sorting compares with formatted strings each time,
+ * which gets too slow to wait for above this.
+ */
+#define MAX_FILES_FOR_LIST_SORT 100000
+
+static char *sizes_option = NULL;
+static char *base_dir_option = NULL;
+static char *search_text_option = NULL;
+static gboolean keep_option = FALSE;
+
+static GOptionEntry options[] = {
+	{ "sizes", 's', 0, G_OPTION_ARG_STRING, &sizes_option,
+	  "Comma separated numbers of files to try (default 10000,100000)", "N,..." },
+	{ "dir", 'd', 0, G_OPTION_ARG_FILENAME, &base_dir_option,
+	  "Make the test folders in DIR (default the temporary directory)", "DIR" },
+	{ "search", 0, 0, G_OPTION_ARG_STRING, &search_text_option,
+	  "Text to search for (default \"7-\")", "TEXT" },
+	{ "keep", 'k', 0, G_OPTION_ARG_NONE, &keep_option,
+	  "Don't remove the test folders", NULL },
+	{ NULL }
+};
+
+typedef struct {
+	gint64 start;
+	double first_files_ms;
+	int n_added;
+	gboolean done;
+} LoadState;
+
+static void
+files_added (NautilusDirectory *directory,
+	     GList *added_files,
+	     LoadState *state)
+{
+	if (state->n_added == 0) {
+		state->first_files_ms = bench_elapsed_ms (state->start);
+	}
+	state->n_added += g_list_length (added_files);
+}
+
+static void
+done_loading (NautilusDirectory *directory,
+	      LoadState *state)
+{
+	state->done = TRUE;
+}
+
+static void
+bench_load (NautilusDirectory *directory,
+	    int n_files,
+	    LoadState *state)
+{
+	double ms;
+
+	state->start = bench_now ();
+	g_signal_connect (directory, "files_added",
+			  G_CALLBACK (files_added), state);
+	g_signal_connect (directory, "done_loading",
+			  G_CALLBACK (done_loading), state);
+
+	nautilus_directory_file_monitor_add (directory, state, TRUE,
+					     NAUTILUS_FILE_ATTRIBUTE_INFO,
+					     NULL, NULL);
+	bench_wait_for (&state->done);
+	ms = bench_elapsed_ms (state->start);
+
+	bench_report ("load", "first_files_added", n_files, state->first_files_ms, "ms");
+	bench_report ("load", "done_loading", n_files, ms, "ms");
+	bench_report ("load", "files_per_second", n_files, state->n_added / (ms / 1000.0), "files/s");
+}
+
+static int
+compare_files (gconstpointer a,
+	       gconstpointer b,
+	       gpointer attribute)
+{
+	return nautilus_file_compare_for_sort_by_attribute_q ((NautilusFile *) a,
+							      (NautilusFile *) b,
+							      GPOINTER_TO_UINT (attribute),
+							      TRUE, FALSE);
+}
+
+static void
+bench_sort (NautilusDirectory *directory,
+	    int n_files)
+{
+	GList *file_list, *copy, *l;
+	NautilusFile **files;
+	int *order;
+	int n, i, j;
+	GQuark attribute;
+	char *metric;
+	gint64 start;
+
+	file_list = nautilus_directory_get_file_list (directory);
+	n = g_list_length (file_list);
+	files = g_new (NautilusFile *, n);
+	order = g_new (int, n);
+	for (l = file_list, i = 0; l != NULL; l = l->next, i++) {
+		files[i] = l->data;
+	}
+
+	for (j = 0; j < G_N_ELEMENTS (sort_attributes); j++) {
+		attribute = g_quark_from_static_string (sort_attributes[j]);
+
+		/* What the list view does when the sort column changes */
+		start = bench_now ();
+		nautilus_file_sort_by_attribute_q (files, n, attribute, TRUE, FALSE, order);
+		metric = g_strdup_printf ("sort_keys_%s", sort_attributes[j]);
+		bench_report ("sort", metric, n_files, bench_elapsed_ms (start), "ms");
+		g_free (metric);
+
+		if (n > MAX_FILES_FOR_LIST_SORT) {
+			continue;
+		}
+
+		copy = g_list_copy (file_list);
+		start = bench_now ();
+		copy = g_list_sort_with_data (copy, compare_files, GUINT_TO_POINTER (attribute));
+		metric = g_strdup_printf ("sort_compare_%s", sort_attributes[j]);
+		bench_report ("sort", metric, n_files, bench_elapsed_ms (start), "ms");
+		g_free (metric);
+		g_list_free (copy);
+	}
+
+	g_free (order);
+	g_free (files);
+	nautilus_file_list_free (file_list);
+}
+
+static void
+deep_counts_ready (NautilusFile *file,
+		   gpointer callback_data)
+{
+	*(gboolean *) callback_data = TRUE;
+}
+
+static void
+bench_deep_count (GFile *location,
+		  int n_files)
+{
+	NautilusFile *file;
+	gboolean done;
+	guint directory_count, file_count, unreadable_count;
+	goffset total_size;
+	gint64 start;
+
+	file = nautilus_file_get (location);
+
+	done = FALSE;
+	start = bench_now ();
+	nautilus_file_call_when_ready (file, NAUTILUS_FILE_ATTRIBUTE_DEEP_COUNTS,
+				       deep_counts_ready, &done);
+	bench_wait_for (&done);
+	bench_report ("deep_count", "done", n_files, bench_elapsed_ms (start), "ms");
+
+	nautilus_file_get_deep_counts (file, &directory_count, &file_count,
+				       &unreadable_count, &total_size, FALSE);
+	if (directory_count + file_count == 0) {
+		g_printerr ("Deep count found nothing in a folder of %d files\n", n_files);
+	}
+
+	nautilus_file_unref (file);
+}
+
+typedef struct {
+	gint64 start;
+	double first_hit_ms;
+	int n_hits;
+	gboolean done;
+} SearchState;
+
+static void
+hits_added (NautilusSearchEngine *engine,
+	    GList *hits,
+	    SearchState *state)
+{
+	if (state->n_hits == 0) {
+		state->first_hit_ms = bench_elapsed_ms (state->start);
+	}
+	state->n_hits += g_list_length (hits);
+}
+
+static void
+search_finished (NautilusSearchEngine *engine,
+		 SearchState *state)
+{
+	state->done = TRUE;
+}
+
+static void
+search_error (NautilusSearchEngine *engine,
+	      const char *error_message,
+	      SearchState *state)
+{
+	g_printerr ("Search failed: %s\n", error_message);
+	state->done = TRUE;
+}
+
+static void
+bench_search (GFile *location,
+	      int n_files)
+{
+	NautilusSearchEngine *engine;
+	NautilusQuery *query;
+	SearchState state = { 0 };
+	char *uri;
+
+	engine = nautilus_search_engine_simple_new ();
+	g_signal_connect (engine, "hits-added",
+			  G_CALLBACK (hits_added), &state);
+	g_signal_connect (engine, "finished",
+			  G_CALLBACK (search_finished), &state);
+	g_signal_connect (engine, "error",
+			  G_CALLBACK (search_error), &state);
+
+	query = nautilus_query_new ();
+	uri = g_file_get_uri (location);
+	nautilus_query_set_location (query, uri);
+	nautilus_query_set_text (query, search_text_option != NULL ? search_text_option : "7-");
+	g_free (uri);
+	nautilus_search_engine_set_query (engine, query);
+
+	state.start = bench_now ();
+	nautilus_search_engine_start (engine);
+	bench_wait_for (&state.done);
+
+	bench_report ("search", "first_hit", n_files, state.first_hit_ms, "ms");
+	bench_report ("search", "finished", n_files, bench_elapsed_ms (state.start), "ms");
+
+	g_object_unref (query);
+	g_object_unref (engine);
+}
+
+static void
+bench_folder (int n_files)
+{
+	BenchTreeSpec spec = { 0 };
+	NautilusDirectory *directory;
+	LoadState load_state = { 0 };
+	GFile *location;
+	char *path;
+	gint64 start;
+
+	path = bench_make_temp_dir (base_dir_option);
+	if (path == NULL) {
+		exit (1);
+	}
+
+	spec.n_files = n_files;
+	spec.file_size = 4096;
+	spec.hardlink_percent = 2;
+	spec.subdir_percent = 5;
+
+	start = bench_now ();
+	if (bench_make_tree (path, &spec, NULL) < 0) {
+		bench_remove_tree (path);
+		exit (1);
+	}
+	g_printerr ("Made %d files in %s in %.0f ms\n", n_files, path, bench_elapsed_ms (start));
+
+	location = g_file_new_for_path (path);
+	directory = nautilus_directory_get (location);
+
+	bench_load (directory, n_files, &load_state);
+	bench_sort (directory, n_files);
+	bench_deep_count (location, n_files);
+	bench_search (location, n_files);
+
+	nautilus_directory_file_monitor_remove (directory, &load_state);
+	g_signal_handlers_disconnect_matched (directory, G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, &load_state);
+	nautilus_directory_unref (directory);
+	g_object_unref (location);
+
+	if (keep_option) {
+		g_printerr ("Kept %s\n", path);
+	} else {
+		bench_remove_tree (path);
+	}
+	g_free (path);
+}
+
+int
+main (int argc, char *argv[])
+{
+	GOptionContext *context;
+	GError *error;
+	char **sizes;
+	int i, n_files;
+
+	g_thread_init (NULL);
+
+	context = g_option_context_new ("- time loading, sorting and searching folders");
+	g_option_context_add_main_entries (context, options, NULL);
+	error = NULL;
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		return 1;
+	}
+	g_option_context_free (context);
+
+	/* Nothing is shown, so this runs without a display as well. */
+	gtk_init_check (&argc, &argv);
+
+	sizes = g_strsplit (sizes_option != NULL ? sizes_option : "10000,100000", ",", -1);
+	for (i = 0; sizes[i] != NULL; i++) {
+		n_files = atoi (sizes[i]);
+		if (n_files > 0) {
+			bench_folder (n_files);
+		}
+	}
+	g_strfreev (sizes);
+
+	return 0;
+}
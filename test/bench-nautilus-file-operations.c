@@ -0,0 +1,319 @@
+#include "bench.h"
+
+#include <gtk/gtk.h>
+#include <stdlib.h>
+#include <string.h>
+#include <libnautilus-private/nautilus-file-operations.h>
+#include <libnautilus-private/nautilus-global-preferences.h>
+#include <libnautilus-private/nautilus-progress-info.h>
+#include <libnautilus-private/nautilus-progress-info-manager.h>
+
+/* Times the file operations on generated trees of many small files,
+ * a few large files and deeply nested folders.
+ *
+ * Everything happens below --dir, so pointing that at a tmpfs, a disk
+ * or a GVfs FUSE mount (~/.gvfs) compares those.
+ */
+
+static char *base_dir_option = NULL;
+static int small_files_option = 10000;
+static int large_file_mb_option = 64;
+static gboolean trash_option = FALSE;
+
+static GOptionEntry options[] = {
+	{ "dir", 'd', 0, G_OPTION_ARG_FILENAME, &base_dir_option,
+	  "Make the test folders in DIR (default the temporary directory)", "DIR" },
+	{ "small-files", 0, 0, G_OPTION_ARG_INT, &small_files_option,
+	  "Number of files in the tree of small files (default 10000)", "N" },
+	{ "large-file-mb", 0, 0, G_OPTION_ARG_INT, &large_file_mb_option,
+	  "Largest size of the large files (default 64)", "MB" },
+	{ "trash", 't', 0, G_OPTION_ARG_NONE, &trash_option,
+	  "Also time trashing; the files are left in the trash of DIR", NULL },
+	{ NULL }
+};
+
+typedef struct {
+	const char *operation;
+	const char *tree;
+	int n_files;
+	goffset total_size;
+
+	gint64 start;
+	double scan_ms; /* -1 while nothing is known about progress */
+	int n_updates;
+	gint64 update_time;
+
+	gboolean done;
+	gboolean finished;
+} OperationRun;
+
+/* The run the next job belongs to; jobs are started one at a time. */
+static OperationRun *current_run;
+
+static void
+progress_changed_cb (NautilusProgressInfo *info,
+		     OperationRun *run)
+{
+	gint64 start;
+	double progress;
+
+	start = bench_now ();
+
+	/* What the progress window does on every update */
+	progress = nautilus_progress_info_get_progress (info);
+	if (run->scan_ms < 0 && progress >= 0) {
+		run->scan_ms = bench_elapsed_ms (run->start);
+	}
+
+	run->n_updates++;
+	run->update_time += bench_now () - start;
+}
+
+static void
+changed_cb (NautilusProgressInfo *info,
+	    OperationRun *run)
+{
+	gint64 start;
+
+	start = bench_now ();
+
+	g_free (nautilus_progress_info_get_status (info));
+	g_free (nautilus_progress_info_get_details (info));
+
+	run->n_updates++;
+	run->update_time += bench_now () - start;
+}
+
+static void
+finished_cb (NautilusProgressInfo *info,
+	     OperationRun *run)
+{
+	g_signal_handlers_disconnect_matched (info, G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, run);
+	run->finished = TRUE;
+}
+
+static void
+new_progress_info_cb (NautilusProgressInfoManager *manager,
+		      NautilusProgressInfo *info,
+		      gpointer user_data)
+{
+	g_assert (current_run != NULL);
+
+	g_signal_connect (info, "changed",
+			  G_CALLBACK (changed_cb), current_run);
+	g_signal_connect (info, "progress-changed",
+			  G_CALLBACK (progress_changed_cb), current_run);
+	g_signal_connect (info, "finished",
+			  G_CALLBACK (finished_cb), current_run);
+}
+
+static void
+copy_done (GHashTable *debuting_uris,
+	   gpointer callback_data)
+{
+	((OperationRun *) callback_data)->done = TRUE;
+}
+
+static void
+delete_done (GHashTable *debuting_uris,
+	     gboolean user_cancel,
+	     gpointer callback_data)
+{
+	((OperationRun *) callback_data)->done = TRUE;
+}
+
+static void
+op_done (gpointer callback_data)
+{
+	((OperationRun *) callback_data)->done = TRUE;
+}
+
+static void
+run_start (OperationRun *run,
+	   const char *operation,
+	   const char *tree,
+	   int n_files,
+	   goffset total_size)
+{
+	memset (run, 0, sizeof (OperationRun));
+	run->operation = operation;
+	run->tree = tree;
+	run->n_files = n_files;
+	run->total_size = total_size;
+	run->scan_ms = -1;
+
+	current_run = run;
+	run->start = bench_now ();
+}
+
+static void
+run_finish (OperationRun *run)
+{
+	char *benchmark;
+	double ms;
+
+	while (!run->done || !run->finished) {
+		g_main_context_iteration (NULL, TRUE);
+	}
+	ms = bench_elapsed_ms (run->start);
+	current_run = NULL;
+
+	benchmark = g_strdup_printf ("%s_%s", run->operation, run->tree);
+	bench_report (benchmark, "total", run->n_files, ms, "ms");
+	bench_report (benchmark, "files_per_second", run->n_files,
+		      run->n_files / (ms / 1000.0), "files/s");
+	if (run->total_size > 0) {
+		bench_report (benchmark, "mb_per_second", run->n_files,
+			      run->total_size / (1024.0 * 1024.0) / (ms / 1000.0), "MB/s");
+	}
+	if (run->scan_ms >= 0) {
+		bench_report (benchmark, "scan", run->n_files, run->scan_ms, "ms");
+	}
+	bench_report (benchmark, "progress_updates", run->n_files, run->n_updates, "updates");
+	bench_report (benchmark, "progress_overhead", run->n_files,
+		      run->update_time / 1000.0, "ms");
+	g_free (benchmark);
+}
+
+static void
+bench_tree (const char *tree,
+	    const BenchTreeSpec *spec)
+{
+	OperationRun run;
+	GFile *base, *source, *copies, *moved, *copy;
+	GList *files;
+	char *path, *source_path, *uri;
+	goffset total_size;
+	int n_items;
+	gint64 start;
+
+	path = bench_make_temp_dir (base_dir_option);
+	if (path == NULL) {
+		exit (1);
+	}
+	base = g_file_new_for_path (path);
+	source = g_file_get_child (base, tree);
+	copies = g_file_get_child (base, "copies");
+	moved = g_file_get_child (base, "moved");
+	copy = g_file_get_child (copies, tree);
+
+	g_file_make_directory (source, NULL, NULL);
+	g_file_make_directory (copies, NULL, NULL);
+	g_file_make_directory (moved, NULL, NULL);
+
+	start = bench_now ();
+	source_path = g_file_get_path (source);
+	n_items = bench_make_tree (source_path, spec, &total_size);
+	g_free (source_path);
+	if (n_items < 0) {
+		bench_remove_tree (path);
+		exit (1);
+	}
+	g_printerr ("Made %d items in %s in %.0f ms\n", n_items, path, bench_elapsed_ms (start));
+
+	files = g_list_prepend (NULL, source);
+
+	run_start (&run, "copy", tree, n_items, total_size);
+	nautilus_file_operations_copy (files, NULL, copies, NULL, copy_done, &run);
+	run_finish (&run);
+
+	run_start (&run, "duplicate", tree, n_items, total_size);
+	nautilus_file_operations_duplicate (files, NULL, NULL, copy_done, &run);
+	run_finish (&run);
+
+	/* Within the same file system, so this is a rename. */
+	files->data = copy;
+	run_start (&run, "move", tree, n_items, 0);
+	nautilus_file_operations_move (files, NULL, moved, NULL, copy_done, &run);
+	run_finish (&run);
+	g_object_unref (copy);
+	copy = g_file_get_child (moved, tree);
+
+	uri = g_file_get_uri (copy);
+	run_start (&run, "set_permissions", tree, n_items, 0);
+	nautilus_file_set_permissions_recursive (uri, 0600, 0777, 0700, 0777, op_done, &run);
+	run_finish (&run);
+	g_free (uri);
+
+	files->data = copy;
+	run_start (&run, "delete", tree, n_items, 0);
+	nautilus_file_operations_delete (files, NULL, delete_done, &run);
+	run_finish (&run);
+
+	if (trash_option) {
+		files->data = source;
+		run_start (&run, "trash", tree, n_items, 0);
+		nautilus_file_operations_trash_or_delete (files, NULL, delete_done, &run);
+		run_finish (&run);
+	}
+
+	g_list_free (files);
+	g_object_unref (copy);
+	g_object_unref (moved);
+	g_object_unref (copies);
+	g_object_unref (source);
+	g_object_unref (base);
+
+	bench_remove_tree (path);
+	g_free (path);
+}
+
+int
+main (int argc, char *argv[])
+{
+	GOptionContext *context;
+	GError *error;
+	NautilusProgressInfoManager *manager;
+	GSettings *settings;
+	BenchTreeSpec spec;
+
+	g_thread_init (NULL);
+
+	/* Don't ask before deleting, without touching the user's settings. */
+	g_setenv ("GSETTINGS_BACKEND", "memory", TRUE);
+
+	context = g_option_context_new ("- time copying, moving and deleting files");
+	g_option_context_add_main_entries (context, options, NULL);
+	error = NULL;
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		return 1;
+	}
+	g_option_context_free (context);
+
+	/* Only error dialogs would be shown, so try without a display too. */
+	gtk_init_check (&argc, &argv);
+
+	settings = g_settings_new ("org.gnome.nautilus.preferences");
+	g_settings_set_boolean (settings, NAUTILUS_PREFERENCES_CONFIRM_TRASH, FALSE);
+
+	manager = nautilus_progress_info_manager_new ();
+	g_signal_connect (manager, "new-progress-info",
+			  G_CALLBACK (new_progress_info_cb), NULL);
+
+	memset (&spec, 0, sizeof (spec));
+	spec.n_files = small_files_option;
+	spec.files_per_dir = 500;
+	spec.file_size = 4096;
+	spec.hardlink_percent = 2;
+	bench_tree ("small", &spec);
+
+	memset (&spec, 0, sizeof (spec));
+	spec.n_files = 4;
+	spec.file_size = (gsize) large_file_mb_option * 1024 * 1024;
+	bench_tree ("large", &spec);
+
+	memset (&spec, 0, sizeof (spec));
+	spec.n_files = 1000;
+	spec.files_per_dir = 10;
+	spec.nested = TRUE;
+	spec.file_size = 1024;
+	bench_tree ("deep", &spec);
+
+	g_object_unref (manager);
+	g_object_unref (settings);
+
+	return 0;
+}
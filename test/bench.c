@@ -0,0 +1,242 @@
+#include "bench.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+
+/* A mix of types, so sorting by type and mime lookups have something
+ * to do. The empty one leaves the type to content sniffing.
+ */
+static const char *extensions[] = {
+	".txt", ".c", ".h", ".png", ".jpg", ".pdf", ".tar.gz", ".mp3", ".odt", ""
+};
+
+static const int name_lengths[] = { 4, 12, 40, 120 };
+
+gint64
+bench_now (void)
+{
+	return g_get_monotonic_time ();
+}
+
+double
+bench_elapsed_ms (gint64 start)
+{
+	return (bench_now () - start) / 1000.0;
+}
+
+void
+bench_report (const char *benchmark,
+	      const char *metric,
+	      int n_files,
+	      double value,
+	      const char *unit)
+{
+	g_print ("{\"benchmark\":\"%s\",\"metric\":\"%s\",\"files\":%d,\"value\":%.3f,\"unit\":\"%s\"}\n",
+		 benchmark, metric, n_files, value, unit);
+}
+
+char *
+bench_make_temp_dir (const char *base_dir)
+{
+	char *template, *path;
+
+	template = g_build_filename (base_dir != NULL ? base_dir : g_get_tmp_dir (),
+				     "nautilus-bench-XXXXXX", NULL);
+	path = mkdtemp (template);
+	if (path == NULL) {
+		g_printerr ("Could not make a directory in %s: %s\n",
+			    base_dir != NULL ? base_dir : g_get_tmp_dir (),
+			    g_strerror (errno));
+		g_free (template);
+		return NULL;
+	}
+
+	return path;
+}
+
+static char *
+make_name (GRand *rand, int index)
+{
+	GString *name;
+	int length, i;
+
+	name = g_string_new (NULL);
+	g_string_printf (name, "%07d-", index);
+
+	length = name_lengths[g_rand_int_range (rand, 0, G_N_ELEMENTS (name_lengths))];
+	for (i = 0; i < length; i++) {
+		g_string_append_c (name, 'a' + g_rand_int_range (rand, 0, 26));
+	}
+	g_string_append (name, extensions[g_rand_int_range (rand, 0, G_N_ELEMENTS (extensions))]);
+
+	return g_string_free (name, FALSE);
+}
+
+static gboolean
+write_file (const char *path, const char *data, gsize size)
+{
+	int fd;
+	gssize written;
+	gsize left;
+
+	fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return FALSE;
+	}
+
+	left = size;
+	while (left > 0) {
+		written = write (fd, data, MIN (left, 64 * 1024));
+		if (written <= 0) {
+			close (fd);
+			return FALSE;
+		}
+		left -= written;
+	}
+
+	return close (fd) == 0;
+}
+
+/* Makes spec->n_files items below path, in subdirectories of
+ * spec->files_per_dir items each if that isn't 0, nested in each other
+ * if spec->nested is set. The names, sizes
+ * and links only depend on the spec, so runs are comparable.
+ * Returns the number of files and directories made, or -1.
+ */
+int
+bench_make_tree (const char *path,
+		 const BenchTreeSpec *spec,
+		 goffset *total_size)
+{
+	GRand *rand;
+	char *data, *dir, *parent, *name, *file_path, *last_path;
+	gsize size, last_size;
+	int i, n_made;
+
+	rand = g_rand_new_with_seed (spec->n_files);
+	data = g_malloc (MIN (spec->file_size, 64 * 1024) + 1);
+	memset (data, 'x', MIN (spec->file_size, 64 * 1024));
+
+	n_made = 0;
+	if (total_size != NULL) {
+		*total_size = 0;
+	}
+	dir = g_strdup (path);
+	last_path = NULL;
+	last_size = 0;
+	for (i = 0; i < spec->n_files; i++) {
+		if (spec->files_per_dir > 0 && i % spec->files_per_dir == 0) {
+			name = g_strdup_printf ("dir-%05d", i / spec->files_per_dir);
+			parent = dir;
+			dir = g_build_filename (spec->nested ? parent : path, name, NULL);
+			g_free (parent);
+			g_free (name);
+			if (g_mkdir (dir, 0755) != 0) {
+				goto failed;
+			}
+			n_made++;
+		}
+
+		name = make_name (rand, i);
+		file_path = g_build_filename (dir, name, NULL);
+		g_free (name);
+
+		if (g_rand_int_range (rand, 0, 100) < spec->subdir_percent) {
+			if (g_mkdir (file_path, 0755) != 0) {
+				g_free (file_path);
+				goto failed;
+			}
+			g_free (file_path);
+			n_made++;
+			continue;
+		}
+
+		size = 0;
+		if (last_path != NULL &&
+		    g_rand_int_range (rand, 0, 100) < spec->hardlink_percent) {
+			if (link (last_path, file_path) != 0) {
+				g_free (file_path);
+				goto failed;
+			}
+			/* Copies see a link as a file of its own */
+			size = last_size;
+		} else {
+			if (spec->file_size > 0) {
+				size = g_rand_int_range (rand, 0, spec->file_size + 1);
+			}
+			if (!write_file (file_path, data, size)) {
+				g_free (file_path);
+				goto failed;
+			}
+		}
+		if (total_size != NULL) {
+			*total_size += size;
+		}
+		n_made++;
+
+		g_free (last_path);
+		last_path = file_path;
+		last_size = size;
+	}
+
+	g_free (last_path);
+	g_free (dir);
+	g_free (data);
+	g_rand_free (rand);
+	return n_made;
+
+ failed:
+	g_printerr ("Could not make the test tree in %s: %s\n", path, g_strerror (errno));
+	g_free (last_path);
+	g_free (dir);
+	g_free (data);
+	g_rand_free (rand);
+	return -1;
+}
+
+static gboolean
+remove_tree (const char *path)
+{
+	GDir *dir;
+	const char *name;
+	char *child;
+	gboolean success;
+
+	success = TRUE;
+	if (g_file_test (path, G_FILE_TEST_IS_DIR) &&
+	    !g_file_test (path, G_FILE_TEST_IS_SYMLINK)) {
+		dir = g_dir_open (path, 0, NULL);
+		if (dir == NULL) {
+			return FALSE;
+		}
+		while ((name = g_dir_read_name (dir)) != NULL) {
+			child = g_build_filename (path, name, NULL);
+			success = remove_tree (child) && success;
+			g_free (child);
+		}
+		g_dir_close (dir);
+	}
+
+	return g_remove (path) == 0 && success;
+}
+
+void
+bench_remove_tree (const char *path)
+{
+	if (!remove_tree (path)) {
+		g_printerr ("Could not remove %s\n", path);
+	}
+}
+
+void
+bench_wait_for (gboolean *done)
+{
+	while (!*done) {
+		g_main_context_iteration (NULL, TRUE);
+	}
+}
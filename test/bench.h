@@ -0,0 +1,38 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <config.h>
+#include <glib.h>
+
+/* Helpers shared by the bench-* programs that "make bench" runs.
+ *
+ * Results are printed to stdout one per line as JSON objects, so runs
+ * can be collected and compared; everything else goes to stderr.
+ */
+
+typedef struct {
+	int n_files;
+	int files_per_dir;	/* 0 puts all files in one directory */
+	gboolean nested;	/* each of those directories in the one before */
+	gsize file_size;	/* largest file, sizes are spread up to it */
+	int hardlink_percent;	/* share of files that are hard links */
+	int subdir_percent;	/* share of empty subdirectories */
+} BenchTreeSpec;
+
+gint64  bench_now             (void);
+double  bench_elapsed_ms      (gint64               start);
+void    bench_report          (const char          *benchmark,
+			       const char          *metric,
+			       int                  n_files,
+			       double               value,
+			       const char          *unit);
+
+char   *bench_make_temp_dir   (const char          *base_dir);
+int     bench_make_tree       (const char          *path,
+			       const BenchTreeSpec *spec,
+			       goffset             *total_size);
+void    bench_remove_tree     (const char          *path);
+
+void    bench_wait_for        (gboolean            *done);
+
+#endif /* BENCH_H */
@@ -0,0 +1,318 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+
+/* Checks the pixbuf effects in eel-graphic-effects.c against the old
+ * byte-at-a-time versions and compares their throughput.
+ *
+ *	test-eel-pixbuf-effects [iterations]
+ */
+
+#include <config.h>
+
+#include <gtk/gtk.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <eel/eel-glib-extensions.h>
+#include <eel/eel-graphic-effects.h>
+
+typedef GdkPixbuf * (* EffectFunc) (GdkPixbuf *src);
+
+static GdkRGBA highlight_color = { 0.29, 0.56, 0.85, 1.0 };
+
+/* The darken parameters of the run in progress, 0-255 each */
+static int darken_saturation;
+static int darken_amount;
+
+/* The reference versions, as they were before the row kernels. */
+
+static guchar
+lighten_component (guchar cur_value)
+{
+	int new_value = cur_value;
+	new_value += 24 + (new_value >> 3);
+	if (new_value > 255) {
+		new_value = 255;
+	}
+	return (guchar) new_value;
+}
+
+static GdkPixbuf *
+reference_spotlight (GdkPixbuf *src)
+{
+	GdkPixbuf *dest;
+	int i, j;
+	int width, height, has_alpha, src_row_stride, dst_row_stride;
+	guchar *target_pixels, *original_pixels;
+	guchar *pixsrc, *pixdest;
+
+	dest = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
+			       gdk_pixbuf_get_has_alpha (src), 8,
+			       gdk_pixbuf_get_width (src),
+			       gdk_pixbuf_get_height (src));
+
+	has_alpha = gdk_pixbuf_get_has_alpha (src);
+	width = gdk_pixbuf_get_width (src);
+	height = gdk_pixbuf_get_height (src);
+	dst_row_stride = gdk_pixbuf_get_rowstride (dest);
+	src_row_stride = gdk_pixbuf_get_rowstride (src);
+	target_pixels = gdk_pixbuf_get_pixels (dest);
+	original_pixels = gdk_pixbuf_get_pixels (src);
+
+	for (i = 0; i < height; i++) {
+		pixdest = target_pixels + i * dst_row_stride;
+		pixsrc = original_pixels + i * src_row_stride;
+		for (j = 0; j < width; j++) {
+			*pixdest++ = lighten_component (*pixsrc++);
+			*pixdest++ = lighten_component (*pixsrc++);
+			*pixdest++ = lighten_component (*pixsrc++);
+			if (has_alpha) {
+				*pixdest++ = *pixsrc++;
+			}
+		}
+	}
+	return dest;
+}
+
+static GdkPixbuf *
+reference_colorize (GdkPixbuf *src)
+{
+	int i, j;
+	int width, height, has_alpha, src_row_stride, dst_row_stride;
+	guchar *target_pixels;
+	guchar *original_pixels;
+	guchar *pixsrc;
+	guchar *pixdest;
+	GdkPixbuf *dest;
+	gint red_value, green_value, blue_value;
+
+	red_value = eel_round (highlight_color.red * 255);
+	green_value = eel_round (highlight_color.green * 255);
+	blue_value = eel_round (highlight_color.blue * 255);
+
+	dest = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
+			       gdk_pixbuf_get_has_alpha (src), 8,
+			       gdk_pixbuf_get_width (src),
+			       gdk_pixbuf_get_height (src));
+
+	has_alpha = gdk_pixbuf_get_has_alpha (src);
+	width = gdk_pixbuf_get_width (src);
+	height = gdk_pixbuf_get_height (src);
+	src_row_stride = gdk_pixbuf_get_rowstride (src);
+	dst_row_stride = gdk_pixbuf_get_rowstride (dest);
+	target_pixels = gdk_pixbuf_get_pixels (dest);
+	original_pixels = gdk_pixbuf_get_pixels (src);
+
+	for (i = 0; i < height; i++) {
+		pixdest = target_pixels + i*dst_row_stride;
+		pixsrc = original_pixels + i*src_row_stride;
+		for (j = 0; j < width; j++) {
+			*pixdest++ = (*pixsrc++ * red_value) >> 8;
+			*pixdest++ = (*pixsrc++ * green_value) >> 8;
+			*pixdest++ = (*pixsrc++ * blue_value) >> 8;
+			if (has_alpha) {
+				*pixdest++ = *pixsrc++;
+			}
+		}
+	}
+	return dest;
+}
+
+static GdkPixbuf *
+reference_darken (GdkPixbuf *src)
+{
+	int i, j;
+	int width, height, has_alpha, src_row_stride, dst_row_stride;
+	guchar *target_pixels, *original_pixels;
+	guchar *pixsrc, *pixdest;
+	guchar intensity;
+	guchar alpha;
+	guchar negalpha;
+	guchar r, g, b;
+	GdkPixbuf *dest;
+
+	dest = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
+			       gdk_pixbuf_get_has_alpha (src), 8,
+			       gdk_pixbuf_get_width (src),
+			       gdk_pixbuf_get_height (src));
+
+	has_alpha = gdk_pixbuf_get_has_alpha (src);
+	width = gdk_pixbuf_get_width (src);
+	height = gdk_pixbuf_get_height (src);
+	dst_row_stride = gdk_pixbuf_get_rowstride (dest);
+	src_row_stride = gdk_pixbuf_get_rowstride (src);
+	target_pixels = gdk_pixbuf_get_pixels (dest);
+	original_pixels = gdk_pixbuf_get_pixels (src);
+
+	for (i = 0; i < height; i++) {
+		pixdest = target_pixels + i * dst_row_stride;
+		pixsrc = original_pixels + i * src_row_stride;
+		for (j = 0; j < width; j++) {
+			r = *pixsrc++;
+			g = *pixsrc++;
+			b = *pixsrc++;
+			intensity = (r * 77 + g * 150 + b * 28) >> 8;
+			negalpha = ((255 - darken_saturation) * darken_amount) >> 8;
+			alpha = (darken_saturation * darken_amount) >> 8;
+			*pixdest++ = (negalpha * intensity + alpha * r) >> 8;
+			*pixdest++ = (negalpha * intensity + alpha * g) >> 8;
+			*pixdest++ = (negalpha * intensity + alpha * b) >> 8;
+			if (has_alpha) {
+				*pixdest++ = *pixsrc++;
+			}
+		}
+	}
+	return dest;
+}
+
+static GdkPixbuf *
+spotlight (GdkPixbuf *src)
+{
+	return eel_create_spotlight_pixbuf (src);
+}
+
+static GdkPixbuf *
+colorize (GdkPixbuf *src)
+{
+	return eel_create_colorized_pixbuf (src, &highlight_color);
+}
+
+static GdkPixbuf *
+darken (GdkPixbuf *src)
+{
+	return eel_create_darkened_pixbuf (src, darken_saturation, darken_amount);
+}
+
+static GdkPixbuf *
+cached_colorize (GdkPixbuf *src)
+{
+	return eel_get_colorized_pixbuf (src, &highlight_color);
+}
+
+static GdkPixbuf *
+create_test_pixbuf (int size, gboolean has_alpha)
+{
+	GdkPixbuf *pixbuf;
+	guchar *pixels;
+	int x, y, n_channels, row_stride;
+
+	pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, has_alpha, 8, size, size);
+	pixels = gdk_pixbuf_get_pixels (pixbuf);
+	n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+	row_stride = gdk_pixbuf_get_rowstride (pixbuf);
+
+	/* cover every byte value in every channel */
+	for (y = 0; y < size; y++) {
+		for (x = 0; x < size * n_channels; x++) {
+			pixels[y * row_stride + x] = (x * 7 + y * 13) & 0xff;
+		}
+	}
+
+	return pixbuf;
+}
+
+static gboolean
+pixbufs_equal (GdkPixbuf *a, GdkPixbuf *b)
+{
+	int y, row_bytes;
+
+	row_bytes = gdk_pixbuf_get_width (a) * gdk_pixbuf_get_n_channels (a);
+	for (y = 0; y < gdk_pixbuf_get_height (a); y++) {
+		if (memcmp (gdk_pixbuf_get_pixels (a) + y * gdk_pixbuf_get_rowstride (a),
+			    gdk_pixbuf_get_pixels (b) + y * gdk_pixbuf_get_rowstride (b),
+			    row_bytes) != 0) {
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+static double
+run_effect (EffectFunc effect, GdkPixbuf *src, int iterations)
+{
+	GdkPixbuf *dest;
+	gint64 start;
+	int i;
+
+	start = g_get_monotonic_time ();
+	for (i = 0; i < iterations; i++) {
+		dest = (* effect) (src);
+		g_object_unref (dest);
+	}
+
+	/* megapixels per second */
+	return (double) gdk_pixbuf_get_width (src) * gdk_pixbuf_get_height (src) * iterations /
+		MAX (g_get_monotonic_time () - start, 1);
+}
+
+static gboolean
+compare_effect (const char *name,
+		EffectFunc reference,
+		EffectFunc effect,
+		GdkPixbuf *src,
+		int iterations)
+{
+	GdkPixbuf *expected, *result;
+	gboolean equal;
+
+	expected = (* reference) (src);
+	result = (* effect) (src);
+	equal = pixbufs_equal (expected, result);
+	g_object_unref (expected);
+	g_object_unref (result);
+
+	g_print ("%-10s %3dx%-3d %-5s %s  reference %8.1f Mpx/s  new %8.1f Mpx/s\n",
+		 name,
+		 gdk_pixbuf_get_width (src), gdk_pixbuf_get_height (src),
+		 gdk_pixbuf_get_has_alpha (src) ? "rgba" : "rgb",
+		 equal ? "ok  " : "DIFF",
+		 run_effect (reference, src, iterations),
+		 run_effect (effect, src, iterations));
+
+	return equal;
+}
+
+int
+main (int argc, char *argv[])
+{
+	static const int sizes[] = { 16, 33, 48, 128, 256 };
+	/* saturation, darken */
+	static const int darken_params[][2] = { { 204, 204 }, { 0, 255 }, { 255, 128 } };
+	GdkPixbuf *src;
+	gboolean ok;
+	guint i, j;
+	int iterations, has_alpha;
+
+	g_type_init ();
+
+	iterations = argc > 1 ? atoi (argv[1]) : 200;
+	if (iterations <= 0) {
+		iterations = 200;
+	}
+
+	ok = TRUE;
+	for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+		for (has_alpha = 1; has_alpha >= 0; has_alpha--) {
+			src = create_test_pixbuf (sizes[i], has_alpha);
+
+			ok &= compare_effect ("spotlight", reference_spotlight, spotlight,
+					      src, iterations);
+			ok &= compare_effect ("colorize", reference_colorize, colorize,
+					      src, iterations);
+			for (j = 0; j < G_N_ELEMENTS (darken_params); j++) {
+				darken_saturation = darken_params[j][0];
+				darken_amount = darken_params[j][1];
+				ok &= compare_effect ("darken", reference_darken, darken,
+						      src, iterations);
+			}
+
+			g_object_unref (src);
+		}
+	}
+
+	src = create_test_pixbuf (48, TRUE);
+	g_print ("cached colorize 48x48 rgba: %.1f Mpx/s\n",
+		 run_effect (cached_colorize, src, iterations));
+	g_object_unref (src);
+
+	return ok ? 0 : 1;
+}
@@ -6,7 +6,7 @@ hits_added_cb (NautilusSearchEngine *engine, GSList *hits)
 {      
 	g_print ("hits added\n");
 	while (hits) {
-		g_print (" - %s\n", (char *)hits->data);
+		g_print (" - %s\n", ((NautilusSearchHit *)hits->data)->uri);
 		hits = hits->next;
 	}
 }